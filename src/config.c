@@ -12,7 +12,7 @@
  *		on Windows XP, possibly Vista and several UNIX systems.
  *		Use the -DANSI_CFG for use on these systems.
  *
- * Version:	@(#)config.c	1.0.56	2021/03/23
+ * Version:	@(#)config.c	1.0.59	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -74,7 +74,7 @@
 #include "devices/network/network.h"
 #include "devices/sound/sound.h"
 #include "devices/sound/midi.h"
-#include "devices/sound/sound.h"
+#include "devices/sound/snd_resamp.h"
 #include "devices/video/video.h"
 #include "ui/ui.h"
 #include "plat.h"
@@ -287,6 +287,10 @@ load_general(config_t *cfg, const char *cat)
     cfg->vid_grayscale = config_get_int(cat, "video_grayscale", 0);
     cfg->vid_graytype = config_get_int(cat, "video_graytype", 0);
 
+    cfg->vid_frameskip = config_get_int(cat, "video_frameskip", 0);
+    cfg->vid_maxfps = config_get_int(cat, "video_maxfps", 0);
+    cfg->vid_watched = !!config_get_int(cat, "video_watched", 0);
+
     cfg->window_remember = config_get_int(cat, "window_remember", 0);
     if (cfg->window_remember) {
 	p = config_get_string(cat, "window_coordinates", "0, 0, 0, 0");
@@ -381,6 +385,21 @@ save_general(const config_t *cfg, const char *cat)
     else
 	config_set_int(cat, "video_graytype", cfg->vid_graytype);
 
+    if (cfg->vid_frameskip == 0)
+	config_delete_var(cat, "video_frameskip");
+    else
+	config_set_int(cat, "video_frameskip", cfg->vid_frameskip);
+
+    if (cfg->vid_maxfps == 0)
+	config_delete_var(cat, "video_maxfps");
+    else
+	config_set_int(cat, "video_maxfps", cfg->vid_maxfps);
+
+    if (cfg->vid_watched == 0)
+	config_delete_var(cat, "video_watched");
+    else
+	config_set_int(cat, "video_watched", cfg->vid_watched);
+
     if (cfg->window_remember) {
 	config_set_int(cat, "window_remember", cfg->window_remember);
 
@@ -621,6 +640,9 @@ load_sound(config_t *cfg, const char *cat)
     else
 	cfg->sound_is_float = 0;
 
+    cfg->sound_quality = config_get_int(cat, "sound_quality", RESAMP_CUBIC);
+    cfg->sound_trace = !!config_get_int(cat, "sound_trace", 0);
+
     if (machine_get_flags_fixed() & MACHINE_SOUND) {
 	config_delete_var(cat, "sound_card");
 	cfg->sound_card = SOUND_INTERNAL;
@@ -651,6 +673,16 @@ save_sound(const config_t *cfg, const char *cat)
     else
 	config_set_string(cat, "sound_type", (cfg->sound_is_float == 1) ? "float" : "int16");
 
+    if (cfg->sound_quality == RESAMP_CUBIC)
+	config_delete_var(cat, "sound_quality");
+    else
+	config_set_int(cat, "sound_quality", cfg->sound_quality);
+
+    if (cfg->sound_trace == 0)
+	config_delete_var(cat, "sound_trace");
+    else
+	config_set_int(cat, "sound_trace", cfg->sound_trace);
+
     if (cfg->sound_card == SOUND_NONE)
 	config_delete_var(cat, "sound_card");
     else
@@ -2128,6 +2160,8 @@ config_init(config_t *cfg)
 
     cfg->sound_is_float = 1;			// sound uses FP values
     cfg->sound_gain = 0;			// sound volume gain
+    cfg->sound_quality = RESAMP_CUBIC;		// resampler quality
+    cfg->sound_trace = 0;			// write sound trace file
     cfg->sound_card = SOUND_NONE;		// selected sound card
     cfg->mpu401_standalone_enable = 0;		// sound option
     cfg->midi_device = 0;			// selected midi device
@@ -8,7 +8,7 @@
  *
  *		Configuration file handler header.
  *
- * Version:	@(#)config.h	1.0.9	2021/03/20
+ * Version:	@(#)config.h	1.0.12	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -90,13 +90,18 @@ typedef struct {
 		vid_graytype,			/* video */
 		invert_display,			/* invert the display */
 		enable_overscan,		/* enable overscans */
-		force_43;			/* video */
+		force_43,			/* video */
+		vid_frameskip,			/* draw one in N frames */
+		vid_maxfps,			/* max frames shown per sec */
+		vid_watched;			/* only draw when watched */
 
     int		mouse_type;			/* selected mouse type */
     int		joystick_type;			/* joystick type */
 
     int		sound_is_float,			/* sound uses FP values */
 		sound_gain,			/* sound volume gain */
+		sound_quality,			/* resampler quality */
+		sound_trace,			/* write sound trace file */
 		sound_card,			/* selected sound card */
 		mpu401_standalone_enable,	/* sound option */
 		midi_device;			/* selected midi device */
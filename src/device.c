@@ -11,7 +11,7 @@
  *
  * **TODO**	Merge the various 'add' variants, its getting too messy.
  *
- * Version:	@(#)device.c	1.0.30	2021/03/16
+ * Version:	@(#)device.c	1.0.31	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -435,6 +435,17 @@ device_get_priv(const device_t *d)
 }
 
 
+/* Return the name of the device currently being initialized, if any. */
+const char *
+device_get_current_name(void)
+{
+    if (device_current == NULL)
+	return(NULL);
+
+    return(device_current->name);
+}
+
+
 /* Return name of the bus required by this device. */
 const char *
 device_get_bus_name(const device_t *d)
@@ -8,7 +8,7 @@
  *
  *		Definitions for the device handler.
  *
- * Version:	@(#)device.h	1.0.16	2021/03/16
+ * Version:	@(#)device.h	1.0.17	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -142,6 +142,7 @@ extern void		device_remove(const device_t *, priv_t);
 extern void		device_close_all(void);
 extern void		device_reset_all(int flags);
 extern priv_t		device_get_priv(const device_t *);
+extern const char	*device_get_current_name(void);
 extern const char	*device_get_bus_name(const device_t *);
 extern int		device_available(const device_t *);
 extern void		device_speed_changed(void);
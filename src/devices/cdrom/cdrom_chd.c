@@ -0,0 +1,561 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Handler for compressed (CHD) CD-ROM images.
+ *
+ *		CHD images store the disc as a series of compressed
+ *		"hunks", each holding a fixed number of 2448-byte CD
+ *		frames. Decompressing a hunk is by far the most costly
+ *		part of reading from such an image, so we keep a cache
+ *		of decompressed hunks which is shared by all images in
+ *		use, and run a small pool of worker threads which will
+ *		decompress the next few hunks ahead of the reader when
+ *		it is reading sequentially.
+ *
+ *		Since libchdr handles are not thread-safe, every image
+ *		is opened once for the foreground (reader) and once for
+ *		each of the workers, so they can all decompress at the
+ *		same time.
+ *
+ * Version:	@(#)cdrom_chd.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <chd.h>
+#include "../../emu.h"
+#include "../../plat.h"
+#include "cdrom.h"
+#include "cdrom_chd.h"
+
+
+#define CHD_WORKERS	2		/* number of decompressor threads */
+#define CHD_CACHE_HUNKS	128		/* size of the shared hunk cache */
+#define CHD_PREFETCH	4		/* hunks to read ahead */
+
+#ifndef CDROM_TRACK_METADATA_TAG
+# define CDROM_TRACK_METADATA_TAG	0x43485452	/* 'CHTR' */
+#endif
+#ifndef CDROM_TRACK_METADATA2_TAG
+# define CDROM_TRACK_METADATA2_TAG	0x43485432	/* 'CHT2' */
+#endif
+
+#define HUNK_NONE	0xffffffff
+
+
+enum {
+    HUNK_FREE = 0,			/* slot is unused */
+    HUNK_LOADING,			/* slot owned by a worker */
+    HUNK_VALID				/* slot holds valid data */
+};
+
+typedef struct {
+    chd_image_t	*img;			/* owner of this slot */
+    uint32_t	hunk;			/* hunk number held in slot */
+    int		state;
+    uint32_t	stamp;			/* LRU time stamp */
+    uint32_t	size;			/* allocated size of buffer */
+    uint8_t	*data;
+} hunk_t;
+
+struct chd_image {
+    chd_file	*fg;			/* handle for the reader */
+    chd_file	*wk[CHD_WORKERS];	/* handles for the workers */
+
+    mutex_t	*lock;
+
+    uint32_t	hunkbytes,
+		totalhunks;
+
+    uint32_t	cur_hunk;		/* hunk currently in cur_data */
+    uint8_t	*cur_data;
+};
+
+
+static hunk_t		hunks[CHD_CACHE_HUNKS];
+static int		queue[CHD_CACHE_HUNKS + 1];
+static int		queue_head,
+			queue_tail;
+static uint32_t		cache_stamp;
+static mutex_t		*cache_lock;
+static event_t		*work_event;
+static thread_t		*workers[CHD_WORKERS];
+static volatile int	workers_quit;
+static int		users;
+
+
+/* Find a hunk in the cache. Must be called with the cache locked. */
+static int
+cache_find(chd_image_t *img, uint32_t hunk)
+{
+    int i;
+
+    for (i = 0; i < CHD_CACHE_HUNKS; i++) {
+	if ((hunks[i].state != HUNK_FREE) &&
+	    (hunks[i].img == img) && (hunks[i].hunk == hunk)) return(i);
+    }
+
+    return(-1);
+}
+
+
+/* Grab a slot in the cache. Must be called with the cache locked. */
+static int
+cache_claim(chd_image_t *img, uint32_t hunk, int state)
+{
+    uint32_t oldest = 0xffffffff;
+    int i, slot = -1;
+
+    for (i = 0; i < CHD_CACHE_HUNKS; i++) {
+	if (hunks[i].state == HUNK_FREE) {
+		slot = i;
+		break;
+	}
+
+	/* Never steal a slot from a worker. */
+	if ((hunks[i].state == HUNK_VALID) && (hunks[i].stamp < oldest)) {
+		oldest = hunks[i].stamp;
+		slot = i;
+	}
+    }
+
+    if (slot < 0) return(-1);
+
+    if (hunks[slot].size < img->hunkbytes) {
+	if (hunks[slot].data != NULL)
+		free(hunks[slot].data);
+	hunks[slot].data = (uint8_t *)mem_alloc(img->hunkbytes);
+	hunks[slot].size = img->hunkbytes;
+    }
+
+    hunks[slot].img = img;
+    hunks[slot].hunk = hunk;
+    hunks[slot].state = state;
+    hunks[slot].stamp = ++cache_stamp;
+
+    return(slot);
+}
+
+
+/* Decompressor thread. */
+static void
+chd_worker(void *priv)
+{
+    int n = (int)(intptr_t)priv;
+    hunk_t *h;
+    int more, ok;
+
+    for (;;) {
+	thread_wait_event(work_event, -1);
+
+	/* The event wakes only one of us, so pass it on. */
+	if (workers_quit) {
+		thread_set_event(work_event);
+		break;
+	}
+
+	for (;;) {
+		thread_wait_mutex(cache_lock);
+		if (queue_head == queue_tail) {
+			thread_release_mutex(cache_lock);
+			break;
+		}
+		h = &hunks[queue[queue_tail]];
+		queue_tail = (queue_tail + 1) % (CHD_CACHE_HUNKS + 1);
+		more = (queue_head != queue_tail);
+		thread_release_mutex(cache_lock);
+
+		/* Let another worker help out with the rest. */
+		if (more)
+			thread_set_event(work_event);
+
+		ok = (chd_read_hunk(h->img->wk[n], h->hunk, h->data) == CHDERR_NONE);
+
+		thread_wait_mutex(cache_lock);
+		if (ok) {
+			h->state = HUNK_VALID;
+			h->stamp = ++cache_stamp;
+		} else {
+			h->state = HUNK_FREE;
+			h->img = NULL;
+		}
+		thread_release_mutex(cache_lock);
+	}
+    }
+}
+
+
+/* Queue the next few hunks for decompression by the workers. */
+static void
+chd_prefetch(chd_image_t *img, uint32_t hunk)
+{
+    int i, slot, queued = 0;
+
+    thread_wait_mutex(cache_lock);
+
+    for (i = 0; i < CHD_PREFETCH; i++, hunk++) {
+	if (hunk >= img->totalhunks) break;
+
+	if (cache_find(img, hunk) >= 0) continue;
+
+	slot = cache_claim(img, hunk, HUNK_LOADING);
+	if (slot < 0) break;
+
+	queue[queue_head] = slot;
+	queue_head = (queue_head + 1) % (CHD_CACHE_HUNKS + 1);
+	queued++;
+    }
+
+    thread_release_mutex(cache_lock);
+
+    if (queued)
+	thread_set_event(work_event);
+}
+
+
+/* Make the requested hunk the current one. */
+static int
+hunk_load(chd_image_t *img, uint32_t hunk)
+{
+    int found = 0;
+    int seq, slot;
+
+    if (hunk == img->cur_hunk) return(1);
+
+    seq = (img->cur_hunk != HUNK_NONE) && (hunk == (img->cur_hunk + 1));
+
+    thread_wait_mutex(cache_lock);
+    slot = cache_find(img, hunk);
+    if ((slot >= 0) && (hunks[slot].state == HUNK_VALID)) {
+	memcpy(img->cur_data, hunks[slot].data, img->hunkbytes);
+	hunks[slot].stamp = ++cache_stamp;
+	found = 1;
+    }
+    thread_release_mutex(cache_lock);
+
+    if (! found) {
+	/*
+	 * Not in the cache (or a worker is still busy with it,
+	 * in which case we do not want to wait for it), so we
+	 * decompress it ourselves.
+	 */
+	if (chd_read_hunk(img->fg, hunk, img->cur_data) != CHDERR_NONE) {
+		ERRLOG("CHD: unable to read hunk %lu\n", hunk);
+		img->cur_hunk = HUNK_NONE;
+		return(0);
+	}
+
+	thread_wait_mutex(cache_lock);
+	if (cache_find(img, hunk) < 0) {
+		slot = cache_claim(img, hunk, HUNK_VALID);
+		if (slot >= 0)
+			memcpy(hunks[slot].data, img->cur_data, img->hunkbytes);
+	}
+	thread_release_mutex(cache_lock);
+    }
+
+    img->cur_hunk = hunk;
+
+    /* If we are reading sequentially, read ahead. */
+    if (seq)
+	chd_prefetch(img, hunk + 1);
+
+    return(1);
+}
+
+
+static void
+cache_init(void)
+{
+    int i;
+
+    if (users++ > 0) return;
+
+    memset(hunks, 0x00, sizeof(hunks));
+    queue_head = queue_tail = 0;
+    cache_stamp = 0;
+
+    cache_lock = thread_create_mutex(NULL);
+    work_event = thread_create_event();
+
+    workers_quit = 0;
+    for (i = 0; i < CHD_WORKERS; i++)
+	workers[i] = thread_create(chd_worker, (void *)(intptr_t)i);
+
+    DEBUG("CHD: cache initialized, %i workers\n", CHD_WORKERS);
+}
+
+
+static void
+cache_close(void)
+{
+    int i;
+
+    if (--users > 0) return;
+
+    workers_quit = 1;
+    thread_set_event(work_event);
+    for (i = 0; i < CHD_WORKERS; i++) {
+	thread_wait(workers[i], -1);
+	workers[i] = NULL;
+    }
+
+    thread_destroy_event(work_event);
+    work_event = NULL;
+    thread_close_mutex(cache_lock);
+    cache_lock = NULL;
+
+    for (i = 0; i < CHD_CACHE_HUNKS; i++) {
+	if (hunks[i].data != NULL)
+		free(hunks[i].data);
+    }
+    memset(hunks, 0x00, sizeof(hunks));
+
+    DEBUG("CHD: cache closed\n");
+}
+
+
+/* Remove all traces of an image from the cache. */
+static void
+cache_flush(chd_image_t *img)
+{
+    int i, j, busy;
+
+    thread_wait_mutex(cache_lock);
+
+    /* Drop any of its requests still waiting in the queue. */
+    j = queue_tail;
+    i = queue_tail;
+    while (i != queue_head) {
+	if (hunks[queue[i]].img == img) {
+		hunks[queue[i]].state = HUNK_FREE;
+		hunks[queue[i]].img = NULL;
+	} else {
+		queue[j] = queue[i];
+		j = (j + 1) % (CHD_CACHE_HUNKS + 1);
+	}
+	i = (i + 1) % (CHD_CACHE_HUNKS + 1);
+    }
+    queue_head = j;
+
+    /* Wait for the workers to finish what they are doing for us. */
+    for (;;) {
+	busy = 0;
+	for (i = 0; i < CHD_CACHE_HUNKS; i++) {
+		if ((hunks[i].img == img) && (hunks[i].state == HUNK_LOADING))
+			busy++;
+	}
+	if (! busy) break;
+
+	thread_release_mutex(cache_lock);
+	plat_delay_ms(1);
+	thread_wait_mutex(cache_lock);
+    }
+
+    for (i = 0; i < CHD_CACHE_HUNKS; i++) {
+	if (hunks[i].img == img) {
+		hunks[i].state = HUNK_FREE;
+		hunks[i].img = NULL;
+	}
+    }
+
+    thread_release_mutex(cache_lock);
+}
+
+
+chd_image_t *
+chd_image_open(const wchar_t *fn)
+{
+    char temp[1024];
+    const chd_header *hdr;
+    chd_image_t *img;
+    int i;
+
+    wcstombs(temp, fn, sizeof(temp));
+
+    img = (chd_image_t *)mem_alloc(sizeof(chd_image_t));
+    memset(img, 0x00, sizeof(chd_image_t));
+
+    if (chd_open(temp, CHD_OPEN_READ, NULL, &img->fg) != CHDERR_NONE) {
+	ERRLOG("CHD: unable to open '%ls'\n", fn);
+	free(img);
+	return(NULL);
+    }
+
+    hdr = chd_get_header(img->fg);
+    if ((hdr == NULL) || (hdr->unitbytes != CHD_FRAME_SIZE) ||
+	(hdr->hunkbytes % CHD_FRAME_SIZE)) {
+	ERRLOG("CHD: '%ls' is not a CD-ROM image\n", fn);
+	chd_close(img->fg);
+	free(img);
+	return(NULL);
+    }
+    img->hunkbytes = hdr->hunkbytes;
+    img->totalhunks = hdr->totalhunks;
+
+    /* Open a private handle for each of the workers. */
+    for (i = 0; i < CHD_WORKERS; i++) {
+	if (chd_open(temp, CHD_OPEN_READ, NULL, &img->wk[i]) != CHDERR_NONE) {
+		ERRLOG("CHD: unable to re-open '%ls'\n", fn);
+		while (--i >= 0)
+			chd_close(img->wk[i]);
+		chd_close(img->fg);
+		free(img);
+		return(NULL);
+	}
+    }
+
+    img->lock = thread_create_mutex(NULL);
+    img->cur_data = (uint8_t *)mem_alloc(img->hunkbytes);
+    img->cur_hunk = HUNK_NONE;
+
+    cache_init();
+
+    INFO("CHD: opened '%ls', %lu hunks of %lu bytes\n",
+	 fn, img->totalhunks, img->hunkbytes);
+
+    return(img);
+}
+
+
+void
+chd_image_close(chd_image_t *img)
+{
+    int i;
+
+    if (img == NULL) return;
+
+    cache_flush(img);
+    cache_close();
+
+    for (i = 0; i < CHD_WORKERS; i++)
+	chd_close(img->wk[i]);
+    chd_close(img->fg);
+
+    thread_close_mutex(img->lock);
+    free(img->cur_data);
+    free(img);
+}
+
+
+/* Read the track layout from the image metadata. */
+int
+chd_image_tracks(chd_image_t *img, chd_track_t *trk, int max)
+{
+    char meta[256];
+    uint32_t len;
+    int i, n;
+
+    for (i = 0; i < max; i++, trk++) {
+	memset(trk, 0x00, sizeof(chd_track_t));
+	strcpy(trk->pgtype, "-");
+
+	if (chd_get_metadata(img->fg, CDROM_TRACK_METADATA2_TAG, i,
+			     meta, sizeof(meta) - 1, &len,
+			     NULL, NULL) == CHDERR_NONE) {
+		meta[len] = '\0';
+		n = sscanf(meta,
+			   "TRACK:%d TYPE:%31s SUBTYPE:%31s FRAMES:%d PREGAP:%d PGTYPE:%31s PGSUB:%*s POSTGAP:%d",
+			   &trk->number, trk->type, trk->subtype,
+			   &trk->frames, &trk->pregap, trk->pgtype,
+			   &trk->postgap);
+		if (n < 4) break;
+	} else if (chd_get_metadata(img->fg, CDROM_TRACK_METADATA_TAG, i,
+				    meta, sizeof(meta) - 1, &len,
+				    NULL, NULL) == CHDERR_NONE) {
+		meta[len] = '\0';
+		n = sscanf(meta, "TRACK:%d TYPE:%31s SUBTYPE:%31s FRAMES:%d",
+			   &trk->number, trk->type, trk->subtype,
+			   &trk->frames);
+		if (n < 4) break;
+	} else
+		break;
+
+	DEBUG("CHD: track %i, type %s, %i frames, pregap %i (%s)\n",
+	      trk->number, trk->type, trk->frames, trk->pregap, trk->pgtype);
+    }
+
+    return(i);
+}
+
+
+uint64_t
+chd_image_size(chd_image_t *img)
+{
+    return((uint64_t)img->totalhunks * img->hunkbytes);
+}
+
+
+/* Read data from the (decompressed) image. */
+int
+chd_image_read(chd_image_t *img, uint64_t offset, uint8_t *bufp, uint32_t len)
+{
+    uint32_t hunk, off, n;
+    int ret = 1;
+
+    thread_wait_mutex(img->lock);
+
+    while (len > 0) {
+	hunk = (uint32_t)(offset / img->hunkbytes);
+	off = (uint32_t)(offset % img->hunkbytes);
+
+	if ((hunk >= img->totalhunks) || !hunk_load(img, hunk)) {
+		ret = 0;
+		break;
+	}
+
+	n = img->hunkbytes - off;
+	if (n > len)
+		n = len;
+	memcpy(bufp, img->cur_data + off, n);
+
+	bufp += n;
+	offset += n;
+	len -= n;
+    }
+
+    thread_release_mutex(img->lock);
+
+    return(ret);
+}
@@ -0,0 +1,88 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Definitions for the compressed (CHD) CD-ROM image handler.
+ *
+ * Version:	@(#)cdrom_chd.h	1.0.2	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef CDROM_CHD_H
+# define CDROM_CHD_H
+
+
+#define CHD_FRAME_SIZE		2448	/* 2352 data + 96 subchannel */
+#define CHD_TRACK_PADDING	4	/* tracks padded to 4 frames */
+#define CHD_MAX_TRACKS		99
+
+
+/* Track information, as read from the image metadata. */
+typedef struct {
+    int		number;
+    char	type[32];
+    char	subtype[32];
+    char	pgtype[32];
+    int		frames;
+    int		pregap;
+    int		postgap;
+} chd_track_t;
+
+struct chd_image;
+typedef struct chd_image chd_image_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern chd_image_t	*chd_image_open(const wchar_t *fn);
+extern void		chd_image_close(chd_image_t *img);
+extern int		chd_image_tracks(chd_image_t *img,
+					 chd_track_t *trk, int max);
+extern uint64_t		chd_image_size(chd_image_t *img);
+extern int		chd_image_read(chd_image_t *img, uint64_t offset,
+				       uint8_t *bufp, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/*CDROM_CHD_H*/
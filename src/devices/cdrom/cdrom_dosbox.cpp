@@ -15,7 +15,7 @@
  * **NOTE**	This code will very soon be replaced with a C variant, so
  *		no more changes will be done.
  *
- * Version:	@(#)cdrom_dosbox.cpp	1.0.15	2019/05/17
+ * Version:	@(#)cdrom_dosbox.cpp	1.0.17	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -63,6 +63,9 @@
 #include "cdrom.h"
 #include "cdrom_image.h"
 #include "cdrom_dosbox.h"
+#ifdef USE_CHD
+# include "cdrom_chd.h"
+#endif
 
 
 using namespace std;
@@ -132,6 +135,107 @@ CDROM_Interface_Image::BinaryFile::getLength(void)
 }
 
 
+#ifdef USE_CHD
+CDROM_Interface_Image::ChdFile::ChdFile(const wchar_t *filename, bool &error)
+{
+    chd = chd_image_open(filename);
+    length = 0;
+
+    DEBUG("CDROM: chd_open(%ls) = %08lx\n", filename, chd);
+
+    if (chd == NULL)
+	error = true;
+    else
+	error = false;
+}
+
+
+CDROM_Interface_Image::ChdFile::~ChdFile(void)
+{
+    if (chd != NULL) {
+	chd_image_close(chd);
+	chd = NULL;
+    }
+    segments.clear();
+}
+
+
+/*
+ * Our tracks see the file as a flat array of sectors of their own
+ * size, but in the CHD image every sector lives in a frame of its
+ * own, with the tracks padded out to a multiple of four frames. So,
+ * we map the flat offset onto the track's segment in the image.
+ */
+void
+CDROM_Interface_Image::ChdFile::addTrack(uint64_t start, int sectorSize, uint64_t frame, uint64_t frames, bool audio)
+{
+    Segment seg;
+
+    seg.start = start;
+    seg.sectorSize = sectorSize;
+    seg.frame = frame;
+    seg.frames = frames;
+    seg.audio = audio;
+    segments.push_back(seg);
+
+    if ((start + (frames * sectorSize)) > length)
+	length = start + (frames * sectorSize);
+}
+
+
+bool
+CDROM_Interface_Image::ChdFile::read(uint8_t *buffer, uint64_t seek, size_t count)
+{
+    vector<Segment>::iterator it;
+    uint64_t rel, pos;
+    uint8_t temp;
+    size_t i;
+
+    DEBUG("CDROM: chd_read(%08lx, pos=%" PRIu64 " count=%lu\n",
+						chd, seek, count);
+    if (chd == NULL) return 0;
+
+    for (it = segments.begin(); it != segments.end(); it++) {
+	Segment &seg = *it;
+
+	if ((seek < seg.start) ||
+	    (seek >= (seg.start + (seg.frames * seg.sectorSize)))) continue;
+
+	rel = seek - seg.start;
+	pos = ((seg.frame + (rel / seg.sectorSize)) * CHD_FRAME_SIZE) +
+	      (rel % seg.sectorSize);
+	if (! chd_image_read(chd, pos, buffer, (uint32_t)count)) {
+		ERRLOG("CDROM: chd_read failed!\n");
+		return 0;
+	}
+
+	/* Audio data is stored in big-endian format. */
+	if (seg.audio) {
+		for (i = (pos & 1); (i + 1) < count; i += 2) {
+			temp = buffer[i];
+			buffer[i] = buffer[i + 1];
+			buffer[i + 1] = temp;
+		}
+	}
+
+	return 1;
+    }
+
+    /* Not part of any track (a gap), so just return silence. */
+    memset(buffer, 0x00, count);
+
+    return 1;
+}
+
+
+uint64_t
+CDROM_Interface_Image::ChdFile::getLength(void)
+{
+    return length;
+}
+#endif
+
+
 CDROM_Interface_Image::CDROM_Interface_Image(void)
 {
 }
@@ -157,6 +261,11 @@ CDROM_Interface_Image::SetDevice(const wchar_t *path, int type, int forceCD)
     if (type == IMAGE_TYPE_NONE || type == IMAGE_TYPE_CUE)
 	if (CueLoadSheet(path)) return true;
 
+#ifdef USE_CHD
+    if (type == IMAGE_TYPE_NONE || type == IMAGE_TYPE_CHD)
+	if (ChdLoadFile(path)) return true;
+#endif
+
     if (type == IMAGE_TYPE_NONE || type == IMAGE_TYPE_ISO)
 	if (IsoLoadFile(path)) return true;
 
@@ -287,13 +396,18 @@ CDROM_Interface_Image::ReadSector(uint8_t *buffer, bool raw, uint32_t sector)
 
     uint64_t s = (uint64_t) sector;	
     uint64_t seek = tracks[track].skip + ((s - tracks[track].start) * tracks[track].sectorSize);
-    if (tracks[track].mode2)
+    bool xa_cooked = tracks[track].mode2 && (tracks[track].sectorSize < 2336);
+
+    /* Cooked XA tracks only hold the user data of their form. */
+    if (xa_cooked)
+	length = (tracks[track].form == 2) ? 2324 : COOKED_SECTOR_SIZE;
+    else if (tracks[track].mode2)
 	length = (raw ? RAW_SECTOR_SIZE : 2336);
     else
 	length = (raw ? RAW_SECTOR_SIZE : COOKED_SECTOR_SIZE);
     if (tracks[track].sectorSize != RAW_SECTOR_SIZE && raw) return false;
     if (tracks[track].sectorSize == RAW_SECTOR_SIZE && !tracks[track].mode2 && !raw) seek += 16;
-    if (tracks[track].mode2 && !raw) seek += 24;
+    if (tracks[track].mode2 && !xa_cooked && !raw) seek += 24;
 
     return tracks[track].file->read(buffer, seek, length);
 }
@@ -429,6 +543,120 @@ CDROM_Interface_Image::IsoLoadFile(const wchar_t *filename)
 }
 
 
+#ifdef USE_CHD
+bool
+CDROM_Interface_Image::ChdLoadFile(const wchar_t *filename)
+{
+    Track track = {0, 0, 0, 0, 0, 0, 0, 0, false, NULL};
+    chd_track_t trk[CHD_MAX_TRACKS];
+    uint64_t lba = 0, frame = 0, skip = 0;
+    uint64_t pregap, frames;
+    ChdFile *file;
+    bool error;
+    int i, num;
+
+    tracks.clear();
+
+    file = new ChdFile(filename, error);
+    if (error) {
+	delete file;
+	return false;
+    }
+
+    num = chd_image_tracks(file->chd, trk, CHD_MAX_TRACKS);
+    if (num == 0) {
+	ERRLOG("CHD: no tracks found in '%ls'!\n", filename);
+	delete file;
+	return false;
+    }
+
+    for (i = 0; i < num; i++) {
+	track.number = i + 1;
+	track.track_number = trk[i].number;
+	track.attr = DATA_TRACK;
+	track.form = 0;
+	track.mode2 = false;
+
+	if (! strcmp(trk[i].type, "AUDIO")) {
+		track.sectorSize = RAW_SECTOR_SIZE;
+		track.attr = AUDIO_TRACK;
+	} else if (! strcmp(trk[i].type, "MODE1")) {
+		track.sectorSize = COOKED_SECTOR_SIZE;
+	} else if (! strcmp(trk[i].type, "MODE1_RAW")) {
+		track.sectorSize = RAW_SECTOR_SIZE;
+	} else if (! strcmp(trk[i].type, "MODE2") ||
+		   ! strcmp(trk[i].type, "MODE2_FORM_MIX")) {
+		track.sectorSize = 2336;
+		track.mode2 = true;
+	} else if (! strcmp(trk[i].type, "MODE2_FORM1")) {
+		track.form = 1;
+		track.sectorSize = COOKED_SECTOR_SIZE;
+		track.mode2 = true;
+	} else if (! strcmp(trk[i].type, "MODE2_FORM2")) {
+		track.form = 2;
+		track.sectorSize = 2324;
+		track.mode2 = true;
+	} else if (! strcmp(trk[i].type, "MODE2_RAW")) {
+		track.form = 1;		/* Assume this is XA Mode 2 Form 1. */
+		track.sectorSize = RAW_SECTOR_SIZE;
+		track.mode2 = true;
+	} else {
+		ERRLOG("CHD: unsupported track type '%s'!\n", trk[i].type);
+		if (tracks.empty())
+			delete file;
+		else
+			ClearTracks();
+		return false;
+	}
+
+	/* Pregap data is only present in the image for type 'V'. */
+	pregap = (trk[i].pgtype[0] == 'V') ? trk[i].pregap : 0;
+	frames = trk[i].frames - pregap;
+
+	/* Track 1 always starts at LBA 0. */
+	if (i > 0)
+		lba += trk[i].pregap;
+
+	track.start = lba;
+	track.length = frames;
+	track.skip = skip;
+	track.file = file;
+	file->addTrack(skip, track.sectorSize, frame + pregap, frames,
+		       (track.attr == AUDIO_TRACK));
+	tracks.push_back(track);
+
+	skip += frames * track.sectorSize;
+	lba += frames + trk[i].postgap;
+	frame += trk[i].frames;
+	frame += (CHD_TRACK_PADDING - (trk[i].frames % CHD_TRACK_PADDING)) %
+							CHD_TRACK_PADDING;
+    }
+
+    // leadout track
+    track.number = num + 1;
+    track.track_number = 0xAA;
+    track.attr = 0x16;
+    track.start = lba;
+    track.length = 0;
+    track.file = NULL;
+    tracks.push_back(track);
+
+    /* A Form 1 data track must read back its volume descriptor. */
+    if ((tracks[0].attr == DATA_TRACK) && tracks[0].mode2 &&
+	(tracks[0].form == 1) && (tracks[0].length > 16)) {
+	uint8_t pvd[RAW_SECTOR_SIZE];
+
+	if (! ReadSector(pvd, false, tracks[0].start + 16) ||
+	    (strncmp((char *)&pvd[1], "CD001", 5) &&
+	     strncmp((char *)&pvd[1], "CD-I ", 5)))
+		ERRLOG("CHD: no volume descriptor in Mode 2 Form 1 track of '%ls'!\n", filename);
+    }
+
+    return true;
+}
+#endif
+
+
 bool
 CDROM_Interface_Image::CueGetBuffer(char *str, char **line, bool up)
 {
@@ -8,7 +8,7 @@
  *
  *		Definitions for the CD-ROM image file handling module.
  *
- * Version:	@(#)cdrom_dosbox.h	1.0.5	2019/05/17
+ * Version:	@(#)cdrom_dosbox.h	1.0.6	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -121,6 +121,29 @@ private:
 		wchar_t fn[260];
 		FILE *file;
     };
+
+#ifdef USE_CHD
+    class ChdFile : public TrackFile {
+	public:
+		ChdFile(const wchar_t *filename, bool &error);
+		~ChdFile();
+		bool read(uint8_t *buffer, uint64_t seek, size_t count);
+		uint64_t getLength();
+		void addTrack(uint64_t start, int sectorSize, uint64_t frame, uint64_t frames, bool audio);
+		struct chd_image *chd;
+	private:
+		ChdFile();
+		struct Segment {
+			uint64_t start;		// offset in our (flat) file
+			int sectorSize;
+			uint64_t frame;		// first frame in the image
+			uint64_t frames;
+			bool audio;
+		};
+		std::vector<Segment> segments;
+		uint64_t length;
+    };
+#endif
 	
     struct Track {
 	int number;
@@ -163,6 +186,9 @@ private:
 
     void 	ClearTracks();
     bool	IsoLoadFile(const wchar_t *filename);
+#ifdef USE_CHD
+    bool	ChdLoadFile(const wchar_t *filename);
+#endif
     bool	CanReadPVD(TrackFile *file, uint64_t sectorSize, bool mode2);
 
     // cue sheet processing
@@ -8,7 +8,7 @@
  *
  *		CD-ROM image support.
  *
- * Version:	@(#)cdrom_image.cpp	1.0.22	2020/11/30
+ * Version:	@(#)cdrom_image.cpp	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -448,8 +448,10 @@ read_sector_to_buffer(cdrom_t *dev, uint8_t *rbuf, uint32_t msf, uint32_t lba, i
 {
     CDROM_Interface_Image *img = (CDROM_Interface_Image *)dev->local;
     uint8_t *bb = rbuf;
+    int xa = mode2 && (mode2 & 0x03);
 
-    img->ReadSector(rbuf + 16, false, lba);
+    /* XA user data goes after the (made up) sub-header. */
+    img->ReadSector(rbuf + (xa ? 24 : 16), false, lba);
 
     /* Sync bytes */
     bb[0] = 0;
@@ -462,8 +464,15 @@ read_sector_to_buffer(cdrom_t *dev, uint8_t *rbuf, uint32_t msf, uint32_t lba, i
     bb[1] = (msf >> 8) & 0xff;
     bb[2] = msf & 0xff;
 
-    bb[3] = 1; /* mode 1 data */
-    bb += mode2 ? 12 : 4;
+    bb[3] = mode2 ? 2 : 1; /* mode 1 or 2 data */
+    bb += 4;
+
+    if (xa) {
+	/* Sub-header, twice: file, channel, sub-mode, coding. */
+	memset(bb, 0x00, 8);
+	bb[2] = bb[6] = ((mode2 & 0x03) == 2) ? 0x20 : 0x08;
+    }
+    bb += mode2 ? 8 : 0;
     bb += len;
     if (mode2 && ((mode2 & 0x03) == 1))
 	memset(bb, 0, 88);	/* 280 */
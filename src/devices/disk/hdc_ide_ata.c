@@ -14,7 +14,7 @@
  *		Devices currently implemented are hard disk, CD-ROM and
  *		ZIP IDE/ATAPI devices.
  *
- * Version:	@(#)hdc_ide_ata.c	1.0.38	2021/03/16
+ * Version:	@(#)hdc_ide_ata.c	1.0.42	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -168,6 +168,7 @@ static void	ide_callback(priv_t priv);
 
 
 #define IDE_TIME (20LL * TIMER_USEC) / 3LL
+#define IDE_IO_POLL (10LL * IDE_TIME)	/* re-check for host I/O */
 
 
 uint8_t
@@ -1364,6 +1365,16 @@ ide_writeb(uint16_t addr, uint8_t val, priv_t priv)
 					ide_set_callback(ide->board, 200LL * IDE_TIME);
 				timer_update_outstanding();
 				ide->do_initial_read = 1;
+
+				/*
+				 * Have the host start reading the sectors now,
+				 * so they are (hopefully) there by the time we
+				 * need them in the callback.
+				 */
+				if ((ide->type == IDE_HDD) && ide->cfg_spt)
+					hdd_image_read_async(ide->hdd_num, ide_get_sector(ide),
+							     ide->secount ? ide->secount : 256,
+							     ide->sector_buffer);
 				return;
 
 			case WIN_WRITE_MULTIPLE:
@@ -1889,12 +1900,13 @@ ide_callback(priv_t priv)
 			goto id_not_found;
 
 		if (ide->do_initial_read) {
+			/* Host still reading the sectors, check again later. */
+			if (hdd_image_busy(ide->hdd_num)) {
+				ide_set_callback(ide->board, IDE_IO_POLL);
+				return;
+			}
 			ide->do_initial_read = 0;
 			ide->sector_pos = 0;
-			if (ide->secount)
-				hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->secount, ide->sector_buffer);
-			else
-				hdd_image_read(ide->hdd_num, ide_get_sector(ide), 256, ide->sector_buffer);
 		}
 
 		memcpy(ide->buffer, &ide->sector_buffer[ide->sector_pos*512], 512);
@@ -1920,12 +1932,19 @@ ide_callback(priv_t priv)
 			goto id_not_found;
 		}
 
-		ide->sector_pos = 0;
+		if (ide->do_initial_read) {
+			/* Host still reading the sectors, check again later. */
+			if (hdd_image_busy(ide->hdd_num)) {
+				ide_set_callback(ide->board, IDE_IO_POLL);
+				return;
+			}
+			ide->do_initial_read = 0;
+		}
+
 		if (ide->secount)
 			ide->sector_pos = ide->secount;
 		else
 			ide->sector_pos = 256;
-		hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
 
 		ide->pos = 0;
 
@@ -1971,12 +1990,13 @@ ide_callback(priv_t priv)
 			goto id_not_found;
 
 		if (ide->do_initial_read) {
+			/* Host still reading the sectors, check again later. */
+			if (hdd_image_busy(ide->hdd_num)) {
+				ide_set_callback(ide->board, IDE_IO_POLL);
+				return;
+			}
 			ide->do_initial_read = 0;
 			ide->sector_pos = 0;
-			if (ide->secount)
-				hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->secount, ide->sector_buffer);
-			else
-				hdd_image_read(ide->hdd_num, ide_get_sector(ide), 256, ide->sector_buffer);
 		}
 
 		memcpy(ide->buffer, &ide->sector_buffer[ide->sector_pos*512], 512);
@@ -1998,7 +2018,7 @@ ide_callback(priv_t priv)
 			goto abort_cmd;
 		if (ide->cfg_spt == 0)
 			goto id_not_found;
-		hdd_image_write(ide->hdd_num, ide_get_sector(ide), 1, (uint8_t *) ide->buffer);
+		hdd_image_write_async(ide->hdd_num, ide_get_sector(ide), 1, (uint8_t *) ide->buffer);
 		ide_irq_raise(ide);
 		ide->secount = (ide->secount - 1) & 0xff;
 		if (ide->secount) {
@@ -2046,7 +2066,7 @@ ide_callback(priv_t priv)
 				/*DMA successful*/
 				DEBUG("IDE %i: DMA write successful\n", ide->channel);
 
-				hdd_image_write(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
+				hdd_image_write_async(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
 
 				ide->atastat = DRDY_STAT | DSC_STAT;
 
@@ -2065,7 +2085,7 @@ ide_callback(priv_t priv)
 			goto abort_cmd;
 		if (ide->cfg_spt == 0)
 			goto id_not_found;
-		hdd_image_write(ide->hdd_num, ide_get_sector(ide), 1, (uint8_t *) ide->buffer);
+		hdd_image_write_async(ide->hdd_num, ide_get_sector(ide), 1, (uint8_t *) ide->buffer);
 		ide->blockcount++;
 		if (ide->blockcount >= ide->blocksize || ide->secount == 1) {
 			ide->blockcount = 0;
@@ -2559,6 +2579,10 @@ ide_drive_reset(int d)
 
     ide_set_signature(ide_drives[d]);
 
+    ide_drives[d]->do_initial_read = 0;
+    if ((ide_drives[d]->type == IDE_HDD) && hdd_image_busy(ide_drives[d]->hdd_num))
+	hdd_image_sync(ide_drives[d]->hdd_num);
+
     if (ide_drives[d]->sector_buffer)
 	memset(ide_drives[d]->sector_buffer, 0, 256*512);
 
@@ -8,7 +8,7 @@
  *
  *		Definitions for the hard disk image handler.
  *
- * Version:	@(#)hdd.h	1.0.17	2021/03/22
+ * Version:	@(#)hdd.h	1.0.19	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -116,12 +116,17 @@ extern void	hdd_active(int c, int active);
 extern void	hdd_image_log(int level, const char *fmt, ...);
 extern void	hdd_image_init(void);
 extern int	hdd_image_load(int id);
+extern int	hdd_image_busy(uint8_t id);
+extern void	hdd_image_sync(uint8_t id);
 extern void	hdd_image_seek(uint8_t id, uint32_t sector);
 extern void	hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int	hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern void	hdd_image_read_async(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern void	hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int	hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern void	hdd_image_write_async(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern void	hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count);
+extern void	hdd_image_trim(uint8_t id, uint32_t sector, uint32_t count);
 extern int	hdd_image_zero_ex(uint8_t id, uint32_t sector, uint32_t count);
 extern uint32_t	hdd_image_get_last_sector(uint8_t id);
 extern uint32_t	hdd_image_get_pos(uint8_t id);
@@ -14,7 +14,7 @@
  *		merged with hdd.c, since that is the scope of hdd.c. The
  *		actual format handlers can then be in hdd_format.c etc.
  *
- * Version:	@(#)hdd_image.c	1.0.15	2021/03/18
+ * Version:	@(#)hdd_image.c	1.0.19	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -67,6 +67,20 @@
 #define HDD_IMAGE_HDX 2
 #define HDD_IMAGE_VHD 3
 
+#define HDD_PUNCH_MIN	8		// min zero sectors worth a hole
+#define HDD_AIO_WORKERS	2		// number of I/O threads
+#define HDD_AIO_QUEUE	16		// max requests per image
+
+
+/* A queued (asynchronous) I/O request. */
+typedef struct {
+    int		write;
+    uint32_t	sector,
+		count;
+    uint8_t	*buffer;		// caller's buffer (reads)
+    uint8_t	*data;			// private copy (writes)
+    uint32_t	size;			// allocated size of copy
+} aio_req_t;
 
 typedef struct {
     FILE	*file;
@@ -75,9 +89,17 @@ typedef struct {
 		pos;
     uint8_t	type;
     uint8_t	loaded;
+    uint8_t	sparse;			// file can have holes
 #ifdef USE_MINIVHD
     MVHDMeta	*vhd;
 #endif
+
+    aio_req_t	req[HDD_AIO_QUEUE];	// asynchronous I/O queue
+    int		req_head,
+		req_tail;
+    volatile int pending;		// requests queued or active
+    int		active;			// being serviced by a worker
+    event_t	*done;
 } hdd_image_t;
 
 
@@ -87,6 +109,17 @@ int		hdd_image_do_log = ENABLE_HDD_LOG;
 hdd_image_t	hdd_images[HDD_NUM];
 
 
+static mutex_t	*aio_lock;
+static event_t	*aio_event;
+static thread_t	*aio_threads[HDD_AIO_WORKERS];
+static volatile int aio_quit;
+static int	aio_users;
+
+
+static void	image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+static void	image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+
+
 void
 hdd_image_log(int level, const char *fmt, ...)
 {
@@ -199,6 +232,22 @@ prepare_new_hard_disk(hdd_image_t *img, uint64_t full_size)
     fseeko64(img->file, 0ULL, SEEK_SET);
 #endif
 
+    /*
+     * If the host can do sparse files, just set the size of
+     * the image, and let the filesystem hand out the space
+     * as the guest actually writes to it.
+     */
+    img->sparse = plat_fsparse(img->file);
+    if (img->sparse && (target_size > 0)) {
+	fseeko64(img->file, full_size + img->base - 1, SEEK_SET);
+	fputc(0x00, img->file);
+	fflush(img->file);
+	if (! ferror(img->file))
+		goto done;
+	clearerr(img->file);
+	fseeko64(img->file, full_size + img->base - target_size, SEEK_SET);
+    }
+
     k = (1 << 20);				// 1048576 bytes, 1MB
     t = (uint32_t) (target_size / k);		// number of full 1MB blocks
     r = (uint32_t) (target_size & (k - 1));	// remainder, if any
@@ -215,6 +264,7 @@ prepare_new_hard_disk(hdd_image_t *img, uint64_t full_size)
 
     free(bufp);
 
+done:
     img->last_sector = (uint32_t) (full_size >> 9) - 1;
     img->loaded = 1;
 
@@ -222,6 +272,215 @@ prepare_new_hard_disk(hdd_image_t *img, uint64_t full_size)
 }
 
 
+/* Check if a sector contains only zeroes. */
+static int
+sector_is_zero(const uint8_t *bufp)
+{
+    const uint64_t *p = (const uint64_t *)bufp;
+    int i;
+
+    for (i = 0; i < (512 / 8); i += 4) {
+	if (p[i] | p[i + 1] | p[i + 2] | p[i + 3])
+		return 0;
+    }
+
+    return 1;
+}
+
+
+/*
+ * Release the space used by a range of sectors in a raw image,
+ * so it reads back as zeroes. If the host does not support this,
+ * stop trying and let the caller write the zeroes instead.
+ */
+static int
+image_punch(hdd_image_t *img, uint32_t sector, uint32_t count)
+{
+    if (! img->sparse || (img->file == NULL))
+	return 0;
+
+    /* Holes never extend the file, so stay within the image. */
+    if (((uint64_t)sector + count) > ((uint64_t)img->last_sector + 1))
+	return 0;
+
+    if (! plat_fpunch(img->file, ((uint64_t)sector << 9LL) + img->base,
+		      (uint64_t)count << 9LL)) {
+	DEBUG("HDD: host cannot punch holes, disabling\n");
+	img->sparse = 0;
+	return 0;
+    }
+
+    img->pos = sector + count - 1;
+
+    return 1;
+}
+
+
+/* Asynchronous I/O worker thread. */
+static void
+aio_thread(UNUSED(void *priv))
+{
+    hdd_image_t *img;
+    aio_req_t *req;
+    int i, id, more;
+
+    for (;;) {
+	thread_wait_event(aio_event, -1);
+
+	/* The event wakes only one of us, so pass it on. */
+	if (aio_quit) {
+		thread_set_event(aio_event);
+		break;
+	}
+
+	for (;;) {
+		/* Find an image with work, which nobody is servicing yet. */
+		thread_wait_mutex(aio_lock);
+		img = NULL;
+		id = more = 0;
+		for (i = 0; i < HDD_NUM; i++) {
+			if (hdd_images[i].active || !hdd_images[i].pending)
+				continue;
+			if (img == NULL) {
+				img = &hdd_images[i];
+				img->active = 1;
+				id = i;
+			} else
+				more = 1;
+		}
+		thread_release_mutex(aio_lock);
+
+		if (img == NULL) break;
+
+		/* Let another worker take care of the other images. */
+		if (more)
+			thread_set_event(aio_event);
+
+		req = &img->req[img->req_tail];
+		if (req->write)
+			image_write(id, req->sector, req->count, req->data);
+		else
+			image_read(id, req->sector, req->count, req->buffer);
+
+		thread_wait_mutex(aio_lock);
+		img->req_tail = (img->req_tail + 1) % HDD_AIO_QUEUE;
+		img->pending--;
+		img->active = 0;
+		thread_release_mutex(aio_lock);
+
+		thread_set_event(img->done);
+	}
+    }
+}
+
+
+/* Queue a request for one of the I/O threads. */
+static void
+aio_submit(uint8_t id, int write, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_t *img = &hdd_images[id];
+    aio_req_t *req;
+
+    /* No I/O threads for this image, so just do it now. */
+    if (img->done == NULL) {
+	if (write)
+		image_write(id, sector, count, buffer);
+	else
+		image_read(id, sector, count, buffer);
+	return;
+    }
+
+    /* Wait for room in the queue. */
+    while (img->pending >= HDD_AIO_QUEUE)
+	thread_wait_event(img->done, 10);
+
+    req = &img->req[img->req_head];
+    req->write = write;
+    req->sector = sector;
+    req->count = count;
+    if (write) {
+	/* The caller may re-use its buffer right away, so copy it. */
+	if (req->size < (count << 9)) {
+		if (req->data != NULL)
+			free(req->data);
+		req->size = (count << 9);
+		req->data = (uint8_t *)mem_alloc(req->size);
+	}
+	memcpy(req->data, buffer, count << 9);
+    } else
+	req->buffer = buffer;
+
+    thread_wait_mutex(aio_lock);
+    img->req_head = (img->req_head + 1) % HDD_AIO_QUEUE;
+    img->pending++;
+    thread_release_mutex(aio_lock);
+
+    thread_set_event(aio_event);
+}
+
+
+static void
+aio_attach(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+    int i;
+
+    if (img->done != NULL) return;
+
+    img->req_head = img->req_tail = 0;
+    img->pending = img->active = 0;
+    img->done = thread_create_event();
+
+    if (aio_users++ > 0) return;
+
+    aio_lock = thread_create_mutex(NULL);
+    aio_event = thread_create_event();
+
+    aio_quit = 0;
+    for (i = 0; i < HDD_AIO_WORKERS; i++)
+	aio_threads[i] = thread_create(aio_thread, NULL);
+
+    DEBUG("HDD: %i I/O threads started\n", HDD_AIO_WORKERS);
+}
+
+
+static void
+aio_detach(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+    int i;
+
+    if (img->done == NULL) return;
+
+    hdd_image_sync(id);
+
+    for (i = 0; i < HDD_AIO_QUEUE; i++) {
+	if (img->req[i].data != NULL)
+		free(img->req[i].data);
+    }
+    memset(img->req, 0x00, sizeof(img->req));
+
+    thread_destroy_event(img->done);
+    img->done = NULL;
+
+    if (--aio_users > 0) return;
+
+    aio_quit = 1;
+    thread_set_event(aio_event);
+    for (i = 0; i < HDD_AIO_WORKERS; i++) {
+	thread_wait(aio_threads[i], -1);
+	aio_threads[i] = NULL;
+    }
+
+    thread_destroy_event(aio_event);
+    aio_event = NULL;
+    thread_close_mutex(aio_lock);
+    aio_lock = NULL;
+
+    DEBUG("HDD: I/O threads stopped\n");
+}
+
+
 void
 hdd_image_init(void)
 {
@@ -236,8 +495,8 @@ hdd_image_init(void)
 }
 
 
-int
-hdd_image_load(int id)
+static int
+image_load(int id)
 {
     hdd_image_t *img = &hdd_images[id];
     uint32_t sector_size = 512;
@@ -458,6 +717,10 @@ hdd_image_load(int id)
 	}
     }
 
+    img->sparse = 0;
+    if (! hdd[id].wp)
+	img->sparse = plat_fsparse(img->file);
+
     fseeko64(img->file, 0, SEEK_END);
     s = ftello64(img->file);
     if (s < (full_size + img->base)) {
@@ -472,12 +735,72 @@ hdd_image_load(int id)
 }
 
 
+int
+hdd_image_load(int id)
+{
+    int ret;
+
+    aio_detach(id);
+
+    ret = image_load(id);
+    if (ret)
+	aio_attach(id);
+
+    return ret;
+}
+
+
+/* Check if any asynchronous I/O is still in progress. */
+int
+hdd_image_busy(uint8_t id)
+{
+    return (hdd_images[id].pending > 0);
+}
+
+
+/* Wait for all asynchronous I/O to complete. */
+void
+hdd_image_sync(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    while (img->pending > 0)
+	thread_wait_event(img->done, 10);
+}
+
+
+/*
+ * Start reading from the image in the background. The caller
+ * must not touch the buffer until hdd_image_busy() says the
+ * read has completed.
+ */
+void
+hdd_image_read_async(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    aio_submit(id, 0, sector, count, buffer);
+}
+
+
+/*
+ * Write to the image in the background. The data is copied, so
+ * the caller can re-use its buffer right away. Any later reads
+ * will only be done after the write has completed.
+ */
+void
+hdd_image_write_async(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    aio_submit(id, 1, sector, count, buffer);
+}
+
+
 void
 hdd_image_seek(uint8_t id, uint32_t sector)
 {
     hdd_image_t *img = &hdd_images[id];
     off64_t addr = (off64_t)sector << 9LL;
 
+    hdd_image_sync(id);
+
     img->pos = sector;
 
     if (img->type != HDD_IMAGE_VHD)
@@ -485,8 +808,8 @@ hdd_image_seek(uint8_t id, uint32_t sector)
 }
 
 
-void
-hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static void
+image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     hdd_image_t *img = &hdd_images[id];
     uint32_t i;
@@ -524,11 +847,22 @@ hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 }
 
 
+void
+hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_sync(id);
+
+    image_read(id, sector, count, buffer);
+}
+
+
 uint32_t
 hdd_sectors(uint8_t id)
 {
     hdd_image_t *img = &hdd_images[id];
 
+    hdd_image_sync(id);
+
 #ifdef USE_MINIVHD
     if (img->type == HDD_IMAGE_VHD) {
 	return (uint32_t) (img->last_sector - 1);
@@ -548,8 +882,11 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     hdd_image_t *img = &hdd_images[id];
     uint32_t transfer_sectors = count;
-    uint32_t sectors = hdd_sectors(id);
-    
+    uint32_t sectors;
+
+    hdd_image_sync(id);
+
+    sectors = hdd_sectors(id);
     if ((sectors - sector) < transfer_sectors)
 	transfer_sectors = sectors - sector;
 
@@ -565,14 +902,14 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 }
 
 
-void
-hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static void
+image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     hdd_image_t *img = &hdd_images[id];
 #ifdef USE_MINIVHD
     int remaining;
 #endif
-    uint32_t i;
+    uint32_t i, n, z;
 
 #ifdef USE_MINIVHD
     if (img->type == HDD_IMAGE_VHD) {
@@ -580,20 +917,42 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 	img->pos = sector + count - remaining - 1;
     } else {
 #endif
-	/* Move to the desired position in the image. */
-	fseeko64(img->file, ((uint64_t)sector << 9LL) + img->base, SEEK_SET);
+	for (i = 0; i < count; i += n) {
+		/* See how many all-zero sectors we have here. */
+		for (z = 0; img->sparse && ((i + z) < count); z++) {
+			if (! sector_is_zero(buffer + ((i + z) << 9)))
+				break;
+		}
 
-	/* Now write all (consecutive) blocks to the image. */
-	for (i = 0; i < count; i++) {
-		/* Write a block. */
-		fwrite(buffer + (i << 9), 512, 1, img->file);
+		/* If enough, punch a hole rather than writing them. */
+		if ((z >= HDD_PUNCH_MIN) && image_punch(img, sector + i, z)) {
+			n = z;
+			continue;
+		}
+
+		/* Write up to the next long enough run of zeroes. */
+		for (n = z ? z : 1, z = 0; (i + n) < count; n++) {
+			if (img->sparse && sector_is_zero(buffer + ((i + n) << 9))) {
+				if (++z >= HDD_PUNCH_MIN) {
+					n -= (z - 1);
+					break;
+				}
+			} else
+				z = 0;
+		}
+
+		/* Move to the desired position in the image. */
+		fseeko64(img->file, ((uint64_t)(sector + i) << 9LL) + img->base, SEEK_SET);
+
+		/* Now write all (consecutive) blocks to the image. */
+		fwrite(buffer + (i << 9), 512, n, img->file);
 
 		/* If error during write, give up. */
 		if (ferror(img->file))
 			break;
 
 		/* Update position. */
-		img->pos = sector + i;
+		img->pos = sector + i + n - 1;
 	}
 #ifdef USE_MINIVHD		
     }
@@ -601,6 +960,15 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 }
 
 
+void
+hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_sync(id);
+
+    image_write(id, sector, count, buffer);
+}
+
+
 #if 0
 // FIXME : not called by anything ?
 int
@@ -636,12 +1004,18 @@ hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
 #endif
     uint32_t i = 0;
 
+    hdd_image_sync(id);
+
 #ifdef USE_MINIVHD
     if (img->type == HDD_IMAGE_VHD) {
 	remaining = mvhd_format_sectors (img->vhd, sector, count);
 	img->pos = sector + count - remaining - 1;
     } else {
 #endif
+	/* Just release the space if we can. */
+	if (image_punch(img, sector, count))
+		return;
+
 	memset(empty, 0x00, sizeof(empty));
 
 	/* Move to the desired position in the image. */
@@ -671,12 +1045,18 @@ hdd_image_zero_ex(uint8_t id, uint32_t sector, uint32_t count)
     hdd_image_t *img = &hdd_images[id];
     uint8_t empty[512];
     uint32_t transfer_sectors = count;
-    uint32_t sectors = hdd_sectors(id);
+    uint32_t sectors;
     uint32_t i = 0;
 
+    hdd_image_sync(id);
+
+    sectors = hdd_sectors(id);
     if ((sectors - sector) < transfer_sectors)
 	transfer_sectors = sectors - sector;
 
+    if (image_punch(img, sector, transfer_sectors))
+	return (count != transfer_sectors);
+
     memset(empty, 0x00, sizeof(empty));
 
     img->pos = sector;
@@ -698,6 +1078,30 @@ hdd_image_zero_ex(uint8_t id, uint32_t sector, uint32_t count)
 }
 
 
+/*
+ * The guest no longer needs these sectors (SCSI UNMAP.)
+ * We release their space on the host if we can; otherwise they
+ * are left alone, which is perfectly fine as well.
+ */
+void
+hdd_image_trim(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    hdd_image_sync(id);
+
+    if ((img->type == HDD_IMAGE_VHD) || (count == 0))
+	return;
+
+    if (sector > img->last_sector)
+	return;
+    if (((uint64_t)sector + count) > ((uint64_t)img->last_sector + 1))
+	count = img->last_sector - sector + 1;
+
+    (void)image_punch(img, sector, count);
+}
+
+
 uint32_t
 hdd_image_get_last_sector(uint8_t id)
 {
@@ -724,6 +1128,8 @@ hdd_image_specify(uint8_t id, int hpc, int spt)
 {
     hdd_image_t *img = &hdd_images[id];
 
+    hdd_image_sync(id);
+
     if (img->type == HDD_IMAGE_HDX) {
 	hdd[id].at_hpc = hpc;
 	hdd[id].at_spt = spt;
@@ -744,6 +1150,8 @@ hdd_image_unload(uint8_t id, int fn_preserve)
     if (wcslen(hdd[id].fn) == 0)
 	return;
 
+    aio_detach(id);
+
     if (img->loaded) {
 	if (img->file != NULL) {
 		(void)fclose(img->file);
@@ -776,6 +1184,8 @@ hdd_image_close(uint8_t id)
 
     if (! img->loaded) return;
 
+    aio_detach(id);
+
     if (img->file != NULL) {
 	(void)fclose(img->file);
 	img->file = NULL;
@@ -9,7 +9,7 @@
  *		Implementation of the NEC uPD-765 and compatible floppy disk
  *		controller.
  *
- * Version:	@(#)fdc.c	1.0.30	2021/05/24
+ * Version:	@(#)fdc.c	1.0.31	2026/10/19
  *
  * Authors:	Miran Grca, <mgrca8@gmail.com>
  *		Sarah Walker, <tommowalker@tommowalker.co.uk>
@@ -247,6 +247,17 @@ fdc_is_mfm(fdc_t *fdc)
 }
 
 
+/* Are data transfers done using DMA (as opposed to PIO) ? */
+int
+fdc_is_dma(fdc_t *fdc)
+{
+    if ((fdc->flags & FDC_FLAG_PCJR) || !fdc->dma)
+	return(0);
+
+    return(1);
+}
+
+
 void
 fdc_request_next_sector_id(fdc_t *fdc)
 {
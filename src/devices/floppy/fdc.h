@@ -8,7 +8,7 @@
  *
  *		Definitions for the floppy disk	controller driver.
  *
- * Version:	@(#)fdc.h	1.0.11	2021/04/06
+ * Version:	@(#)fdc.h	1.0.12	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -171,6 +171,7 @@ extern int	fdc_get_drive(fdc_t *fdc);
 extern int	fdc_get_perp(fdc_t *fdc);
 extern int	fdc_get_format_n(fdc_t *fdc);
 extern int	fdc_is_mfm(fdc_t *fdc);
+extern int	fdc_is_dma(fdc_t *fdc);
 extern double	fdc_get_hut(fdc_t *fdc);
 extern double	fdc_get_hlt(fdc_t *fdc);
 extern void	fdc_request_next_sector_id(fdc_t *fdc);
@@ -8,7 +8,7 @@
  *
  *		Definitions for the floppy drive emulation.
  *
- * Version:	@(#)fdd.h	1.0.12	2021/02/06
+ * Version:	@(#)fdd.h	1.0.13	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -168,6 +168,7 @@ typedef union {
 } crc_t;
 
 void fdd_calccrc(uint8_t byte, crc_t *crc_var);
+void fdd_calccrc_buf(const uint8_t *bufp, int len, crc_t *crc_var);
 
 typedef struct {
     uint16_t	(*disk_flags)(int drive);
@@ -10,7 +10,7 @@
  *		data in the form of FM/MFM-encoded transitions) which also
  *		forms the core of the emulator's floppy disk emulation.
  *
- * Version:	@(#)fdd_86f.c	1.0.20	2021/03/18
+ * Version:	@(#)fdd_86f.c	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -269,7 +269,10 @@ static const uint8_t encoded_mfm[64] = {
 };
 
 static d86f_t	*d86f[FDD_NUM];
-static uint16_t	CRCTable[256];
+static uint16_t	CRCTable[8][256];		/* slicing-by-8 tables */
+static uint16_t	encode_data[256],		/* data bits of a byte */
+		encode_clock[256];		/* clock bits of a byte */
+static uint8_t	decode_half[256];		/* data bits of half a word */
 static fdc_t	*d86f_fdc;
 uint64_t	poly = 0x42F0E1EBA9EA3693ll;		/* ECMA normal */
 uint64_t	table[256];
@@ -303,7 +306,7 @@ d86f_log(int level, const char *fmt, ...)
 static void
 setup_crc(uint16_t __poly)
 {
-    int c = 256, bc;
+    int c = 256, bc, k;
     uint16_t temp;
 
     while(c--) {
@@ -316,7 +319,42 @@ setup_crc(uint16_t __poly)
 		  else
 			temp <<= 1;
 
-		CRCTable[c] = temp;
+		CRCTable[0][c] = temp;
+	}
+    }
+
+    /*
+     * Table k holds the CRC of a byte followed by k zero bytes,
+     * which lets us process 8 bytes at a time for blocks.
+     */
+    for (k = 1; k < 8; k++) {
+	for (c = 0; c < 256; c++)
+		CRCTable[k][c] = (CRCTable[k - 1][c] << 8) ^
+				 CRCTable[0][CRCTable[k - 1][c] >> 8];
+    }
+}
+
+
+/* Set up the tables used for FM/MFM bit (de)interleaving. */
+static void
+setup_codec(void)
+{
+    int c, i;
+
+    for (c = 0; c < 256; c++) {
+	encode_data[c] = encode_clock[c] = 0;
+	decode_half[c] = 0;
+
+	for (i = 0; i < 8; i++) {
+		if (c & (1 << i)) {
+			encode_data[c] |= (1 << (i << 1));
+			encode_clock[c] |= (2 << (i << 1));
+		}
+	}
+
+	for (i = 0; i < 4; i++) {
+		if (c & (1 << (i << 1)))
+			decode_half[c] |= (1 << i);
 	}
     }
 }
@@ -879,38 +917,14 @@ d86f_header_size(int drive)
 static uint16_t
 d86f_encode_get_data(uint8_t dat)
 {
-    uint16_t temp;
-    temp = 0;
-
-    if (dat & 0x01) temp |= 1;
-    if (dat & 0x02) temp |= 4;
-    if (dat & 0x04) temp |= 16;
-    if (dat & 0x08) temp |= 64;
-    if (dat & 0x10) temp |= 256;
-    if (dat & 0x20) temp |= 1024;
-    if (dat & 0x40) temp |= 4096;
-    if (dat & 0x80) temp |= 16384;
-
-    return temp;
+    return encode_data[dat];
 }
 
 
 static uint16_t
 d86f_encode_get_clock(uint8_t dat)
 {
-    uint16_t temp;
-    temp = 0;
-
-    if (dat & 0x01) temp |= 2;
-    if (dat & 0x02) temp |= 8;
-    if (dat & 0x40) temp |= 32;
-    if (dat & 0x08) temp |= 128;
-    if (dat & 0x10) temp |= 512;
-    if (dat & 0x20) temp |= 2048;
-    if (dat & 0x40) temp |= 8192;
-    if (dat & 0x80) temp |= 32768;
-
-    return temp;
+    return encode_clock[dat];
 }
 
 
@@ -1101,43 +1115,38 @@ d86f_get_bit(int drive, int side)
     uint32_t track_word;
     uint32_t track_bit;
     uint16_t encoded_data;
-    uint16_t surface_data = 0;
+    uint16_t surface_data;
     uint16_t current_bit;
-    uint16_t surface_bit;
+    uint16_t flags;
 
     track_word = dev->track_pos >> 4;
 
     /* We need to make sure we read the bits from MSB to LSB. */
     track_bit = 15 - (dev->track_pos & 15);
 
-    if (d86f_reverse_bytes(drive)) {
-	/* Image is in reverse endianness, read the data as is. */
-	encoded_data = d86f_handler[drive].encoded_data(drive, side)[track_word];
-    } else {
-	/* We store the words as big endian, so we need to convert them to little endian when reading. */
-	encoded_data = (d86f_handler[drive].encoded_data(drive, side)[track_word] & 0xFF) << 8;
-	encoded_data |= (d86f_handler[drive].encoded_data(drive, side)[track_word] >> 8);
-    }
+    /* This is called for every bit cell, so only look things up once. */
+    flags = d86f_handler[drive].disk_flags(drive);
+    encoded_data = d86f_handler[drive].encoded_data(drive, side)[track_word];
+
+    /* We store the words as big endian, so we need to convert them to little endian when reading. */
+    if (! (flags & 0x800))
+	encoded_data = (encoded_data << 8) | (encoded_data >> 8);
+
+    current_bit = (encoded_data >> track_bit) & 1;
+    dev->last_word[side] <<= 1;
 
     /*
      * In some cases, misidentification occurs so we need
      * to make sure the surface data array is not not NULL.
      */
-    if (d86f_has_surface_desc(drive) && dev->track_surface_data[side]) {
-	if (d86f_reverse_bytes(drive)) {
-		surface_data = dev->track_surface_data[side][track_word] & 0xFF;
-	} else {
-		surface_data = (dev->track_surface_data[side][track_word] & 0xFF) << 8;
-		surface_data |= (dev->track_surface_data[side][track_word] >> 8);
-	}
-    }
-
-    current_bit = (encoded_data >> track_bit) & 1;
-    dev->last_word[side] <<= 1;
+    if ((flags & 1) && dev->track_surface_data[side]) {
+	surface_data = dev->track_surface_data[side][track_word];
+	if (flags & 0x800)
+		surface_data &= 0xFF;
+	else
+		surface_data = (surface_data << 8) | (surface_data >> 8);
 
-    if (d86f_has_surface_desc(drive) && dev->track_surface_data[side]) {
-	surface_bit = (surface_data >> track_bit) & 1;
-	if (! surface_bit)
+	if (! ((surface_data >> track_bit) & 1))
 		dev->last_word[side] |= current_bit;
 	else {
 		if (current_bit) {
@@ -1239,22 +1248,11 @@ d86f_put_bit(int drive, int side, int bit)
 static uint8_t
 decodefm(int drive, uint16_t dat)
 {
-    uint8_t temp = 0;
-
     /*
      * We write the encoded bytes in big endian, so we
      * process the two 8-bit halves swapped here.
      */
-    if (dat & 0x0001) temp |= 1;
-    if (dat & 0x0004) temp |= 2;
-    if (dat & 0x0010) temp |= 4;
-    if (dat & 0x0040) temp |= 8;
-    if (dat & 0x0100) temp |= 16;
-    if (dat & 0x0400) temp |= 32;
-    if (dat & 0x1000) temp |= 64;
-    if (dat & 0x4000) temp |= 128;
-
-    return temp;
+    return decode_half[dat & 0xff] | (decode_half[dat >> 8] << 4);
 }
 
 
@@ -1262,7 +1260,30 @@ void
 fdd_calccrc(uint8_t byte, crc_t *crc_var)
 {
     crc_var->word = (crc_var->word << 8) ^
-			CRCTable[(crc_var->word >> 8)^byte];
+			CRCTable[0][(crc_var->word >> 8)^byte];
+}
+
+
+/* Update a CRC with a block of data, 8 bytes at a time. */
+void
+fdd_calccrc_buf(const uint8_t *bufp, int len, crc_t *crc_var)
+{
+    uint16_t crc = crc_var->word;
+
+    while (len >= 8) {
+	crc = CRCTable[7][bufp[0] ^ (crc >> 8)] ^
+	      CRCTable[6][bufp[1] ^ (crc & 0xff)] ^
+	      CRCTable[5][bufp[2]] ^ CRCTable[4][bufp[3]] ^
+	      CRCTable[3][bufp[4]] ^ CRCTable[2][bufp[5]] ^
+	      CRCTable[1][bufp[6]] ^ CRCTable[0][bufp[7]];
+	bufp += 8;
+	len -= 8;
+    }
+
+    while (len-- > 0)
+	crc = (crc << 8) ^ CRCTable[0][(crc >> 8) ^ *bufp++];
+
+    crc_var->word = crc;
 }
 
 
@@ -1381,6 +1402,20 @@ d86f_find_address_mark_mfm(int drive, int side, find_t *find, uint16_t req_am, u
 	return;
     }
 
+    /*
+     * Until we have seen a full set of sync marks, no address
+     * mark can match, so all we need is to (maybe) reset the
+     * count. This is by far the most common case, so keep it
+     * cheap.
+     */
+    if (find->sync_marks < 3) {
+	if (find->sync_marks && d86f_word_is_aligned(drive, side, find->sync_pos)) {
+		find->sync_marks = find->bits_obtained = find->bytes_obtained = 0;
+		find->sync_pos = 0xFFFFFFFF;
+	}
+	return;
+    }
+
     if ((wrong_am) && (dev->last_word[side] == wrong_am) && (find->sync_marks >= 3)) {
 	dev->data_find.sync_marks = dev->data_find.bits_obtained = dev->data_find.bytes_obtained = 0;
 	dev->error_condition = 0;
@@ -2155,23 +2190,32 @@ d86f_turbo_read(int drive, int side)
     uint8_t dat = 0;
     int recv_data = 0;
     int read_status = 0;
+    int burst;
 
-    dat = d86f_handler[drive].read_data(drive, side, dev->turbo_pos);
-    dev->turbo_pos++;
+    /*
+     * With DMA (or when just verifying), nobody looks at the
+     * bytes one by one, so hand over the whole sector at once.
+     */
+    burst = fdc_is_dma(d86f_fdc) || (dev->state == STATE_16_VERIFY_DATA);
 
-    if (dev->state == STATE_11_SCAN_DATA) {
-	/* Scan/compare command. */
-	recv_data = d86f_get_data(drive, 0);
-	d86f_compare_byte(drive, recv_data, dat);
-    } else {
-	if (dev->data_find.bytes_obtained < (128UL << dev->last_sector.id.n)) {
-		if (dev->state != STATE_16_VERIFY_DATA) {
-			read_status = fdc_data(d86f_fdc, dat);
-			if (read_status == -1)
-				dev->dma_over++;
+    do {
+	dat = d86f_handler[drive].read_data(drive, side, dev->turbo_pos);
+	dev->turbo_pos++;
+
+	if (dev->state == STATE_11_SCAN_DATA) {
+		/* Scan/compare command. */
+		recv_data = d86f_get_data(drive, 0);
+		d86f_compare_byte(drive, recv_data, dat);
+	} else {
+		if (dev->data_find.bytes_obtained < (128UL << dev->last_sector.id.n)) {
+			if (dev->state != STATE_16_VERIFY_DATA) {
+				read_status = fdc_data(d86f_fdc, dat);
+				if (read_status == -1)
+					dev->dma_over++;
+			}
 		}
 	}
-    }
+    } while (burst && (dev->turbo_pos < (128 << dev->last_sector.id.n)));
 
     if (dev->turbo_pos >= (128 << dev->last_sector.id.n)) {
 	/* CRC is valid. */
@@ -2193,11 +2237,17 @@ d86f_turbo_write(int drive, int side)
 {
     d86f_t *dev = d86f[drive];
     uint8_t dat = 0;
+    int burst;
+
+    /* With DMA, we can take the whole sector at once. */
+    burst = fdc_is_dma(d86f_fdc);
 
-    dat = d86f_get_data(drive, 1);
-    d86f_handler[drive].write_data(drive, side, dev->turbo_pos, dat);
+    do {
+	dat = d86f_get_data(drive, 1);
+	d86f_handler[drive].write_data(drive, side, dev->turbo_pos, dat);
 
-    dev->turbo_pos++;
+	dev->turbo_pos++;
+    } while (burst && (dev->turbo_pos < (128 << dev->last_sector.id.n)));
 
     if (dev->turbo_pos >= (128 << dev->last_sector.id.n)) {
 	/* We've written the data. */
@@ -2770,8 +2820,8 @@ d86f_prepare_sector(int drive, int side, int prev_pos, uint8_t *id_buf, uint8_t
     for (i = 0; i < data_len; i++) {
 	d86f_write_direct_common(drive, side, data_buf[i], 0, pos);
 	pos = (pos + 1) % raw_size;
-	d86f_calccrc(dev, data_buf[i]);
     }
+    fdd_calccrc_buf(data_buf, data_len, &(dev->calc_crc));
     if (bad_crc)
 	dev->calc_crc.word ^= 0xffff;
     for (i = 1; i >= 0; i--) {
@@ -3799,6 +3849,7 @@ d86f_init(void)
     int i;
 
     setup_crc(0x1021);
+    setup_codec();
 
     for (i = 0; i < FDD_NUM; i++)
 	d86f[i] = NULL;
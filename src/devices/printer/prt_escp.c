@@ -8,7 +8,7 @@
  *
  *		Implementation of the Generic ESC/P Dot-Matrix printer.
  *
- * Version:	@(#)prt_escp.c	1.0.12	2021/03/18
+ * Version:	@(#)prt_escp.c	1.0.14	2026/10/19
  *
  * Authors:	Michael Dring, <michael@drueing.de>
  *		Fred N. van Kempen, <decwiz@yahoo.com>
@@ -91,6 +91,13 @@
 #define PAGE_CPI	10.0			/* standard 10 cpi */
 #define PAGE_LPI	6.0			/* standard 6 lpi */
 
+/* Interpreter queue and glyph cache sizes. */
+#define FIFO_SIZE	65536			/* must be power of 2 */
+#define  FIFO_RESET	0x0100			/* reset the printer */
+#define  FIFO_FLUSH	0x0101			/* port timeout, eject page */
+#define  FIFO_AUTOFEED	0x0200			/* byte sent with AUTOFEED */
+#define GLYPH_CACHE	1024			/* must be power of 2 */
+
 
 #ifdef _WIN32
 # define PATH_FREETYPE_DLL	"freetype.dll"
@@ -102,6 +109,8 @@
 /* FreeType library handles - global so they can be shared. */
 FT_Library	ft_lib = NULL;
 void		*ft_handle = NULL;
+static mutex_t	*ft_mutex = NULL;	/* faces are managed per-thread */
+static int	ft_users = 0;
 
 static int	(*ft_Init_FreeType)(FT_Library *alibrary);
 static int	(*ft_Done_Face)(FT_Face face);
@@ -203,6 +212,25 @@ typedef struct {
 } psurface_t;
 
 
+/* A rendered glyph, as kept in the glyph cache. */
+typedef struct {
+    const wchar_t *font;	/* font file (NULL if entry unused) */
+    uint32_t	hsize,		/* character size (26.6) */
+		vsize;
+    uint8_t	italic;
+    uint8_t	pad;
+    uint16_t	ch;		/* Unicode character */
+
+    int16_t	left,		/* bitmap placement */
+		top;
+    uint16_t	width,		/* bitmap size, pitch is width */
+		rows;
+    int32_t	advance;	/* horizontal advance (26.6) */
+
+    uint8_t	*bits;
+} glyph_t;
+
+
 typedef struct {
     const char	*name;
 
@@ -246,6 +274,7 @@ typedef struct {
     /* ESC command data. */
     int8_t	esc_seen;		/* set to 1 if an ESC char was seen */
     int8_t	fss_seen;		/* set to 1 if an FS char was seen */
+    int8_t	auto_lf;		/* AUTOFEED was set with this byte */
     uint16_t	esc_pending;		/* in which ESC command are we */
     uint8_t	esc_parms_req;
     uint8_t	esc_parms_curr;
@@ -258,6 +287,10 @@ typedef struct {
     double	curr_x, curr_y;		/* print head position (inch) */
     uint16_t	current_font;
     FT_Face	fontface;
+    const wchar_t *font_fn;		/* file and size of the current face */
+    uint32_t	font_hsize,
+		font_vsize;
+    uint8_t	font_italic;
     uint8_t	lq_typeface;
     uint8_t	print_quality;
     uint8_t	font_score;
@@ -286,6 +319,18 @@ typedef struct {
 					 * commands. -1 = use default */
     RGB_PAL	palcol;
 
+    /* Glyph cache, direct-mapped. */
+    glyph_t	*glyphs;
+
+    /* Interpreter thread and its input queue. */
+    thread_t	*thread;
+    event_t	*wake_ev,		/* data was queued */
+		*space_ev;		/* queue space was freed */
+    volatile int stop;
+    uint16_t	*fifo;
+    volatile uint32_t fifo_head,	/* written by emulator */
+		fifo_tail;		/* written by interpreter */
+
     /* Port data */
     int8_t	ack,
 		select,
@@ -383,10 +428,6 @@ update_font(escp_t *dev)
     /* We need the FreeType library. */
     if (ft_lib == NULL) return;
 
-    /* Release current font if we have one. */
-    if (dev->fontface)
-	ft_Done_Face(dev->fontface);
-
     if (dev->print_quality == QUALITY_DRAFT) {
 #ifdef FONT_FILE_DOTMATRIX
 	fn = FONT_FILE_DOTMATRIX;
@@ -426,18 +467,34 @@ update_font(escp_t *dev)
 #endif
     }
 
-    /* Create a full pathname for the ROM file. */
-    wcscpy(path, dev->fontpath);
-    wcscat(path, fn);
+    /*
+     * Most commands call us even if nothing font-related changed,
+     * so only (re-)load the face if we need a different file.
+     */
+    if ((dev->fontface == 0) || (fn != dev->font_fn)) {
+	/* Create a full pathname for the ROM file. */
+	wcscpy(path, dev->fontpath);
+	wcscat(path, fn);
+
+	/* Convert (back) to ANSI for the FreeType API. */
+	wcstombs(temp, path, sizeof(temp));
 
-    /* Convert (back) to ANSI for the FreeType API. */
-    wcstombs(temp, path, sizeof(temp));
+	thread_wait_mutex(ft_mutex);
 
-    /* Load the new font. */
-    if (ft_New_Face(ft_lib, temp, 0, &dev->fontface)) {
-	ERRLOG("ESC/P: unable to load font '%s'\n", temp);
-	ERRLOG("ESC/P: text printing disabled\n");
-	dev->fontface = 0;
+	/* Release current font if we have one. */
+	if (dev->fontface)
+		ft_Done_Face(dev->fontface);
+
+	/* Load the new font. */
+	if (ft_New_Face(ft_lib, temp, 0, &dev->fontface)) {
+		ERRLOG("ESC/P: unable to load font '%s'\n", temp);
+		ERRLOG("ESC/P: text printing disabled\n");
+		dev->fontface = 0;
+	}
+
+	thread_release_mutex(ft_mutex);
+
+	dev->font_fn = fn;
     }
 
     if (dev->multipoint_mode == 0) {
@@ -488,23 +545,100 @@ update_font(escp_t *dev)
 	dev->actual_cpi /= 2.0 / 3.0;
     }
 
-    ft_Set_Char_Size(dev->fontface,
-		     (uint16_t)(hpoints * 64),
-		     (uint16_t)(vpoints * 64),
+    if (dev->fontface == 0) return;
+
+    dev->font_hsize = (uint16_t)(hpoints * 64);
+    dev->font_vsize = (uint16_t)(vpoints * 64);
+    ft_Set_Char_Size(dev->fontface, dev->font_hsize, dev->font_vsize,
 		     dev->dpi, dev->dpi);
 
-    if ((dev->font_style & STYLE_ITALICS) ||
-	(dev->char_tables[dev->curr_char_table] == 0)) {
+    dev->font_italic = ((dev->font_style & STYLE_ITALICS) ||
+			(dev->char_tables[dev->curr_char_table] == 0));
+    if (dev->font_italic) {
 	/* Italics transformation. */
 	matrix.xx = 0x10000L;
 	matrix.xy = (FT_Fixed)(0.20 * 0x10000L);
 	matrix.yx = 0;
 	matrix.yy = 0x10000L;
 	ft_Set_Transform(dev->fontface, &matrix, 0);
+    } else {
+	/* The face is re-used, so undo any earlier transformation. */
+	ft_Set_Transform(dev->fontface, NULL, 0);
     }
 }
 
 
+/* Release all cached glyphs. */
+static void
+glyph_flush(escp_t *dev)
+{
+    glyph_t *g;
+    int i;
+
+    for (i = 0; i < GLYPH_CACHE; i++) {
+	g = &dev->glyphs[i];
+	if (g->bits != NULL)
+		free(g->bits);
+	memset(g, 0x00, sizeof(glyph_t));
+    }
+}
+
+
+/*
+ * Find a character in the glyph cache, or render it with the
+ * current font and add it. Returns NULL if we cannot print it.
+ */
+static const glyph_t *
+glyph_get(escp_t *dev, uint16_t ch)
+{
+    FT_GlyphSlot slot;
+    glyph_t *g;
+    uint32_t h;
+    int y;
+
+    if ((ft_lib == NULL) || (dev->fontface == 0)) return(NULL);
+
+    h = ch ^ (dev->font_hsize * 31) ^ (dev->font_vsize * 131) ^
+	(uint32_t)(uintptr_t)dev->font_fn ^ dev->font_italic;
+    h ^= (h >> 10);
+    g = &dev->glyphs[h & (GLYPH_CACHE - 1)];
+
+    if ((g->font == dev->font_fn) && (g->ch == ch) &&
+	(g->hsize == dev->font_hsize) && (g->vsize == dev->font_vsize) &&
+	(g->italic == dev->font_italic)) return(g);
+
+    /* Not cached (or another glyph is in its slot), render it. */
+    ft_Load_Glyph(dev->fontface,
+		  ft_Get_Char_Index(dev->fontface, ch), FT_LOAD_DEFAULT);
+    ft_Render_Glyph(dev->fontface->glyph, FT_RENDER_MODE_NORMAL);
+    slot = dev->fontface->glyph;
+
+    if (g->bits != NULL)
+	free(g->bits);
+    g->font = dev->font_fn;
+    g->hsize = dev->font_hsize;
+    g->vsize = dev->font_vsize;
+    g->italic = dev->font_italic;
+    g->ch = ch;
+    g->left = slot->bitmap_left;
+    g->top = slot->bitmap_top;
+    g->width = slot->bitmap.width;
+    g->rows = slot->bitmap.rows;
+    g->advance = slot->advance.x;
+    g->bits = NULL;
+
+    if (g->width && g->rows) {
+	g->bits = (uint8_t *)mem_alloc(g->width * g->rows);
+	for (y = 0; y < g->rows; y++)
+		memcpy(g->bits + (y * g->width),
+		       slot->bitmap.buffer + (y * slot->bitmap.pitch),
+		       g->width);
+    }
+
+    return(g);
+}
+
+
 static int
 dump_pgm(const wchar_t *fn, int inv, uint8_t *pix, int16_t w, int16_t h)
 {
@@ -552,7 +686,7 @@ dump_page(escp_t *dev)
     wcscat(path, temp);
 # ifdef USE_COLOR
     if (! png_write_pal(path, dev->page->pixels, dev->page->w, dev->page->h,
-			dev->page->pitch, dev->palcol)) {
+			dev->page->pitch, dev->palcol, PNG_LEVEL_DEFAULT)) {
 # else
     if (! png_write_gray(path, 1, dev->page->pixels, dev->page->w, dev->page->h)) {
 # endif
@@ -603,7 +737,7 @@ printer_reset(escp_t *dev)
     dev->cpi = PAGE_CPI;
     dev->dpi = PAGE_DPI;    
 
-    dev->autofeed = 0;
+    dev->auto_lf = 0;
     dev->esc_seen = dev->fss_seen = 0;
     dev->esc_pending = 0;
     dev->esc_parms_req = dev->esc_parms_curr = 0;
@@ -627,7 +761,6 @@ printer_reset(escp_t *dev)
     dev->current_font = FONT_COURIER;
     dev->lq_typeface = TYPEFACE_COURIER;
     dev->print_quality = QUALITY_DRAFT;
-    dev->fontface = 0;
     dev->font_style = 0;
     dev->font_score = 0;
     dev->multipoint_mode = 0;
@@ -1653,7 +1786,7 @@ process_data(escp_t *dev, uint8_t ch)
 
 	case 0x0d:	/* Carriage Return (CR) */
 		dev->curr_x = dev->left_margin;
-		if (! dev->autofeed)
+		if (! dev->auto_lf)
 			return 1;
 		/*FALLTHROUGH*/
 
@@ -1734,18 +1867,16 @@ process_data(escp_t *dev, uint8_t ch)
  * hard to do.
  */
 static void
-blit_glyph(escp_t *dev, unsigned destx, unsigned desty, int8_t add)
+blit_glyph(escp_t *dev, const glyph_t *g, unsigned destx, unsigned desty, int8_t add)
 {
-    FT_Bitmap *bitmap = &dev->fontface->glyph->bitmap;
     unsigned x, y;
     uint8_t src, *dst;
 
-    /* check if freetype is available */
-    if (ft_lib == NULL) return;
+    if (g->bits == NULL) return;
 
-    for (y = 0; y < bitmap->rows; y++) {
-	for (x = 0; x < bitmap->width; x++) {
-		src = *(bitmap->buffer + x + y * bitmap->pitch);
+    for (y = 0; y < g->rows; y++) {
+	for (x = 0; x < g->width; x++) {
+		src = *(g->bits + x + y * g->width);
 
 		/* ignore background, and respect page size */
 		if (src > 0 && (destx + x < (unsigned)dev->page->w) && (desty + y < (unsigned)dev->page->h)) {
@@ -1849,14 +1980,11 @@ print_bit_graph(escp_t *dev, uint8_t ch)
 static void
 escp_handle(escp_t *dev, uint8_t ch)
 {
-    FT_UInt char_index;
+    const glyph_t *g;
     uint16_t pen_x, pen_y;
     uint16_t line_start, line_y;
     double x_advance;
 
-    /* OK, we have seen the character. */
-    dev->ack = 1;
-
     if (dev->page == NULL) return;
 
     /* MSB mode */
@@ -1890,43 +2018,40 @@ escp_handle(escp_t *dev, uint8_t ch)
 	ch = 0x20;
 
     /* OK, so we need to print the character now. */
-    if (ft_lib != NULL) {
-	char_index = ft_Get_Char_Index(dev->fontface, dev->curr_cpmap[ch]);
-	ft_Load_Glyph(dev->fontface, char_index, FT_LOAD_DEFAULT);
-	ft_Render_Glyph(dev->fontface->glyph, FT_RENDER_MODE_NORMAL);
-    }
+    g = glyph_get(dev, dev->curr_cpmap[ch]);
+    if (g == NULL) return;
 
-    pen_x = (uint16_t)PIXX + dev->fontface->glyph->bitmap_left;
-    pen_y = (uint16_t)PIXY - dev->fontface->glyph->bitmap_top + (uint16_t)(dev->fontface->size->metrics.ascender / 64);
+    pen_x = (uint16_t)PIXX + g->left;
+    pen_y = (uint16_t)PIXY - g->top + (uint16_t)(dev->fontface->size->metrics.ascender / 64);
 
     if (dev->font_style & STYLE_SUBSCRIPT)
-	pen_y += dev->fontface->glyph->bitmap.rows / 2;
+	pen_y += g->rows / 2;
 
     /* Mark the page as dirty if anything is drawn. */
     if ((ch != 0x20) || (dev->font_score != SCORE_NONE))
 	dev->page->dirty = 1;
 
     /* Draw the rendered glyph. */
-    blit_glyph(dev, pen_x, pen_y, 0);
-    blit_glyph(dev, pen_x + 1, pen_y, 1);
+    blit_glyph(dev, g, pen_x, pen_y, 0);
+    blit_glyph(dev, g, pen_x + 1, pen_y, 1);
 
     /* doublestrike -> draw glyph a second time, 1px below */
     if (dev->font_style & STYLE_DOUBLESTRIKE) {
-	blit_glyph(dev, pen_x, pen_y + 1, 1);
-	blit_glyph(dev, pen_x + 1, pen_y + 1, 1);
+	blit_glyph(dev, g, pen_x, pen_y + 1, 1);
+	blit_glyph(dev, g, pen_x + 1, pen_y + 1, 1);
     }
 
     /* bold -> draw glyph a second time, 1px to the right */
     if (dev->font_style & STYLE_BOLD) {
-	blit_glyph(dev, pen_x + 1, pen_y, 1);
-	blit_glyph(dev, pen_x + 2, pen_y, 1);
-	blit_glyph(dev, pen_x + 3, pen_y, 1);
+	blit_glyph(dev, g, pen_x + 1, pen_y, 1);
+	blit_glyph(dev, g, pen_x + 2, pen_y, 1);
+	blit_glyph(dev, g, pen_x + 3, pen_y, 1);
     }
 
     line_start = (uint16_t)PIXX;
 
     if (dev->font_style & STYLE_PROP) {
-	x_advance = dev->fontface->glyph->advance.x / (dev->dpi * 64.0);
+	x_advance = g->advance / (dev->dpi * 64.0);
     } else {
 	if (dev->hmi < 0)
 		x_advance = 1.0 / dev->actual_cpi;
@@ -1966,13 +2091,100 @@ escp_handle(escp_t *dev, uint8_t ch)
 }
 
 
+/* Queue a byte (or command) for the interpreter thread. */
+static void
+fifo_put(escp_t *dev, uint16_t val)
+{
+    uint32_t head = dev->fifo_head;
+
+    /*
+     * We cannot drop print data, so if the interpreter is this far
+     * behind, wait for it. The guest does not see this, as status
+     * and ACK are handled by the port code.
+     */
+    while ((head - dev->fifo_tail) >= FIFO_SIZE) {
+	thread_set_event(dev->wake_ev);
+	thread_wait_event(dev->space_ev, 10);
+	thread_reset_event(dev->space_ev);
+    }
+
+    dev->fifo[head & (FIFO_SIZE - 1)] = val;
+    dev->fifo_head = head + 1;
+
+    thread_set_event(dev->wake_ev);
+}
+
+
+/* Interpret everything queued so far. */
+static void
+fifo_drain(escp_t *dev)
+{
+    uint32_t tail = dev->fifo_tail;
+    uint16_t val;
+
+    while (tail != dev->fifo_head) {
+	val = dev->fifo[tail & (FIFO_SIZE - 1)];
+
+	switch (val) {
+		case FIFO_RESET:
+			printer_reset(dev);
+			break;
+
+		case FIFO_FLUSH:
+			if (dev->page->dirty)
+				new_page(dev, 1, 1);
+			break;
+
+		default:
+			dev->auto_lf = !!(val & FIFO_AUTOFEED);
+			escp_handle(dev, (uint8_t)val);
+			break;
+	}
+
+	dev->fifo_tail = ++tail;
+
+	/* Let a waiting emulator thread continue. */
+	if ((tail & 1023) == 0)
+		thread_set_event(dev->space_ev);
+    }
+
+    thread_set_event(dev->space_ev);
+}
+
+
+/*
+ * The interpreter thread.
+ *
+ * All of the command processing, font rendering and the writing
+ * of the page images is done here, so large print jobs do not
+ * slow down the emulator.
+ */
+static void
+escp_thread(void *priv)
+{
+    escp_t *dev = (escp_t *)priv;
+
+    for (;;) {
+	thread_wait_event(dev->wake_ev, -1);
+	thread_reset_event(dev->wake_ev);
+
+	fifo_drain(dev);
+
+	if (dev->stop) break;
+    }
+
+    /* Process anything queued while we were stopping. */
+    fifo_drain(dev);
+}
+
+
 static void
 printer_timeout(void *priv)
 {
     escp_t *dev = (escp_t *)priv;
 
-    if (dev->page->dirty)
-	new_page(dev, 1, 1);
+    /* Eject the page once the interpreter gets to this point. */
+    fifo_put(dev, FIFO_FLUSH);
 
     dev->timeout = 0LL;
 }
@@ -2034,10 +2246,15 @@ escp_init(const lpt_device_t *info)
 	}
     }
 
+    if (ft_users++ == 0)
+	ft_mutex = thread_create_mutex(L"VARCem.FreeType");
+
     /* Initialize a device instance. */
     dev = (escp_t *)mem_alloc(sizeof(escp_t));
     memset(dev, 0x00, sizeof(escp_t));
     dev->name = info->name;
+    dev->glyphs = (glyph_t *)mem_alloc(GLYPH_CACHE * sizeof(glyph_t));
+    memset(dev->glyphs, 0x00, GLYPH_CACHE * sizeof(glyph_t));
 
     /* Create a full pathname for the font files. */
     wcscpy(dev->fontpath, rom_path(PRINTER_PATH));
@@ -2082,6 +2299,13 @@ escp_init(const lpt_device_t *info)
 
     dev->ctrl = 0x04;
 
+    /* Start the interpreter thread. */
+    dev->fifo = (uint16_t *)mem_alloc(FIFO_SIZE * sizeof(uint16_t));
+    dev->fifo_head = dev->fifo_tail = 0;
+    dev->wake_ev = thread_create_event();
+    dev->space_ev = thread_create_event();
+    dev->thread = thread_create(escp_thread, dev);
+
     DEBUG("ESC/P: created virtual page of %ix%i pixels\n",
 				dev->page->w, dev->page->h);
     return(dev);
@@ -2096,6 +2320,20 @@ escp_close(void *priv)
 
     if (dev == NULL) return;
 
+    /* Let the interpreter finish the job and stop. */
+    if (dev->thread != NULL) {
+	dev->stop = 1;
+	thread_set_event(dev->wake_ev);
+	(void)thread_wait(dev->thread, -1);
+	dev->thread = NULL;
+    }
+    if (dev->wake_ev != NULL)
+	thread_destroy_event(dev->wake_ev);
+    if (dev->space_ev != NULL)
+	thread_destroy_event(dev->space_ev);
+    if (dev->fifo != NULL)
+	free(dev->fifo);
+
     if (dev->page != NULL) {
 	/* Print last page if it contains data. */
 	if (dev->page->dirty)
@@ -2107,6 +2345,22 @@ escp_close(void *priv)
 	free(dev->page);
     }
 
+    if (dev->glyphs != NULL) {
+	glyph_flush(dev);
+	free(dev->glyphs);
+    }
+
+    if (dev->fontface) {
+	thread_wait_mutex(ft_mutex);
+	ft_Done_Face(dev->fontface);
+	thread_release_mutex(ft_mutex);
+    }
+
+    if (--ft_users == 0) {
+	thread_close_mutex(ft_mutex);
+	ft_mutex = NULL;
+    }
+
     free(dev);
 }
 
@@ -2120,7 +2374,12 @@ parprnt_reset(escp_t *dev)
     dev->timeout = 0LL;
     dev->ack = 0;
 
-    printer_reset(dev);
+    /*
+     * The interpreter state belongs to the thread. The port lines,
+     * such as AUTOFEED, stay here, and are passed along with each
+     * byte we queue.
+     */
+    fifo_put(dev, FIFO_RESET);
 }
 
 
@@ -2165,8 +2424,11 @@ parprnt_write_ctrl(uint8_t val, void *priv)
      * on the falling edge of the strobe bit.
      */
     if (!(val & 0x01) && (dev->ctrl & 0x01)) {
-	/* Process incoming character. */
-	escp_handle(dev, dev->data);
+	/* OK, we have seen the character. */
+	dev->ack = 1;
+
+	/* Queue it for the interpreter. */
+	fifo_put(dev, dev->data | (dev->autofeed ? FIFO_AUTOFEED : 0));
 
 	dev->timeout = 500000LL * TIMER_USEC;
     }
@@ -13,7 +13,7 @@
  *		  1 - BT-545S ISA;
  *		  2 - BT-958D PCI
  *
- * Version:	@(#)scsi_buslogic.c	1.0.20	2021/04/27
+ * Version:	@(#)scsi_buslogic.c	1.0.21	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -622,7 +622,7 @@ SCSIBIOSRequestSetup(x54x_t *dev, uint8_t *CmdBuf, uint8_t *DataInBuf, uint8_t D
     ESCMD *ESCSICmd = (ESCMD *)CmdBuf;
     scsi_device_t *sd = &scsi_devices[ESCSICmd->TargetId][ESCSICmd->LogicalUnit];
     uint32_t i;
-    uint8_t temp_cdb[12];
+    uint8_t temp_cdb[16];		/* the target may read 16 */
     int target_cdb_len = 12;
     int phase;
 
@@ -669,7 +669,7 @@ SCSIBIOSRequestSetup(x54x_t *dev, uint8_t *CmdBuf, uint8_t *DataInBuf, uint8_t D
 	DEBUG("SCSI Cdb[%i]=%i\n", i, ESCSICmd->CDB[i]);
     }
 
-    memset(temp_cdb, 0, target_cdb_len);
+    memset(temp_cdb, 0, sizeof(temp_cdb));
     if (ESCSICmd->CDBLength <= target_cdb_len)
 	memcpy(temp_cdb, ESCSICmd->CDB, ESCSICmd->CDBLength);
       else
@@ -8,7 +8,7 @@
  *
  *		Definitions for the generic SCSI device command handler.
  *
- * Version:	@(#)scsi_device.h	1.0.8	2019/05/17
+ * Version:	@(#)scsi_device.h	1.0.10	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -83,6 +83,7 @@
 #define GPCMD_CHANGE_DEFINITION 0x40
 #define GPCMD_WRITE_SAME_10		0x41
 #define GPCMD_READ_SUBCHANNEL		0x42
+#define GPCMD_UNMAP			0x42	/* disks only */
 #define GPCMD_READ_TOC_PMA_ATIP		0x43
 #define GPCMD_READ_HEADER		0x44
 #define GPCMD_PLAY_AUDIO_10		0x45
@@ -96,6 +97,7 @@
 #define GPCMD_READ_TRACK_INFORMATION	0x52
 #define GPCMD_MODE_SELECT_10		0x55
 #define GPCMD_MODE_SENSE_10		0x5a
+#define GPCMD_SERVICE_ACTION_IN_16	0x9e	/* disks only */
 #define GPCMD_PLAY_AUDIO_12		0xa5
 #define GPCMD_READ_12			0xa8
 #define GPCMD_WRITE_12			0xaa
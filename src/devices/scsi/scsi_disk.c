@@ -12,7 +12,7 @@
  *		until this is fixed, we return the actual device properties,
  *		and keep the sense data unmodifyable.
  *
- * Version:	@(#)scsi_disk.c	1.0.24	2019/05/17
+ * Version:	@(#)scsi_disk.c	1.0.27	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -74,6 +74,13 @@
 
 #define MAX_BLOCKS_AT_ONCE	340
 
+/* Limits we report for UNMAP in the Block Limits page. */
+#define MAX_UNMAP_BLOCKS	0x00400000
+#define MAX_UNMAP_DESCS		64
+
+/* Service actions of SERVICE ACTION IN (16). */
+#define SAI_READ_CAPACITY_16	0x10
+
 
 /* Table of all SCSI commands and their flags, needed for the new disc change / not ready handler. */
 static const uint8_t command_flags[0x100] = {
@@ -112,7 +119,8 @@ static const uint8_t command_flags[0x100] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0,
     IMPLEMENTED | CHECK_READY,					/* 0x41 */
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    IMPLEMENTED | CHECK_READY | SCSI_ONLY,			/* 0x42 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0,
     IMPLEMENTED,						/* 0x55 */
     0, 0, 0, 0,
@@ -121,7 +129,9 @@ static const uint8_t command_flags[0x100] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    IMPLEMENTED | CHECK_READY | SCSI_ONLY,			/* 0x9E */
+    0,
     0, 0, 0, 0, 0, 0, 0, 0,
     IMPLEMENTED | CHECK_READY,					/* 0xA8 */
     0,
@@ -721,7 +731,11 @@ disk_command(void *p, uint8_t *cdb)
     device_identify_ex[12] = EMU_VERSION[2];
     device_identify_ex[13] = EMU_VERSION[3];
 
-    memcpy(dev->current_cdb, cdb, 12);
+    /* Only group 4 commands (0x80-0x9F) carry a 16-byte CDB. */
+    if ((cdb[0] >> 5) == 4)
+	memcpy(dev->current_cdb, cdb, 16);
+    else
+	memcpy(dev->current_cdb, cdb, 12);
 
     if (cdb[0] != 0) {
 	DEBUG("SCSI DISK %i: Command 0x%02X, Sense Key %02X, Asc %02X, Ascq %02X\n",
@@ -834,6 +848,26 @@ disk_command(void *p, uint8_t *cdb)
 		set_buf_len(dev, BufLen, &alloc_length);
 		set_phase(dev, SCSI_PHASE_DATA_IN);
 
+		/*
+		 * Have the host start reading the sectors now, they
+		 * will be picked up when we get to the data phase.
+		 */
+		if (dev->packet_len > (uint32_t) *BufLen)
+			dev->io_count = *BufLen >> 9;
+		else
+			dev->io_count = dev->requested_blocks;
+		if (dev->io_count > 0) {
+			if (dev->io_size < (dev->io_count << 9)) {
+				hdd_image_sync(dev->id);
+				if (dev->io_buffer != NULL)
+					free(dev->io_buffer);
+				dev->io_size = dev->io_count << 9;
+				dev->io_buffer = (uint8_t *)mem_alloc(dev->io_size);
+			}
+			hdd_image_read_async(dev->id, dev->sector_pos,
+					     dev->io_count, dev->io_buffer);
+		}
+
 		if (dev->requested_blocks > 1)
 			data_command_finish(dev, alloc_length, alloc_length / dev->requested_blocks, alloc_length, 0);
 		else
@@ -945,6 +979,24 @@ disk_command(void *p, uint8_t *cdb)
 			data_command_finish(dev, alloc_length, alloc_length, alloc_length, 1);
 		return;
 
+	case GPCMD_UNMAP:
+		len = (cdb[7] << 8) | cdb[8];
+
+		if ((len < 8) || (*BufLen == 0)) {
+			set_phase(dev, SCSI_PHASE_STATUS);
+			DEBUG("SCSI DISK %i: All done - callback set\n",
+			      dev->id);
+			dev->packet_status = PHASE_COMPLETE;
+			dev->callback = 20 * SCSI_TIME;
+			break;
+		}
+
+		set_phase(dev, SCSI_PHASE_DATA_OUT);
+		set_buf_len(dev, BufLen, &len);
+		dev->total_length = len;
+		data_command_finish(dev, len, len, len, 1);
+		return;
+
 	case GPCMD_MODE_SENSE_6:
 	case GPCMD_MODE_SENSE_10:
 		set_phase(dev, SCSI_PHASE_DATA_IN);
@@ -1038,6 +1090,28 @@ disk_command(void *p, uint8_t *cdb)
 				case 0x00:
 					dev->temp_buffer[idx++] = 0x00;
 					dev->temp_buffer[idx++] = 0x83;
+					dev->temp_buffer[idx++] = 0xb0;
+					dev->temp_buffer[idx++] = 0xb2;
+					break;
+
+				case 0xb0:
+					/* Block Limits, only the UNMAP limits are set. */
+					memset(dev->temp_buffer + idx, 0, 60);
+					dev->temp_buffer[idx + 16] = (MAX_UNMAP_BLOCKS >> 24) & 0xff;
+					dev->temp_buffer[idx + 17] = (MAX_UNMAP_BLOCKS >> 16) & 0xff;
+					dev->temp_buffer[idx + 18] = (MAX_UNMAP_BLOCKS >> 8) & 0xff;
+					dev->temp_buffer[idx + 19] = MAX_UNMAP_BLOCKS & 0xff;
+					dev->temp_buffer[idx + 23] = MAX_UNMAP_DESCS;
+					dev->temp_buffer[idx + 27] = 1;	/* optimal granularity */
+					idx += 60;
+					break;
+
+				case 0xb2:
+					/* Logical Block Provisioning: thin, UNMAP supported. */
+					dev->temp_buffer[idx++] = 0x00;
+					dev->temp_buffer[idx++] = 0x80;	/* LBPU */
+					dev->temp_buffer[idx++] = 0x02;	/* thin provisioned */
+					dev->temp_buffer[idx++] = 0x00;
 					break;
 
 				case 0x83:
@@ -1082,7 +1156,7 @@ disk_command(void *p, uint8_t *cdb)
 			memset(dev->temp_buffer, 0, 8);
 			dev->temp_buffer[0] = 0; /*SCSI HD*/
 			dev->temp_buffer[1] = 0; /*Fixed*/
-			dev->temp_buffer[2] = 0x02; /*SCSI-2 compliant*/
+			dev->temp_buffer[2] = 0x05; /*SPC-3 compliant, for VPD and READ CAPACITY(16)*/
 			dev->temp_buffer[3] = 0x02;
 			dev->temp_buffer[4] = 31;
 			dev->temp_buffer[6] = 1;	/* 16-bit transfers supported */
@@ -1154,6 +1228,40 @@ atapi_out:
 		data_command_finish(dev, len, len, len, 0);
 		break;
 
+	case GPCMD_SERVICE_ACTION_IN_16:
+		if ((cdb[1] & 0x1f) != SAI_READ_CAPACITY_16) {
+			invalid_field(dev);
+			return;
+		}
+
+		max_len = (cdb[10] << 24) | (cdb[11] << 16) | (cdb[12] << 8) | cdb[13];
+
+		if ((max_len <= 0) || (*BufLen == 0)) {
+			set_phase(dev, SCSI_PHASE_STATUS);
+			dev->packet_status = PHASE_COMPLETE;
+			dev->callback = 20 * SCSI_TIME;
+			break;
+		}
+
+		dev->temp_buffer = (uint8_t *)mem_alloc(32);
+		memset(dev->temp_buffer, 0, 32);
+		dev->temp_buffer[4] = (last_sector >> 24) & 0xff;
+		dev->temp_buffer[5] = (last_sector >> 16) & 0xff;
+		dev->temp_buffer[6] = (last_sector >> 8) & 0xff;
+		dev->temp_buffer[7] = last_sector & 0xff;
+		dev->temp_buffer[10] = 2;		/* 512 = 0x0200 */
+		dev->temp_buffer[14] = 0x80;		/* LBPME, we do UNMAP */
+
+		len = 32;
+		if (len > max_len)
+			len = max_len;
+
+		set_buf_len(dev, BufLen, &len);
+
+		set_phase(dev, SCSI_PHASE_DATA_IN);
+		data_command_finish(dev, len, len, len, 0);
+		break;
+
 	default:
 		illegal_opcode(dev);
 		break;
@@ -1169,6 +1277,7 @@ phase_data_in(scsi_disk_t *dev)
 {
     uint8_t *hdbufferb = scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun].cmd_buffer;
     int32_t *BufLen = &scsi_devices[dev->drv->bus_id.scsi.id][dev->drv->bus_id.scsi.lun].buffer_length;
+    uint32_t c;
 
     if (!*BufLen) {
 	DEBUG("scsi_disk_phase_data_in(): Buffer length is 0\n");
@@ -1193,16 +1302,25 @@ phase_data_in(scsi_disk_t *dev)
 	case GPCMD_READ_12:
 		if ((dev->requested_blocks > 0) && (*BufLen > 0)) {
 			if (dev->packet_len > (uint32_t) *BufLen)
-				hdd_image_read(dev->id, dev->sector_pos, *BufLen >> 9, hdbufferb);
+				c = *BufLen >> 9;
 			else
-				hdd_image_read(dev->id, dev->sector_pos, dev->requested_blocks, hdbufferb);
+				c = dev->requested_blocks;
+
+			if ((dev->io_count > 0) && (c == dev->io_count)) {
+				/* Wait for the read started by the command. */
+				hdd_image_sync(dev->id);
+				memcpy(hdbufferb, dev->io_buffer, c << 9);
+			} else
+				hdd_image_read(dev->id, dev->sector_pos, c, hdbufferb);
 		}
+		dev->io_count = 0;
 		break;
 
 	case GPCMD_MODE_SENSE_6:
 	case GPCMD_MODE_SENSE_10:
 	case GPCMD_INQUIRY:
 	case GPCMD_READ_CDROM_CAPACITY:
+	case GPCMD_SERVICE_ACTION_IN_16:
 		DEBUG("scsi_disk_phase_data_in(): Filling buffer (%08X, %08X)\n", hdbufferb, dev->temp_buffer);
 		memcpy(hdbufferb, dev->temp_buffer, *BufLen);
 		free(dev->temp_buffer);
@@ -1252,9 +1370,9 @@ phase_data_out(scsi_disk_t *dev)
 	case GPCMD_WRITE_AND_VERIFY_12:
 		if ((dev->requested_blocks > 0) && (*BufLen > 0)) {
 			if (dev->packet_len > (uint32_t) *BufLen)
-				hdd_image_write(dev->id, dev->sector_pos, *BufLen >> 9, hdbufferb);
+				hdd_image_write_async(dev->id, dev->sector_pos, *BufLen >> 9, hdbufferb);
 			else
-				hdd_image_write(dev->id, dev->sector_pos, dev->requested_blocks, hdbufferb);
+				hdd_image_write_async(dev->id, dev->sector_pos, dev->requested_blocks, hdbufferb);
 		}
 		break;
 
@@ -1283,7 +1401,29 @@ phase_data_out(scsi_disk_t *dev)
 				hdbufferb[6] = (s >> 8) & 0xff;
 				hdbufferb[7] = s & 0xff;
 			}
-			hdd_image_write(dev->id, i, 1, hdbufferb);
+			hdd_image_write_async(dev->id, i, 1, hdbufferb);
+		}
+		break;
+
+	case GPCMD_UNMAP:
+		/* An 8-byte header, followed by 16-byte block descriptors. */
+		if (*BufLen < 8)
+			break;
+		c = (hdbufferb[2] << 8) | hdbufferb[3];
+		if ((c + 8) > (uint32_t) *BufLen)
+			c = *BufLen - 8;
+		for (pos = 8; (uint32_t)(pos + 16) <= (c + 8); pos += 16) {
+			/* We only have 32-bit sector numbers. */
+			if (hdbufferb[pos] | hdbufferb[pos + 1] |
+			    hdbufferb[pos + 2] | hdbufferb[pos + 3])
+				continue;
+			s = (hdbufferb[pos + 4] << 24) | (hdbufferb[pos + 5] << 16) |
+			    (hdbufferb[pos + 6] << 8) | hdbufferb[pos + 7];
+			h = (hdbufferb[pos + 8] << 24) | (hdbufferb[pos + 9] << 16) |
+			    (hdbufferb[pos + 10] << 8) | hdbufferb[pos + 11];
+			DBGLOG(1, "SCSI DISK %i: Unmap %i sectors at %i\n",
+			       dev->id, h, s);
+			hdd_image_trim(dev->id, s, h);
 		}
 		break;
 
@@ -1430,7 +1570,9 @@ scsi_disk_hard_reset(void)
 	dev = (scsi_disk_t *)hdd[c].priv;
 	if (dev == NULL) {
 		dev = (scsi_disk_t *)mem_alloc(sizeof(scsi_disk_t));
-	}
+		hdd[c].priv = dev;
+	} else if (dev->io_buffer != NULL)
+		free(dev->io_buffer);
 	memset(dev, 0x00, sizeof(scsi_disk_t));
 	dev->id = c;
 	dev->drv = &hdd[c];
@@ -1467,6 +1609,8 @@ scsi_disk_close(void)
 	if (dev != NULL) {
 		hdd_image_close(c);
 
+		if (dev->io_buffer != NULL)
+			free(dev->io_buffer);
 		free(dev);
 
 		hdd[c].priv = NULL;
@@ -8,7 +8,7 @@
  *
  *		Emulation of SCSI fixed and removable disks.
  *
- * Version:	@(#)scsi_disk.h	1.0.7	2019/05/17
+ * Version:	@(#)scsi_disk.h	1.0.8	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -64,6 +64,10 @@ typedef struct {
 	     packet_len, pos;
 
     tmrval_t callback;
+
+    uint8_t *io_buffer;		/* sectors being read by the host */
+    uint32_t io_size,
+	     io_count;
 } scsi_disk_t;
 
 
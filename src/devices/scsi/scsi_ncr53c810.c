@@ -10,7 +10,7 @@
  *		NCR and later Symbios and LSI. This controller was designed
  *		for the PCI bus.
  *
- * Version:	@(#)scsi_ncr53c810.c	1.0.17	2019/05/17
+ * Version:	@(#)scsi_ncr53c810.c	1.0.18	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -683,15 +683,15 @@ static int
 ncr53c810_do_command(ncr53c810_t *dev, uint8_t id)
 {
     scsi_device_t *sd;
-    uint8_t buf[12];
+    uint8_t buf[16];
     double period;
     tmrval_t p;
 
-    memset(buf, 0, 12);
-    DMAPageRead(dev->dnad, buf, MIN(12, dev->dbc));
-    if (dev->dbc > 12) {
+    memset(buf, 0, 16);
+    DMAPageRead(dev->dnad, buf, MIN(16, dev->dbc));
+    if (dev->dbc > 16) {
 	DEBUG("(ID=%02i LUN=%02i) SCSI Command 0x%02x: CDB length %i too big\n", id, dev->current_lun, buf[0], dev->dbc);
-	dev->dbc = 12;
+	dev->dbc = 16;
     }
     dev->sfbr = buf[0];
     dev->command_complete = 0;
@@ -12,7 +12,7 @@
  *
  *		These controllers were designed for various buses.
  *
- * Version:	@(#)scsi_x54x.c	1.0.21	2021/04/28
+ * Version:	@(#)scsi_x54x.c	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -955,7 +955,7 @@ scsi_cmd(x54x_t *dev)
     uint8_t phase, bit24 = !!req->Is24bit;
     uint32_t i, SenseBufferAddress;
     int target_data_len, target_cdb_len = 12;
-    uint8_t temp_cdb[12];
+    uint8_t temp_cdb[16];		/* the target may read 16 */
     int32_t *BufLen;
     tmrval_t p;
     scsi_device_t *sd;
@@ -974,7 +974,7 @@ scsi_cmd(x54x_t *dev)
     for (i = 1; i < req->CmdBlock.common.CdbLength; i++)
 	DEBUG("SCSI CDB[%i]=%i\n", i, req->CmdBlock.common.Cdb[i]);
 
-    memset(temp_cdb, 0x00, target_cdb_len);
+    memset(temp_cdb, 0x00, sizeof(temp_cdb));
     if (req->CmdBlock.common.CdbLength <= target_cdb_len) {
 	memcpy(temp_cdb, req->CmdBlock.common.Cdb,
 	       req->CmdBlock.common.CdbLength);
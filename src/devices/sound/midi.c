@@ -8,7 +8,7 @@
  *
  *		MIDI support module, main file.
  *
- * Version:	@(#)midi.c	1.0.14	2021/02/14
+ * Version:	@(#)midi.c	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -55,6 +55,9 @@
 #define SYSEX_SIZE	1024
 #define RAWBUF		1024
 
+#define QUEUE_MASK	(MIDI_QUEUE_SIZE - 1)
+#define QUEUE_HDR	6			/* time(4), length(2) */
+
 
 typedef struct {
     uint8_t	rt_buf[1024],
@@ -238,6 +241,98 @@ midi_poll(void)
 }
 
 
+void
+midi_queue_init(midi_queue_t *q)
+{
+    q->head = q->tail = 0;
+    q->drops = 0;
+}
+
+
+/*
+ * Queue an event for a render thread.
+ *
+ * This is called on the emulator thread, which must never wait for
+ * the renderer. So, if the queue is full, the event is dropped.
+ */
+void
+midi_queue_put(midi_queue_t *q, uint32_t time, const uint8_t *data, int len)
+{
+    uint32_t head = q->head;
+    int i;
+
+    if ((len < 0) || (len > (SYSEX_SIZE + 2))) return;
+
+    if ((uint32_t)(QUEUE_HDR + len) > (MIDI_QUEUE_SIZE - (head - q->tail))) {
+	q->drops++;
+	return;
+    }
+
+    q->data[head++ & QUEUE_MASK] = (uint8_t)time;
+    q->data[head++ & QUEUE_MASK] = (uint8_t)(time >> 8);
+    q->data[head++ & QUEUE_MASK] = (uint8_t)(time >> 16);
+    q->data[head++ & QUEUE_MASK] = (uint8_t)(time >> 24);
+    q->data[head++ & QUEUE_MASK] = (uint8_t)len;
+    q->data[head++ & QUEUE_MASK] = (uint8_t)(len >> 8);
+    for (i = 0; i < len; i++)
+	q->data[head++ & QUEUE_MASK] = data[i];
+
+    /* Only now make it visible to the renderer. */
+    q->head = head;
+}
+
+
+/*
+ * Render one segment on the render thread.
+ *
+ * The segment covers 'len' emulator samples starting at 'start', and
+ * 'frames' frames at the synth's own rate. Output is rendered in runs
+ * up to each queued event, which is then played, so every event takes
+ * effect at its own position in the segment.
+ */
+void
+midi_queue_render(midi_queue_t *q, uint32_t start, int len, int frames,
+		  void (*render)(int pos, int frames),
+		  void (*play)(uint8_t *data, int len))
+{
+    uint8_t data[SYSEX_SIZE + 2];
+    uint32_t tail = q->tail;
+    uint32_t time;
+    int32_t off;
+    int done = 0;
+    int pos, n, i;
+
+    while (tail != q->head) {
+	time = q->data[tail & QUEUE_MASK] |
+	       (q->data[(tail + 1) & QUEUE_MASK] << 8) |
+	       (q->data[(tail + 2) & QUEUE_MASK] << 16) |
+	       ((uint32_t)q->data[(tail + 3) & QUEUE_MASK] << 24);
+
+	/* Stop at the first event of a later segment. */
+	off = (int32_t)(time - start);
+	if (off >= len) break;
+
+	n = q->data[(tail + 4) & QUEUE_MASK] |
+	    (q->data[(tail + 5) & QUEUE_MASK] << 8);
+	tail += QUEUE_HDR;
+	for (i = 0; i < n; i++)
+		data[i] = q->data[tail++ & QUEUE_MASK];
+	q->tail = tail;
+
+	pos = (off <= 0) ? 0 : (off * frames) / len;
+	if (pos > done) {
+		render(done, pos - done);
+		done = pos;
+	}
+
+	play(data, n);
+    }
+
+    if (done < frames)
+	render(done, frames - done);
+}
+
+
 void
 play_msg(uint8_t *msg)
 {
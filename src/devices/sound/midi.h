@@ -8,7 +8,7 @@
  *
  *		Definitions for the MIDI module.
  *
- * Version:	@(#)midi.h	1.0.7	2020/07/11
+ * Version:	@(#)midi.h	1.0.8	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -49,6 +49,9 @@
 #endif
 
 
+#define MIDI_QUEUE_SIZE		16384	/* must be a power of 2 */
+
+
 typedef struct {
     void	(*play_sysex)(uint8_t *sysex, unsigned int len);
     void	(*play_msg)(uint8_t *msg);
@@ -56,6 +59,14 @@ typedef struct {
     int		(*write)(uint8_t val);
 } midi_device_t;
 
+/* Timestamped events, passed from the emulator to a render thread. */
+typedef struct {
+    volatile uint32_t head,			/* written by emulator */
+		tail;				/* written by render thread */
+    uint32_t	drops;
+    uint8_t	data[MIDI_QUEUE_SIZE];
+} midi_queue_t;
+
 
 #ifdef EMU_DEVICE_H
 extern const device_t	system_midi_device;
@@ -85,6 +96,14 @@ extern void		midi_close(void);
 extern void		midi_write(uint8_t val);
 extern void		midi_poll(void);
 
+extern void		midi_queue_init(midi_queue_t *q);
+extern void		midi_queue_put(midi_queue_t *q, uint32_t time,
+				       const uint8_t *data, int len);
+extern void		midi_queue_render(midi_queue_t *q, uint32_t start,
+					  int len, int frames,
+					  void (*render)(int pos, int frames),
+					  void (*play)(uint8_t *data, int len));
+
 #ifdef USE_FLUIDSYNTH
 extern void     	fluidsynth_global_init(void);
 #endif
@@ -17,7 +17,7 @@
  *		website (for 32bit and 64bit Windows) are working, and
  *		need no additional support files other than sound fonts.
  *
- * Version:	@(#)midi_fluidsynth.c	1.0.20	2021/03/16
+ * Version:	@(#)midi_fluidsynth.c	1.0.21	2026/10/19
  *
  *		Code borrowed from scummvm.
  *
@@ -142,7 +142,14 @@ typedef struct fluidsynth {
     float		*buffer;
     int16_t		*buffer_int16;
     int			midi_pos;
+    uint32_t		midi_clock;
+    volatile uint32_t	segs_due;
     volatile int	on;
+
+    float		*render_buf;
+    int16_t		*render_buf16;
+
+    midi_queue_t	queue;
 } fluidsynth_t;
 
 
@@ -161,20 +168,48 @@ fluidsynth_poll(void)
 {
     fluidsynth_t *data = &fsdev;
 
+    data->midi_clock++;
+
     data->midi_pos++;
     if (data->midi_pos == 48000/RENDER_RATE) {
 	data->midi_pos = 0;
+	data->segs_due++;
 	thread_set_event(data->event);
     }
 }
 
 
+/* Render part of the current segment (render thread.) */
+static void
+fluidsynth_render(int pos, int len)
+{
+    fluidsynth_t *data = &fsdev;
+    float *buf;
+    int16_t *buf16;
+
+    if (data->synth == NULL) return;
+
+    if (config.sound_is_float) {
+	buf = data->render_buf + (pos * 2);
+	f_fluid_synth_write_float(data->synth, len, buf, 0, 2, buf, 1, 2);
+    } else {
+	buf16 = data->render_buf16 + (pos * 2);
+	f_fluid_synth_write_s16(data->synth, len, buf16, 0, 2, buf16, 1, 2);
+    }
+}
+
+
+static void	fluidsynth_play(uint8_t *msg, int len);
+
+
 static void
 fluidsynth_thread(void *param)
 {
     fluidsynth_t *data = (fluidsynth_t*)param;
+    uint32_t seg = 0, seg_start = 0;
     int buf_pos = 0;
     int buf_size = data->buf_size / BUFFER_SEGMENTS;
+    int frames = data->samplerate / RENDER_RATE;
 
     thread_set_event(data->start_event);
 
@@ -182,24 +217,27 @@ fluidsynth_thread(void *param)
 	thread_wait_event(data->event, -1);
 	thread_reset_event(data->event);
 
-	if (config.sound_is_float) {
-		float *buf = (float*)((uint8_t*)data->buffer + buf_pos);
-		memset(buf, 0, buf_size);
-		if (data->synth)
-			f_fluid_synth_write_float(data->synth, buf_size/(2 * sizeof(float)), buf, 0, 2, buf, 1, 2);
-		buf_pos += buf_size;
-		if (buf_pos >= data->buf_size) {
-			openal_buffer_midi(data->buffer, data->buf_size / sizeof(float));
-			buf_pos = 0;
+	/* Render every segment the emulator has finished. */
+	while (data->on && (seg != data->segs_due)) {
+		if (config.sound_is_float) {
+			data->render_buf = (float*)((uint8_t*)data->buffer + buf_pos);
+			memset(data->render_buf, 0, buf_size);
+		} else {
+			data->render_buf16 = (int16_t*)((uint8_t*)data->buffer_int16 + buf_pos);
+			memset(data->render_buf16, 0, buf_size);
 		}
-	} else {
-		int16_t *buf = (int16_t*)((uint8_t*)data->buffer_int16 + buf_pos);
-		memset(buf, 0, buf_size);
-		if (data->synth)
-			f_fluid_synth_write_s16(data->synth, buf_size/(2 * sizeof(int16_t)), buf, 0, 2, buf, 1, 2);
+
+		midi_queue_render(&data->queue, seg_start, 48000/RENDER_RATE,
+				  frames, fluidsynth_render, fluidsynth_play);
+		seg_start += 48000/RENDER_RATE;
+		seg++;
+
 		buf_pos += buf_size;
 		if (buf_pos >= data->buf_size) {
-			openal_buffer_midi(data->buffer_int16, data->buf_size / sizeof(int16_t));
+			if (config.sound_is_float)
+				openal_buffer_midi(data->buffer, data->buf_size / sizeof(float));
+			else
+				openal_buffer_midi(data->buffer_int16, data->buf_size / sizeof(int16_t));
 			buf_pos = 0;
 		}
 	}
@@ -207,8 +245,9 @@ fluidsynth_thread(void *param)
 }
 
 
+/* Play a queued event (render thread.) */
 static void
-fluidsynth_msg(uint8_t *msg)
+fluidsynth_play(uint8_t *msg, int len)
 {
     fluidsynth_t *data = &fsdev;
     uint32_t val = *((uint32_t*)msg);
@@ -217,6 +256,12 @@ fluidsynth_msg(uint8_t *msg)
     uint8_t cmd    = (uint8_t) (val & 0xF0);
     uint8_t chan   = (uint8_t) (val & 0x0F);
 
+    /* SysEx always starts with 0xF0, which is never a short message. */
+    if (msg[0] == 0xf0) {
+	f_fluid_synth_sysex(data->synth, (const char *)msg, len, 0, 0, 0, 0);
+	return;
+    }
+
     switch (cmd) {
 	case 0x80:      /* Note Off */
 		f_fluid_synth_noteoff(data->synth, chan, param1);
@@ -255,11 +300,20 @@ fluidsynth_msg(uint8_t *msg)
 
 
 static void
-fluidsynth_sysex(uint8_t *data, unsigned int len)
+fluidsynth_msg(uint8_t *msg)
 {
-    fluidsynth_t* d = &fsdev;
+    fluidsynth_t *data = &fsdev;
 
-    f_fluid_synth_sysex(d->synth, (const char *)data, len, 0, 0, 0, 0);
+    midi_queue_put(&data->queue, data->midi_clock, msg, 4);
+}
+
+
+static void
+fluidsynth_sysex(uint8_t *msg, unsigned int len)
+{
+    fluidsynth_t *data = &fsdev;
+
+    midi_queue_put(&data->queue, data->midi_clock, msg, len);
 }
 
 
@@ -352,6 +406,8 @@ fluidsynth_init(const device_t *info, UNUSED(void *parent))
 
     midi_init(dev);
 
+    midi_queue_init(&data->queue);
+
     data->on = 1;
 
     data->start_event = thread_create_event();
@@ -8,7 +8,7 @@
  *
  *		Interface to the MuNT32 MIDI synthesizer.
  *
- * Version:	@(#)midi_mt32.c	1.0.15	2021/03/16
+ * Version:	@(#)midi_mt32.c	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -169,6 +169,11 @@ static int		buf_size = 0;
 static float		*buffer = NULL;
 static int16_t		*buffer_int16 = NULL;
 static int		midi_pos = 0;
+static uint32_t		midi_clock = 0;
+static volatile uint32_t segs_due = 0;
+static midi_queue_t	queue;
+static float		*render_buf = NULL;
+static int16_t		*render_buf16 = NULL;
 static const mt32emu_report_handler_i handler = { &handler_v0 };
 static mt32emu_context	context = NULL;
 static int		mtroms_present[2] = {-1, -1};
@@ -205,45 +210,76 @@ mt32_stream_int16(int16_t *stream, int len)
 static void
 mt32_poll(void)
 {
+    midi_clock++;
+
     midi_pos++;
     if (midi_pos == (48000 / RENDER_RATE)) {
 	midi_pos = 0;
+	segs_due++;
 	thread_set_event(event);
     }
 }
 
 
+/* Render part of the current segment (render thread.) */
+static void
+mt32_render(int pos, int len)
+{
+    if (config.sound_is_float)
+	mt32_stream(render_buf + (pos * 2), len);
+    else
+	mt32_stream_int16(render_buf16 + (pos * 2), len);
+}
+
+
+/* Play a queued event (render thread.) */
+static void
+mt32_play(uint8_t *data, int len)
+{
+    if (context == NULL) return;
+
+    /* SysEx always starts with 0xF0, which is never a short message. */
+    if (data[0] == 0xf0)
+	mt32_check("mt32emu_play_sysex", FUNC(play_sysex)(context, data, len), MT32EMU_RC_OK);
+    else
+	mt32_check("mt32emu_play_msg", FUNC(play_msg)(context, *(uint32_t *)data), MT32EMU_RC_OK);
+}
+
+
 static void
 mt32_thread(void *param)
 {
+    uint32_t seg = 0, seg_start = 0;
     int buf_pos = 0;
     int bsize = buf_size / BUFFER_SEGMENTS;
-    float *buf;
-    int16_t *buf16;
+    int frames = samplerate / RENDER_RATE;
 
     thread_set_event(start_event);
     while (mt32_on) {
 	thread_wait_event(event, -1);
 	thread_reset_event(event);
 
-	if (config.sound_is_float) {
-		buf = (float *) ((uint8_t*)buffer + buf_pos);
-
-		memset(buf, 0, bsize);
-		mt32_stream(buf, bsize / (2 * sizeof(float)));
-		buf_pos += bsize;
-		if (buf_pos >= buf_size) {
-			openal_buffer_midi(buffer, buf_size / sizeof(float));
-			buf_pos = 0;
+	/* Render every segment the emulator has finished. */
+	while (mt32_on && (seg != segs_due)) {
+		if (config.sound_is_float) {
+			render_buf = (float *) ((uint8_t*)buffer + buf_pos);
+			memset(render_buf, 0, bsize);
+		} else {
+			render_buf16 = (int16_t *) ((uint8_t*)buffer_int16 + buf_pos);
+			memset(render_buf16, 0, bsize);
 		}
-	} else {
-		buf16 = (int16_t *) ((uint8_t*)buffer_int16 + buf_pos);
 
-		memset(buf16, 0, bsize);
-		mt32_stream_int16(buf16, bsize / (2 * sizeof(int16_t)));
+		midi_queue_render(&queue, seg_start, 48000 / RENDER_RATE,
+				  frames, mt32_render, mt32_play);
+		seg_start += 48000 / RENDER_RATE;
+		seg++;
+
 		buf_pos += bsize;
 		if (buf_pos >= buf_size) {
-			openal_buffer_midi(buffer_int16, buf_size / sizeof(int16_t));
+			if (config.sound_is_float)
+				openal_buffer_midi(buffer, buf_size / sizeof(float));
+			else
+				openal_buffer_midi(buffer_int16, buf_size / sizeof(int16_t));
 			buf_pos = 0;
 		}
 	}
@@ -254,16 +290,14 @@ mt32_thread(void *param)
 static void
 mt32_msg(uint8_t *val)
 {
-    if (context)
-	mt32_check("mt32emu_play_msg", FUNC(play_msg)(context, *(uint32_t*)val), MT32EMU_RC_OK);
+    midi_queue_put(&queue, midi_clock, val, 4);
 }
 
 
 static void
 mt32_sysex(uint8_t* data, unsigned int len)
 {
-    if (context)
-	mt32_check("mt32emu_play_sysex", FUNC(play_sysex)(context, data, len), MT32EMU_RC_OK);
+    midi_queue_put(&queue, midi_clock, data, len);
 }
 
 
@@ -328,6 +362,11 @@ mt32emu_init(wchar_t *control_rom, wchar_t *pcm_rom)
 
     midi_init(dev);
 
+    midi_queue_init(&queue);
+    midi_clock = 0;
+    midi_pos = 0;
+    segs_due = 0;
+
     mt32_on = 1;
 
     start_event = thread_create_event();
@@ -8,7 +8,7 @@
  *
  *		Interface to the OpenAL sound processing library.
  *
- * Version:	@(#)openal.c	1.0.22	2021/03/19
+ * Version:	@(#)openal.c	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -77,6 +77,9 @@ static ALuint		buffers[4],		/* front and back buffers */
 			source[3];		/* audio source */
 static int		nbuffers,
 			nsources;
+static int		queued[3],		/* buffers pending playback */
+			underruns[3],		/* source ran dry */
+			drops[3];		/* no free buffer, data lost */
 static void		*openal_handle = NULL;	/* handle to (open) DLL */
 
 /* Pointers to the real functions. */
@@ -394,10 +397,16 @@ openal_buffer_common(void *buf, uint8_t src, int size, int freq)
     f_alGetSourcei(source[src], AL_SOURCE_STATE, &state);
 
     if (state == 0x1014) {
+	/* Source stopped because it ran out of data. */
+	underruns[src]++;
 	f_alSourcePlay(source[src]);
     }
 
+    f_alGetSourcei(source[src], AL_BUFFERS_QUEUED, &queued[src]);
     f_alGetSourcei(source[src], AL_BUFFERS_PROCESSED, &processed);
+    queued[src] -= processed;
+    if (processed < 1)
+	drops[src]++;
     if (processed >= 1) {
 	gain = pow(10.0, (double)config.sound_gain / 20.0);
 	f_alListenerf(AL_GAIN, (float)gain);
@@ -437,6 +446,20 @@ openal_buffer_midi(void *buf, uint32_t size)
 }
 
 
+/* Report queue depth and error counts for one of our sources. */
+void
+openal_get_stats(int src, int *depth, int *under, int *dropped)
+{
+#ifdef USE_OPENAL
+    *depth = queued[src];
+    *under = underruns[src];
+    *dropped = drops[src];
+#else
+    *depth = *under = *dropped = 0;
+#endif
+}
+
+
 void
 openal_set_midi(int freq, int buf_size)
 {
@@ -8,7 +8,7 @@
  *
  *		Implementation of Emu8000 emulator.
  *
- * Version:	@(#)snd_emu8k.c	1.0.18	2021/03/16
+ * Version:	@(#)snd_emu8k.c	1.0.19	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1670,52 +1670,58 @@ int32_t emu8k_reverb_damper_work(emu8k_reverb_combfilter_t* comb, int32_t in)
         return comb->filterstore;
 }
 
+/* Run one reflection over a whole block, accumulating into outbuf. */
+static void emu8k_reverb_comb_block(emu8k_reverb_combfilter_t* comb, const int32_t *in, int32_t *outbuf, int count)
+{
+        int pos;
+        for (pos = 0; pos < count; pos++)
+                outbuf[pos] += emu8k_reverb_comb_work(comb, in[pos]);
+}
+
 /* TODO: This is not a correct emulation, just a workalike implementation. */
 void emu8k_work_reverb(int32_t *inbuf, int32_t *outbuf, emu8k_reverb_eng_t *engine, int count)
 {
+        int32_t *in = engine->work_in;
+        int32_t *in2 = engine->work_in2;
+        int32_t *dat1 = engine->work_l;
+        int32_t *dat2 = engine->work_r;
         int pos;
+
+        for (pos = 0; pos < count; pos++)
+        {
+                in[pos] = emu8k_reverb_damper_work(&engine->damper, inbuf[pos]);
+                in2[pos] = (in[pos] * engine->refl_in_amp) >> 8;
+        }
+
+        /* The reflections are independent of each other, so run each one
+         * over the whole block instead of interleaving all six per sample. */
+        memset(dat1, 0, count * sizeof(int32_t));
         if (engine->link_return_type)
         {
-                for (pos = 0; pos < count; pos++)
-                {   
-                        int32_t dat1, dat2, in, in2;
-                        in = emu8k_reverb_damper_work(&engine->damper, inbuf[pos]);
-                        in2 = (in * engine->refl_in_amp) >> 8;
-                        dat2  = emu8k_reverb_comb_work(&engine->reflections[0], in2);
-                        dat2 += emu8k_reverb_comb_work(&engine->reflections[1], in2);
-                        dat1  = emu8k_reverb_comb_work(&engine->reflections[2], in2);
-                        dat2 += emu8k_reverb_comb_work(&engine->reflections[3], in2);
-                        dat1 += emu8k_reverb_comb_work(&engine->reflections[4], in2);
-                        dat2 += emu8k_reverb_comb_work(&engine->reflections[5], in2);
-                        
-                        dat1 += (emu8k_reverb_tail_work(&engine->tailL,&engine->allpass[0], in+dat1)*engine->link_return_amp) >> 8;
-                        dat2 += (emu8k_reverb_tail_work(&engine->tailR,&engine->allpass[4], in+dat2)*engine->link_return_amp) >> 8;
-                        
-                        (*outbuf++) += (dat1 * engine->out_mix) >> 8;
-                        (*outbuf++) += (dat2 * engine->out_mix) >> 8;
-                }
+                memset(dat2, 0, count * sizeof(int32_t));
+                emu8k_reverb_comb_block(&engine->reflections[0], in2, dat2, count);
+                emu8k_reverb_comb_block(&engine->reflections[1], in2, dat2, count);
+                emu8k_reverb_comb_block(&engine->reflections[2], in2, dat1, count);
+                emu8k_reverb_comb_block(&engine->reflections[3], in2, dat2, count);
+                emu8k_reverb_comb_block(&engine->reflections[4], in2, dat1, count);
+                emu8k_reverb_comb_block(&engine->reflections[5], in2, dat2, count);
         }
         else
         { 
-                for (pos = 0; pos < count; pos++)
-                {   
-                        int32_t dat1, dat2, in, in2;
-                        in = emu8k_reverb_damper_work(&engine->damper, inbuf[pos]);
-                        in2 = (in * engine->refl_in_amp) >> 8;
-                        dat1  = emu8k_reverb_comb_work(&engine->reflections[0], in2);
-                        dat1 += emu8k_reverb_comb_work(&engine->reflections[1], in2);
-                        dat1 += emu8k_reverb_comb_work(&engine->reflections[2], in2);
-                        dat1 += emu8k_reverb_comb_work(&engine->reflections[3], in2);
-                        dat1 += emu8k_reverb_comb_work(&engine->reflections[4], in2);
-                        dat1 += emu8k_reverb_comb_work(&engine->reflections[5], in2);
-                        dat2 = dat1;
-                        
-                        dat1 += (emu8k_reverb_tail_work(&engine->tailL,&engine->allpass[0], in+dat1)*engine->link_return_amp) >> 8;
-                        dat2 += (emu8k_reverb_tail_work(&engine->tailR,&engine->allpass[4], in+dat2)*engine->link_return_amp) >> 8;
-                        
-                        (*outbuf++) += (dat1 * engine->out_mix) >> 8;
-                        (*outbuf++) += (dat2 * engine->out_mix) >> 8;
-                }
+                for (pos = 0; pos < 6; pos++)
+                        emu8k_reverb_comb_block(&engine->reflections[pos], in2, dat1, count);
+                memcpy(dat2, dat1, count * sizeof(int32_t));
+        }
+
+        for (pos = 0; pos < count; pos++)
+                dat1[pos] += (emu8k_reverb_tail_work(&engine->tailL,&engine->allpass[0], in[pos]+dat1[pos])*engine->link_return_amp) >> 8;
+        for (pos = 0; pos < count; pos++)
+                dat2[pos] += (emu8k_reverb_tail_work(&engine->tailR,&engine->allpass[4], in[pos]+dat2[pos])*engine->link_return_amp) >> 8;
+
+        for (pos = 0; pos < count; pos++)
+        {
+                (*outbuf++) += (dat1[pos] * engine->out_mix) >> 8;
+                (*outbuf++) += (dat2[pos] * engine->out_mix) >> 8;
         }
 }
 void emu8k_work_eq(int32_t *inoutbuf, int count)
@@ -1750,7 +1756,8 @@ void emu8k_update(emu8k_t *emu8k)
 
         int32_t *buf;
         emu8k_voice_t* emu_voice;
-        int pos;
+        int count = new_pos - emu8k->pos;
+        int pos, out;
         int c;
 
         /* Clean the buffers since we will accumulate into them. */
@@ -1764,10 +1771,37 @@ void emu8k_update(emu8k_t *emu8k)
         {
                 emu_voice = &emu8k->voice[c];
                 buf = &emu8k->buffer[emu8k->pos*2];
-                
-                for (pos = emu8k->pos; pos < new_pos; pos++)
+
+                /* A silent voice with no envelopes running only has its
+                 * oscillator address moving, so skip everything else. */
+                if (!emu_voice->env_engine_on && !emu_voice->cvcf_curr_volume &&
+                    !emu_voice->vtft_vol_target && !emu_voice->volumeslide.last)
+                {
+                        for (pos = 0; pos < count; pos++)
+                        {
+                                emu_voice->addr.addr += ((uint64_t)emu_voice->cpf_curr_pitch) << 18;
+                                if (emu_voice->addr.addr >= emu_voice->loop_end.addr)
+                                {
+                                        emu_voice->addr.int_address -= (emu_voice->loop_end.int_address - emu_voice->loop_start.int_address);
+                                        emu_voice->addr.int_address &= EMU8K_MEM_ADDRESS_MASK;
+                                }
+                                emu_voice->cpf_curr_pitch = emu_voice->ptrx_pit_target;
+                        }
+                        emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
+
+                        emu_voice->ccca = (((uint32_t)emu_voice->ccca_qcontrol) << 24) | emu_voice->addr.int_address;
+                        emu_voice->cpf_curr_frac_addr = emu_voice->addr.fract_address;
+                        continue;
+                }
+
+                out = (emu8k->hwcf3 & 0x04) && !CCCA_DMA_ACTIVE(emu_voice->ccca);
+
+                /* First pass: run the oscillator, filter and envelopes,
+                 * which all carry state from one sample to the next. */
+                for (pos = 0; pos < count; pos++)
                 {
-                        int32_t dat;
+                        int32_t dat = 0;
+                        int32_t vol = 0;
 
                         if (emu_voice->cvcf_curr_volume) {
                                 /* Waveform oscillator */
@@ -1853,22 +1887,11 @@ void emu8k_update(emu8k_t *emu8k)
                         #endif
                                 }
                         
-                                if (( emu8k->hwcf3 & 0x04) && !CCCA_DMA_ACTIVE(emu_voice->ccca)) {
-                                        /*volume and pan*/
-                                        dat = (dat * emu_voice->cvcf_curr_volume) >> 16;
-
-                                        (*buf++) += (dat * emu_voice->vol_l) >> 8;
-                                        (*buf++) += (dat * emu_voice->vol_r) >> 8;
-
-                                        /* Effects section */
-                                        if (emu_voice->ptrx_revb_send > 0) {
-                                                emu8k->reverb_in_buffer[pos]+=(dat*emu_voice->ptrx_revb_send) >> 8;
-                                        }
-                                        if (emu_voice->csl_chor_send > 0) {
-                                                emu8k->chorus_in_buffer[pos]+=(dat*emu_voice->csl_chor_send) >> 8;
-                                        }
-                                }
+                                if (out)
+                                        vol = emu_voice->cvcf_curr_volume;
                         }
+                        emu8k->voice_dat[pos] = dat;
+                        emu8k->voice_vol[pos] = vol;
 
                         if ( emu_voice->env_engine_on)
                         {
@@ -2108,6 +2131,41 @@ I've recopilated these sentences to get an idea of how to loop
                         emu_voice->cvcf_curr_volume = emu8k_vol_slide(&emu_voice->volumeslide,emu_voice->vtft_vol_target);
                         emu_voice->cvcf_curr_filt_ctoff = emu_voice->vtft_filter_target;
                 }
+
+                /* Second pass: volume, pan and effect sends. These have no
+                 * dependencies between samples, so the compiler can run
+                 * them several samples at a time. */
+                if (out)
+                {
+                        const int32_t vol_l = emu_voice->vol_l;
+                        const int32_t vol_r = emu_voice->vol_r;
+                        const int32_t revb = emu_voice->ptrx_revb_send;
+                        const int32_t chor = emu_voice->csl_chor_send;
+                        int32_t *dat = emu8k->voice_dat;
+                        const int32_t *vol = emu8k->voice_vol;
+                        int32_t *rev_in = &emu8k->reverb_in_buffer[emu8k->pos];
+                        int32_t *chor_in = &emu8k->chorus_in_buffer[emu8k->pos];
+
+                        /*volume and pan*/
+                        for (pos = 0; pos < count; pos++)
+                        {
+                                dat[pos] = (dat[pos] * vol[pos]) >> 16;
+                                buf[pos*2] += (dat[pos] * vol_l) >> 8;
+                                buf[pos*2+1] += (dat[pos] * vol_r) >> 8;
+                        }
+
+                        /* Effects section */
+                        if (revb > 0)
+                        {
+                                for (pos = 0; pos < count; pos++)
+                                        rev_in[pos] += (dat[pos] * revb) >> 8;
+                        }
+                        if (chor > 0)
+                        {
+                                for (pos = 0; pos < count; pos++)
+                                        chor_in[pos] += (dat[pos] * chor) >> 8;
+                        }
+                }
                 
                 /* Update EMU voice registers. */
                 emu_voice->ccca = (((uint32_t)emu_voice->ccca_qcontrol) << 24) | emu_voice->addr.int_address;
@@ -8,7 +8,7 @@
  *
  *		Definitions for the Emu8K emulator.
  *
- * Version:	@(#)snd_emu8k.h	1.0.3	2019/05/17
+ * Version:	@(#)snd_emu8k.h	1.0.4	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -197,6 +197,12 @@ typedef struct emu8k_reverb_eng_t {
         emu8k_reverb_combfilter_t tailR;
         
         emu8k_reverb_combfilter_t damper;
+
+        /* Work buffers for block processing. */
+        int32_t work_in[SOUNDBUFLEN];
+        int32_t work_in2[SOUNDBUFLEN];
+        int32_t work_l[SOUNDBUFLEN];
+        int32_t work_r[SOUNDBUFLEN];
 } emu8k_reverb_eng_t;
 
 typedef struct emu8k_slide_t {
@@ -419,6 +425,10 @@ typedef struct emu8k_t
         
         int pos;
         int32_t buffer[SOUNDBUFLEN * 2];
+
+        /* Per-voice work buffers for block rendering. */
+        int32_t voice_dat[SOUNDBUFLEN];
+        int32_t voice_vol[SOUNDBUFLEN];
 } emu8k_t;
 
 
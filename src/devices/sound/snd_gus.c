@@ -8,13 +8,13 @@
  *
  *		Implementation of the Gravis UltraSound sound device.
  *
- * Version:	@(#)snd_gus.c	1.0.19	2021/06/05
+ * Version:	@(#)snd_gus.c	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
  *		Sarah Walker, <tommowalker@tommowalker.co.uk>
  *
- *		Copyright 2017-2021 Fred N. van Kempen.
+ *		Copyright 2017-2026 Fred N. van Kempen.
  *		Copyright 2016-2018 Miran Grca.
  *		Copyright 2008-2021 Sarah Walker.
  *
@@ -44,9 +44,11 @@
 #define dbglog sound_card_log
 #include "../../emu.h"
 #include "../../timer.h"
+#include "../../cpu/cpu.h"
 #include "../../io.h"
 #include "../../device.h"
 #include "../../plat.h"
+#include "../system/clk.h"
 #include "../system/dma.h"
 #include "../system/nmi.h"
 #include "../system/pic.h"
@@ -57,6 +59,10 @@
 #endif
 
 
+#define GUS_BLOCK	256			/* max samples per timer event */
+#define GUS_MIX_LEN	SOUND_NATIVE_MAX	/* voice-rate samples per poll */
+
+
 enum {
     MIDI_INT_RECEIVE = 0x01,
     MIDI_INT_TRANSMIT = 0x02,
@@ -117,18 +123,17 @@ typedef struct {
     int		voices;
     uint8_t	dmactrl;
 
-    int32_t	out_l,
-		out_r;
-
     tmrval_t	samp_timer,
 		samp_latch;
+    int		samp_pend;
+
+    int		mix_cnt;
+    int32_t	mix_l[GUS_MIX_LEN],
+		mix_r[GUS_MIX_LEN];
 
     uint8_t	*ram;
     uint32_t gus_end_ram;
 
-    int		pos;
-    int16_t	buffer[2][SOUNDBUFLEN];
-
     int		irqnext;
 
     tmrval_t	timer_1,
@@ -180,7 +185,7 @@ static const int gusfreqs[] = {
     28063, 26843, 25725, 24696, 23746, 22866, 22050, 21289,
     20580, 19916, 19293
 };
-static double	vol16bit[4096];
+static int32_t	vol16bit[4096];
 
 
 static void
@@ -263,6 +268,279 @@ midi_update_int_status(gus_t *dev)
 }
 
 
+/*
+ * Work out how many samples from now the next wave or ramp IRQ will
+ * be raised, so the block timer can be armed to fire exactly there.
+ * Voices without their IRQ enabled never need a timer event; they
+ * are simply rendered on the next catch-up.
+ */
+static int
+next_event(gus_t *dev)
+{
+    int64_t dist, k, len = GUS_BLOCK;
+    uint32_t inc;
+    int d;
+
+    if ((dev->reset & 3) != 3)
+	return(GUS_BLOCK);
+
+    for (d = 0; d < 32; d++) {
+	inc = dev->freq[d] >> 1;
+	if (!(dev->ctrl[d] & 3) && (dev->ctrl[d] & 0x20) &&
+	    !dev->waveirqs[d] && inc) {
+		if (dev->ctrl[d] & 0x40)
+			dist = (int64_t)dev->cur[d] - dev->start[d];
+		else
+			dist = (int64_t)dev->end[d] - dev->cur[d];
+		k = (dist <= 0) ? 1 : (dist + inc - 1) / inc;
+		if (k < len)
+			len = k;
+	}
+
+	if (!(dev->rctrl[d] & 3) && (dev->rctrl[d] & 0x20) &&
+	    !dev->rampirqs[d] && dev->rfreq[d]) {
+		if (dev->rctrl[d] & 0x40)
+			dist = (int64_t)dev->rcur[d] - dev->rstart[d];
+		else
+			dist = (int64_t)dev->rend[d] - dev->rcur[d];
+		k = (dist <= 0) ? 1 : (dist + dev->rfreq[d] - 1) / dev->rfreq[d];
+		if (k < len)
+			len = k;
+	}
+    }
+
+    return((int)len);
+}
+
+
+/* Render a block of samples for one voice, adding into the mix. */
+static int
+voice_render(gus_t *dev, int d, int32_t *bl, int32_t *br, int len)
+{
+    uint32_t cur = dev->cur[d];
+    uint32_t inc = dev->freq[d] >> 1;
+    int rcur = dev->rcur[d];
+    uint8_t ctrl = dev->ctrl[d];
+    uint8_t rctrl = dev->rctrl[d];
+    int interp = !(dev->freq[d] >> 10);
+    int pan_l = dev->pan_l[d];
+    int pan_r = dev->pan_r[d];
+    int update_irqs = 0;
+    uint32_t addr;
+    int32_t vl;
+    int16_t v;
+    int diff, i;
+
+    for (i = 0; i < len; i++) {
+	if (!(ctrl & 3)) {
+		if (ctrl & 4) {
+			addr = cur >> 9;
+			addr = (addr & 0xC0000) | ((addr << 1) & 0x3FFFE);
+
+			if (interp) {
+				vl = (int16_t)(int8_t)((dev->ram[(addr + 1) & 0xFFFFF] ^ 0x80) - 0x80) * (511 - (cur & 511));
+				vl += (int16_t)(int8_t)((dev->ram[(addr + 3) & 0xFFFFF] ^ 0x80) - 0x80) * (cur & 511);
+				v = vl >> 9;
+			} else
+				v = (int16_t)(int8_t)((dev->ram[(addr + 1) & 0xFFFFF] ^ 0x80) - 0x80);
+		} else {
+			if (interp) {
+				vl = ((int8_t)((dev->ram[(cur >> 9) & 0xFFFFF] ^ 0x80) - 0x80)) * (511 - (cur & 511));
+				vl += ((int8_t)((dev->ram[((cur >> 9) + 1) & 0xFFFFF] ^ 0x80) - 0x80)) * (cur & 511);
+				v = vl >> 9;
+			} else
+				v = (int16_t)(int8_t)((dev->ram[(cur >> 9) & 0xFFFFF] ^ 0x80) - 0x80);
+		}
+
+		if ((rcur >> 14) > 4095)
+			v = (int16_t)((v * vol16bit[4095]) >> 16);
+		else
+			v = (int16_t)((v * vol16bit[(rcur >> 10) & 4095]) >> 16);
+
+		bl[i] += (v * pan_l) / 7;
+		br[i] += (v * pan_r) / 7;
+
+		if (ctrl & 0x40) {
+			cur -= inc;
+			if (cur <= dev->start[d]) {
+				diff = dev->start[d] - cur;
+
+				if (ctrl & 8) {
+					if (ctrl & 0x10)
+						ctrl ^= 0x40;
+					cur = (ctrl & 0x40) ? (dev->end[d] - diff) : (dev->start[d] + diff);
+				} else if (!(rctrl & 4)) {
+					ctrl |= 1;
+					cur = (ctrl & 0x40) ? dev->end[d] : dev->start[d];
+				}
+
+				if ((ctrl & 0x20) && !dev->waveirqs[d]) {
+					dev->waveirqs[d] = 1;
+					update_irqs = 1;
+				}
+			}
+		} else {
+			cur += inc;
+
+			if (cur >= dev->end[d]) {
+				diff = cur - dev->end[d];
+
+				if (ctrl & 8) {
+					if (ctrl & 0x10)
+						ctrl ^= 0x40;
+					cur = (ctrl & 0x40) ? (dev->end[d] - diff) : (dev->start[d] + diff);
+				} else if (!(rctrl & 4)) {
+					ctrl |= 1;
+					cur = (ctrl & 0x40) ? dev->end[d] : dev->start[d];
+				}
+
+				if ((ctrl & 0x20) && !dev->waveirqs[d]) {
+					dev->waveirqs[d] = 1;
+					update_irqs = 1;
+				}
+			}
+		}
+	}
+
+	if (!(rctrl & 3)) {
+		if (rctrl & 0x40) {
+			rcur -= dev->rfreq[d];
+			if (rcur <= dev->rstart[d]) {
+				diff = dev->rstart[d] - rcur;
+
+				if (!(rctrl & 8)) {
+					rctrl |= 1;
+					rcur = (rctrl & 0x40) ? dev->rstart[d] : dev->rend[d];
+				} else {
+					if (rctrl & 0x10)
+						rctrl ^= 0x40;
+					rcur = (rctrl & 0x40) ? (dev->rend[d] - diff) : (dev->rstart[d] + diff);
+				}
+
+				if ((rctrl & 0x20) && !dev->rampirqs[d]) {
+					dev->rampirqs[d] = 1;
+					update_irqs = 1;
+				}
+			}
+		} else {
+			rcur += dev->rfreq[d];
+			if (rcur >= dev->rend[d]) {
+				diff = rcur - dev->rend[d];
+
+				if (!(rctrl & 8)) {
+					rctrl |= 1;
+					rcur = (rctrl & 0x40) ? dev->rstart[d] : dev->rend[d];
+				} else {
+					if (rctrl & 0x10)
+						rctrl ^= 0x40;
+					rcur = (rctrl & 0x40) ? (dev->rend[d] - diff) : (dev->rstart[d] + diff);
+				}
+
+				if ((rctrl & 0x20) && !dev->rampirqs[d]) {
+					dev->rampirqs[d] = 1;
+					update_irqs = 1;
+				}
+			}
+		}
+	} else if (ctrl & 3) {
+		/* Voice and ramp both stopped, nothing more to do. */
+		break;
+	}
+    }
+
+    dev->cur[d] = cur;
+    dev->rcur[d] = rcur;
+    dev->ctrl[d] = ctrl;
+    dev->rctrl[d] = rctrl;
+
+    return(update_irqs);
+}
+
+
+/* Render samples at the voice rate into the mix buffer. */
+static void
+gus_render(gus_t *dev, int len)
+{
+    int32_t bl[GUS_BLOCK], br[GUS_BLOCK];
+    int update_irqs = 0;
+    int c, d, n;
+
+    while (len > 0) {
+	n = (len > GUS_BLOCK) ? GUS_BLOCK : len;
+	len -= n;
+
+	memset(bl, 0x00, n * sizeof(int32_t));
+	memset(br, 0x00, n * sizeof(int32_t));
+
+	if ((dev->reset & 3) == 3) for (d = 0; d < 32; d++) {
+		/* Skip voices which have fully stopped. */
+		if ((dev->ctrl[d] & 3) && (dev->rctrl[d] & 3))
+			continue;
+
+		update_irqs |= voice_render(dev, d, bl, br, n);
+	}
+
+	if (n > (GUS_MIX_LEN - dev->mix_cnt))
+		n = GUS_MIX_LEN - dev->mix_cnt;
+	for (c = 0; c < n; c++) {
+		dev->mix_l[dev->mix_cnt + c] = bl[c];
+		dev->mix_r[dev->mix_cnt + c] = br[c];
+	}
+	dev->mix_cnt += n;
+    }
+
+    if (update_irqs)
+	 update_int_status(dev);
+}
+
+
+/* Render all samples which have become due since the last call. */
+static void
+gus_catchup(gus_t *dev)
+{
+    int due = dev->samp_pend;
+
+    if (dev->samp_timer > 0)
+	due -= (int)((dev->samp_timer + dev->samp_latch - 1) / dev->samp_latch);
+
+    if (due > 0) {
+	gus_render(dev, due);
+	dev->samp_pend -= due;
+    }
+}
+
+
+/* Re-arm the block timer for the next IRQ boundary (or block end.) */
+static void
+gus_schedule(gus_t *dev)
+{
+    int len = next_event(dev);
+
+    dev->samp_timer += (tmrval_t)(len - dev->samp_pend) * dev->samp_latch;
+    dev->samp_pend = len;
+}
+
+
+/* Bring the voices up to the current time before a register access. */
+static void
+gus_sync(gus_t *dev)
+{
+    timer_clock();
+
+    gus_catchup(dev);
+}
+
+
+/* Pick up any voice changes made by a register access. */
+static void
+gus_resync(gus_t *dev)
+{
+    gus_schedule(dev);
+
+    timer_update_outstanding();
+}
+
+
 static void
 gus_write(uint16_t addr, uint8_t val, priv_t priv)
 {
@@ -270,7 +548,7 @@ gus_write(uint16_t addr, uint8_t val, priv_t priv)
 #if defined(DEV_BRANCH) && defined(USE_GUSMAX)
     uint16_t csioport;
 #endif
-    int c, d, old;
+    int c, d, old, sync;
     uint16_t port;
 
 	if ((addr == 0x388) || (addr == 0x389))
@@ -278,6 +556,11 @@ gus_write(uint16_t addr, uint8_t val, priv_t priv)
 	else
 		port = addr & 0xf0f; /* Bit masking GUS dynamic IO*/
 
+    /* Voice registers and DRAM are live, catch up the voices first. */
+    sync = (port == 0x304) || (port == 0x305) || (port == 0x307);
+    if (sync)
+	gus_sync(dev);
+
     if (dev->latch_enable && port != 0x20b)
 		dev->latch_enable = 0;
 
@@ -457,6 +740,9 @@ gus_write(uint16_t addr, uint8_t val, priv_t priv)
 
 			case 0x41: /*DMA*/
 				if (val & 1 && dev->dma != -1) {
+					/* The voices must not see DRAM change under them. */
+					gus_catchup(dev);
+
 					if (val & 2) {
 						c = 0;
 						while (c < 65536) {
@@ -713,6 +999,9 @@ gus_write(uint16_t addr, uint8_t val, priv_t priv)
 #endif
 		break;
 	}
+
+    if (sync)
+	gus_resync(dev);
 }
 
 
@@ -722,12 +1011,18 @@ gus_read(uint16_t addr, priv_t priv)
     gus_t *dev = (gus_t *)priv;
     uint8_t val = 0xff;
     uint16_t port;
+    int sync;
 
     if ((addr == 0x388) || (addr == 0x389))
 	port = addr;
     else
 	port = addr & 0xf0f; /* Bit masking GUS dynamic IO*/
 
+    /* Position and volume reads must see the voices up to date. */
+    sync = (port == 0x304) || (port == 0x305);
+    if (sync)
+	gus_sync(dev);
+
     switch (port) {
 	case 0x300: /*MIDI status*/
 		val = dev->midi_status;
@@ -940,6 +1235,9 @@ gus_read(uint16_t addr, priv_t priv)
 
     }
 
+    if (sync)
+	gus_resync(dev);
+
     return(val);
 }
 
@@ -1000,191 +1298,63 @@ poll_timer_2(priv_t priv)
 }
 
 
-static void
-gus_update(gus_t *dev)
-{
-    for (; dev->pos < sound_pos_global; dev->pos++) {
-	if (dev->out_l < -32768)
-		dev->buffer[0][dev->pos] = -32768;
-	else if (dev->out_l > 32767)
-		dev->buffer[0][dev->pos] = 32767;
-	else
-		dev->buffer[0][dev->pos] = dev->out_l;
-	if (dev->out_r < -32768)
-		dev->buffer[1][dev->pos] = -32768;
-	else if (dev->out_r > 32767)
-		dev->buffer[1][dev->pos] = 32767;
-	else
-		dev->buffer[1][dev->pos] = dev->out_r;
-    }
-}
-
-
 static void
 poll_wave(priv_t priv)
 {
     gus_t *dev = (gus_t *)priv;
-    uint32_t addr;
-    int d;
-    int16_t v;
-    int32_t vl;
-    int update_irqs = 0;
-
-    gus_update(dev);
-
-    dev->samp_timer += dev->samp_latch;
-
-    dev->out_l = dev->out_r = 0;
-
-    if ((dev->reset & 3) != 3)
-	return;
-
-    for (d = 0; d < 32; d++) {
-	if (!(dev->ctrl[d] & 3)) {
-		if (dev->ctrl[d] & 4) {
-			addr = dev->cur[d] >> 9;
-			addr = (addr & 0xC0000) | ((addr << 1) & 0x3FFFE);
-
-			if (!(dev->freq[d] >> 10)) {	/*Interpolate*/
-				vl = (int16_t)(int8_t)((dev->ram[(addr + 1) & 0xFFFFF] ^ 0x80) - 0x80) * (511 - (dev->cur[d] & 511));
-				vl += (int16_t)(int8_t)((dev->ram[(addr + 3) & 0xFFFFF] ^ 0x80) - 0x80) * (dev->cur[d] & 511);
-				v = vl >> 9;
-			} else
-				v = (int16_t)(int8_t)((dev->ram[(addr + 1) & 0xFFFFF] ^ 0x80) - 0x80);
-		} else {
-			if (!(dev->freq[d] >> 10)) {	/*Interpolate*/
-				vl = ((int8_t)((dev->ram[(dev->cur[d] >> 9) & 0xFFFFF] ^ 0x80) - 0x80)) * (511 - (dev->cur[d] & 511));
-				vl += ((int8_t)((dev->ram[((dev->cur[d] >> 9) + 1) & 0xFFFFF] ^ 0x80) - 0x80)) * (dev->cur[d] & 511);
-				v = vl >> 9;
-			} else
-				v = (int16_t)(int8_t)((dev->ram[(dev->cur[d] >> 9) & 0xFFFFF] ^ 0x80) - 0x80);
-		}
-
-		if ((dev->rcur[d] >> 14) > 4095)
-			v = (int16_t)((float)v * 24.0 * vol16bit[4095]);
-		else
-			v = (int16_t)((float)v * 24.0 * vol16bit[(dev->rcur[d] >> 10) & 4095]);
-
-		dev->out_l += (v * dev->pan_l[d]) / 7;
-		dev->out_r += (v * dev->pan_r[d]) / 7;
-
-		if (dev->ctrl[d] & 0x40) {
-			dev->cur[d] -= (dev->freq[d] >> 1);
-			if (dev->cur[d] <= dev->start[d]) {
-				int diff = dev->start[d] - dev->cur[d];
-
-				if (dev->ctrl[d] & 8) {
-					if (dev->ctrl[d] & 0x10)
-						dev->ctrl[d] ^= 0x40;
-					dev->cur[d] = (dev->ctrl[d] & 0x40) ? (dev->end[d] - diff) : (dev->start[d] + diff);
-				} else if (!(dev->rctrl[d] & 4)) {
-					dev->ctrl[d] |= 1;
-					dev->cur[d] = (dev->ctrl[d] & 0x40) ? dev->end[d] : dev->start[d];
-				}
-
-				if ((dev->ctrl[d] & 0x20) && !dev->waveirqs[d]) {
-					dev->waveirqs[d] = 1;
-					update_irqs = 1;
-				}
-			}
-		} else {
-			dev->cur[d] += (dev->freq[d] >> 1);
-
-			if (dev->cur[d] >= dev->end[d]) {
-				int diff = dev->cur[d] - dev->end[d];
-
-				if (dev->ctrl[d] & 8) {
-					if (dev->ctrl[d] & 0x10)
-						dev->ctrl[d] ^= 0x40;
-					dev->cur[d] = (dev->ctrl[d] & 0x40) ? (dev->end[d] - diff) : (dev->start[d] + diff);
-				} else if (!(dev->rctrl[d] & 4)) {
-					dev->ctrl[d] |= 1;
-					dev->cur[d] = (dev->ctrl[d] & 0x40) ? dev->end[d] : dev->start[d];
-				}
 
-				if ((dev->ctrl[d] & 0x20) && !dev->waveirqs[d]) {
-					dev->waveirqs[d] = 1;
-					update_irqs = 1;
-				}
-			}
-		}
-	}
+    gus_catchup(dev);
 
-	if (!(dev->rctrl[d] & 3)) {
-		if (dev->rctrl[d] & 0x40) {
-			dev->rcur[d] -= dev->rfreq[d];
-			if (dev->rcur[d] <= dev->rstart[d]) {
-				int diff = dev->rstart[d] - dev->rcur[d];
+    gus_schedule(dev);
+}
 
-				if (!(dev->rctrl[d] & 8)) {
-					dev->rctrl[d] |= 1;
-					dev->rcur[d] = (dev->rctrl[d] & 0x40) ? dev->rstart[d] : dev->rend[d];
-				} else {
-					if (dev->rctrl[d] & 0x10)
-						dev->rctrl[d] ^= 0x40;
-					dev->rcur[d] = (dev->rctrl[d] & 0x40) ? (dev->rend[d] - diff) : (dev->rstart[d] + diff);
-				}
 
-				if ((dev->rctrl[d] & 0x20) && !dev->rampirqs[d]) {
-					dev->rampirqs[d] = 1;
-					update_irqs = 1;
-				}
-			}
-		} else {
-			dev->rcur[d] += dev->rfreq[d];
-			if (dev->rcur[d] >= dev->rend[d]) {
-				int diff = dev->rcur[d] - dev->rend[d];
+/*
+ * Hand the voice output to the mixer at the voice rate, which varies
+ * with the number of active voices; the mixer converts it to its own
+ * output rate.
+ */
+static int
+get_buffer(int32_t *buffer, int max, priv_t priv)
+{
+    gus_t *dev = (gus_t *)priv;
+    int32_t l, r;
+    int c, len;
 
-				if (!(dev->rctrl[d] & 8)) {
-					dev->rctrl[d] |= 1;
-					dev->rcur[d] = (dev->rctrl[d] & 0x40) ? dev->rstart[d] : dev->rend[d];
-				} else {
-					if (dev->rctrl[d] & 0x10)
-						dev->rctrl[d] ^= 0x40;
-					dev->rcur[d] = (dev->rctrl[d] & 0x40) ? (dev->rend[d] - diff) : (dev->rstart[d] + diff);
-				}
+    gus_catchup(dev);
 
-				if ((dev->rctrl[d] & 0x20) && !dev->rampirqs[d]) {
-					dev->rampirqs[d] = 1;
-					update_irqs = 1;
-				}
-			}
-		}
-	}
+    len = (dev->mix_cnt > max) ? max : dev->mix_cnt;
+    for (c = 0; c < len; c++) {
+	l = dev->mix_l[c];
+	r = dev->mix_r[c];
+	buffer[c * 2] += (l < -32768) ? -32768 : (l > 32767) ? 32767 : l;
+	buffer[(c * 2) + 1] += (r < -32768) ? -32768 : (r > 32767) ? 32767 : r;
     }
 
-    if (update_irqs)
-	 update_int_status(dev);
+    dev->mix_cnt = 0;
+
+    return(len);
 }
 
 
+#if defined(DEV_BRANCH) && defined(USE_GUSMAX)
 static void
-get_buffer(int32_t *buffer, int len, priv_t priv)
+get_buffer_max(int32_t *buffer, int len, priv_t priv)
 {
     gus_t *dev = (gus_t *)priv;
     int c;
 
-#if defined(DEV_BRANCH) && defined(USE_GUSMAX)  
-    if (dev->max_ctrl)
-	cs423x_update(&dev->cs423x);
-#endif	
-    gus_update(dev);
-
-    for (c = 0; c < len * 2; c++) {
-#if defined(DEV_BRANCH) && defined(USE_GUSMAX)    
-	if (dev->max_ctrl)
-		buffer[c] += (int32_t)(dev->cs423x.buffer[c] / 2);
-#endif		
-	buffer[c] += (int32_t)dev->buffer[c & 1][c >> 1];
-    }
+    if (! dev->max_ctrl)
+	return;
 
-#if defined(DEV_BRANCH) && defined(USE_GUSMAX)    
-    if (dev->max_ctrl)
-	dev->cs423x.pos = 0;
-#endif	
+    cs423x_update(&dev->cs423x);
+
+    for (c = 0; c < len * 2; c++)
+	buffer[c] += (int32_t)(dev->cs423x.buffer[c] / 2);
 
-    dev->pos = 0;
+    dev->cs423x.pos = 0;
 }
+#endif
 
 
 static priv_t
@@ -1209,7 +1379,7 @@ gus_init(const device_t *info, UNUSED(void *parent))
     }
 
     for (c = 4095; c >= 0; c--) {
-	vol16bit[c] = out;
+	vol16bit[c] = (int32_t)(out * 24.0 * 65536.0);
 	out /= 1.002709201;		/* 0.0235 dB Steps */
     }
 
@@ -1218,6 +1388,7 @@ gus_init(const device_t *info, UNUSED(void *parent))
     dev->voices = 14;
 
     dev->samp_timer = dev->samp_latch = (tmrval_t)(TIMER_USEC * (1000000.0 / 44100.0));
+    dev->samp_pend = 1;
 
     dev->t1l = dev->t2l = 0xff;
 
@@ -1261,7 +1432,10 @@ gus_init(const device_t *info, UNUSED(void *parent))
     timer_add(poll_timer_1, (priv_t)dev, &dev->timer_1, TIMER_ALWAYS_ENABLED);
     timer_add(poll_timer_2, (priv_t)dev, &dev->timer_2, TIMER_ALWAYS_ENABLED);
 
-    sound_add_handler(get_buffer, (priv_t)dev);
+    sound_add_source(get_buffer, (priv_t)dev);
+#if defined(DEV_BRANCH) && defined(USE_GUSMAX)
+    sound_add_handler(get_buffer_max, (priv_t)dev);
+#endif
 
     return((priv_t)dev);
 }
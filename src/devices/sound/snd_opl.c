@@ -12,7 +12,7 @@
  *		poll-like function for "update" so the sound card can call
  *		that and get a buffer-full of sample data.
  *
- * Version:	@(#)snd_opl.c	1.0.9	2020/07/19
+ * Version:	@(#)snd_opl.c	1.0.10	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -130,6 +130,41 @@ timer_2(priv_t priv)
 }
 
 
+/*
+ * Bring the chip output up to the current sound position.
+ *
+ * Register writes are not applied as they come in, but queued with
+ * the sample position at which they happened. Here, we generate the
+ * output in runs between those positions, applying each write where
+ * it belongs. This gives the same result as generating on every
+ * port access, with a lot fewer (and larger) calls into the core.
+ */
+static void
+opl_update(opl_t *dev)
+{
+    int mono = !dev->is_opl3;
+    int i;
+
+    for (i = 0; i < dev->wrq_cnt; i++) {
+	if (dev->wrq[i].pos > dev->pos) {
+		nuked_generate_stream(dev->opl, &dev->buffer[dev->pos * 2],
+				      dev->wrq[i].pos - dev->pos, mono);
+		dev->pos = dev->wrq[i].pos;
+	}
+
+	nuked_write_reg_buffered(dev->opl, dev->wrq[i].reg, dev->wrq[i].val);
+    }
+    dev->wrq_cnt = 0;
+
+    if (dev->pos >= sound_pos_global)
+	return;
+
+    nuked_generate_stream(dev->opl, &dev->buffer[dev->pos * 2],
+			  sound_pos_global - dev->pos, mono);
+    dev->pos = sound_pos_global;
+}
+
+
 static uint8_t
 opl_read(opl_t *dev, uint16_t port)
 {
@@ -155,7 +190,16 @@ opl_write(opl_t *dev, uint16_t port, uint8_t val)
 	return;
     }
 
-    nuked_write_reg_buffered(dev->opl, dev->port, val);
+    /* Queue the write, unless we are out of room. */
+    if (dev->wrq_cnt == OPL_WRQ_SIZE)
+	opl_update(dev);
+    dev->wrq[dev->wrq_cnt].pos = sound_pos_global;
+    dev->wrq[dev->wrq_cnt].reg = dev->port;
+    dev->wrq[dev->wrq_cnt++].val = val;
+
+    /* This one changes address decoding, so apply it right away. */
+    if (dev->port == 0x0105)
+	opl_update(dev);
 
     switch (dev->port) {
 	case 0x02:	// timer 1
@@ -233,8 +277,6 @@ opl2_read(uint16_t port, priv_t priv)
     if (dev->do_cycles)
 	cycles -= ISA_CYCLES(8);
 
-    opl2_update(dev);
-
     return(opl_read(dev, port));
 }
 
@@ -244,8 +286,6 @@ opl2_write(uint16_t port, uint8_t val, priv_t priv)
 {
     opl_t *dev = (opl_t *)priv;
 
-    opl2_update(dev);
-
     opl_write(dev, port, val);
 }
 
@@ -260,17 +300,7 @@ opl2_init(opl_t *dev)
 void
 opl2_update(opl_t *dev)
 {
-    if (dev->pos >= sound_pos_global)
-	return;
-
-    nuked_generate_stream(dev->opl,
-			  &dev->buffer[dev->pos * 2],
-			  sound_pos_global - dev->pos);
-
-    for (; dev->pos < sound_pos_global; dev->pos++) {
-	dev->buffer[dev->pos * 2] /= 2;
-	dev->buffer[(dev->pos * 2) + 1] = dev->buffer[dev->pos * 2];
-    }
+    opl_update(dev);
 }
 
 
@@ -282,8 +312,6 @@ opl3_read(uint16_t port, priv_t priv)
     if (dev->do_cycles)
 	cycles -= ISA_CYCLES(8);
 
-    opl3_update(dev);
-
     return(opl_read(dev, port));
 }
 
@@ -292,8 +320,6 @@ void
 opl3_write(uint16_t port, uint8_t val, priv_t priv)
 {
     opl_t *dev = (opl_t *)priv;
-	
-    opl3_update(dev);
 
     opl_write(dev, port, val);
 }
@@ -310,15 +336,5 @@ opl3_init(opl_t *dev)
 void
 opl3_update(opl_t *dev)
 {
-    if (dev->pos >= sound_pos_global)
-	return;
-
-    nuked_generate_stream(dev->opl,
-			  &dev->buffer[dev->pos * 2],
-			  sound_pos_global - dev->pos);
-
-    for (; dev->pos < sound_pos_global; dev->pos++) {
-	dev->buffer[dev->pos * 2] /= 2;
-	dev->buffer[(dev->pos * 2) + 1] /= 2;
-    }
+    opl_update(dev);
 }
@@ -8,7 +8,7 @@
  *
  *		Definitions for the OPL interface.
  *
- * Version:	@(#)snd_opl.h	1.0.4	2020/07/19
+ * Version:	@(#)snd_opl.h	1.0.5	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -41,8 +41,18 @@
 # define SOUND_OPL_H
 
 
+#define OPL_WRQ_SIZE	512		/* queued register writes */
+
+
 typedef void	(*tmrfunc)(priv_t, int timer, tmrval_t period);
 
+/* A register write, waiting for the chip to catch up. */
+typedef struct {
+    uint16_t	pos;			/* sample position of write */
+    uint16_t	reg;
+    uint8_t	val;
+} opl_wrq_t;
+
 /* Define an OPLx chip. */
 typedef struct {
 #ifdef SOUND_OPL_NUKED_H
@@ -64,6 +74,9 @@ typedef struct {
 
     int		pos;
     int32_t	buffer[SOUNDBUFLEN * 2];
+
+    int		wrq_cnt;
+    opl_wrq_t	wrq[OPL_WRQ_SIZE];
 } opl_t;
 
 
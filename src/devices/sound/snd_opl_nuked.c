@@ -27,7 +27,7 @@
  *		in that order. The OPL2, however, is mono. What should
  *		we generate for that?
  *
- * Version:	@(#)snd_opl_nuked.c	1.0.6	2021/03/19
+ * Version:	@(#)snd_opl_nuked.c	1.0.7	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1347,15 +1347,38 @@ nuked_generate_resampled(priv_t priv, int32_t *bufp)
 }
 
 
+/*
+ * Generate a block of resampled output at half level, which is what
+ * the sound cards expect. For an OPL2, the left channel is copied to
+ * the right one. Halving is folded into the interpolation divisor,
+ * which gives the same result as dividing each sample afterwards.
+ */
 void
-nuked_generate_stream(priv_t priv, int32_t *sndptr, uint32_t num)
+nuked_generate_stream(priv_t priv, int32_t *sndptr, uint32_t num, int mono)
 {
     nuked_t *dev = (nuked_t *)priv;
+    int32_t div = dev->rateratio * 2;
+    int32_t l, r;
     uint32_t i;
 
     for (i = 0; i < num; i++) {
-	nuked_generate_resampled(dev, sndptr);
+	while (dev->samplecnt >= dev->rateratio) {
+		dev->oldsamples[0] = dev->samples[0];
+		dev->oldsamples[1] = dev->samples[1];
+		nuked_generate(dev, dev->samples);
+		dev->samplecnt -= dev->rateratio;
+	}
+
+	l = (dev->oldsamples[0] * (dev->rateratio - dev->samplecnt)
+	     + dev->samples[0] * dev->samplecnt) / div;
+	r = (dev->oldsamples[1] * (dev->rateratio - dev->samplecnt)
+	     + dev->samples[1] * dev->samplecnt) / div;
+
+	sndptr[0] = l;
+	sndptr[1] = mono ? l : r;
 	sndptr += 2;
+
+	dev->samplecnt += 1 << RSM_FRAC;
     }
 }
 
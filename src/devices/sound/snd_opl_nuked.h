@@ -8,7 +8,7 @@
  *
  *		Definitions for the NukedOPL3 driver.
  *
- * Version:	@(#)snd_opl_nuked.h	1.0.5	2020/07/16
+ * Version:	@(#)snd_opl_nuked.h	1.0.6	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -47,7 +47,8 @@ extern void	nuked_write_reg_buffered(priv_t, uint16_t reg, uint8_t v);
 
 extern void	nuked_generate(priv_t, int32_t *buf);
 extern void	nuked_generate_resampled(priv_t, int32_t *buf);
-extern void	nuked_generate_stream(priv_t, int32_t *sndptr, uint32_t num);
+extern void	nuked_generate_stream(priv_t, int32_t *sndptr, uint32_t num,
+				      int mono);
 
 
 #endif	/*SOUND_OPL_NUKED_H*/
@@ -0,0 +1,256 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Sample rate converter for the sound mixer.
+ *
+ *		Converts a block of stereo samples at some native rate to
+ *		a block of a different length, keeping filter history from
+ *		one block to the next so blocks join up without clicks. The
+ *		rate ratio is taken from the block lengths, so sources with
+ *		a varying sample rate are handled as well.
+ *
+ * Version:	@(#)snd_resamp.c	1.0.2	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <math.h>
+#include "../../emu.h"
+#include "snd_resamp.h"
+
+
+#define SINC_TAPS	16			/* taps per phase */
+#define SINC_PHASES	256			/* phases per sample */
+#define SINC_CUTOFF	0.9			/* passband edge (x Nyquist) */
+
+#ifndef M_PI
+# define M_PI		3.14159265358979323846
+#endif
+
+
+struct resamp {
+    int		quality,
+		taps;
+
+    float	hist[2][SINC_TAPS];		/* last input frames */
+
+    int		work_len;
+    float	*work[2];			/* history + input block */
+};
+
+
+static float	*sinc_table = NULL;
+
+
+/* Build the windowed sinc table, shared by all converters. */
+static void
+sinc_init(void)
+{
+    double t, w, h, sum;
+    int p, k;
+
+    sinc_table = (float *)mem_alloc(SINC_PHASES * SINC_TAPS * sizeof(float));
+
+    for (p = 0; p < SINC_PHASES; p++) {
+	sum = 0.0;
+	for (k = 0; k < SINC_TAPS; k++) {
+		/* Distance from the output point to this tap. */
+		t = (double)(k - (SINC_TAPS / 2) + 1) - ((double)p / SINC_PHASES);
+
+		if (t == 0.0)
+			h = SINC_CUTOFF;
+		else
+			h = sin(M_PI * SINC_CUTOFF * t) / (M_PI * t);
+
+		/* Blackman window over the kernel width. */
+		w = (t + (SINC_TAPS / 2)) / SINC_TAPS;
+		w = 0.42 - 0.5 * cos(2.0 * M_PI * w) + 0.08 * cos(4.0 * M_PI * w);
+
+		sinc_table[(p * SINC_TAPS) + k] = (float)(h * w);
+		sum += h * w;
+	}
+
+	/* Normalize each phase to unity gain. */
+	for (k = 0; k < SINC_TAPS; k++)
+		sinc_table[(p * SINC_TAPS) + k] /= (float)sum;
+    }
+}
+
+
+resamp_t *
+resamp_init(int quality)
+{
+    resamp_t *rs;
+
+    rs = (resamp_t *)mem_alloc(sizeof(resamp_t));
+    memset(rs, 0x00, sizeof(resamp_t));
+
+    switch (quality) {
+	case RESAMP_LINEAR:
+		rs->taps = 2;
+		break;
+
+	case RESAMP_CUBIC:
+		rs->taps = 4;
+		break;
+
+	default:
+		quality = RESAMP_SINC;
+		rs->taps = SINC_TAPS;
+		if (sinc_table == NULL)
+			sinc_init();
+		break;
+    }
+    rs->quality = quality;
+
+    return(rs);
+}
+
+
+void
+resamp_close(resamp_t *rs)
+{
+    if (rs == NULL) return;
+
+    if (rs->work[0] != NULL)
+	free(rs->work[0]);
+    if (rs->work[1] != NULL)
+	free(rs->work[1]);
+
+    free(rs);
+}
+
+
+void
+resamp_reset(resamp_t *rs)
+{
+    memset(rs->hist, 0x00, sizeof(rs->hist));
+}
+
+
+/*
+ * Convert 'in_len' stereo frames to 'out_len' frames, adding them to
+ * the output buffer. The output lags the input by half the filter
+ * width, which is what lets us use the saved history for the taps on
+ * the left of each output point.
+ */
+void
+resamp_process(resamp_t *rs, const int32_t *in, int in_len,
+	       int32_t *out, int out_len)
+{
+    const int taps = rs->taps;
+    const float *w0, *w1, *k;
+    double step, x;
+    float f, l, r;
+    int c, i, j;
+
+    if ((in_len <= 0) || (out_len <= 0)) return;
+
+    if (rs->work_len < (taps + in_len)) {
+	if (rs->work[0] != NULL)
+		free(rs->work[0]);
+	if (rs->work[1] != NULL)
+		free(rs->work[1]);
+	rs->work_len = taps + in_len;
+	rs->work[0] = (float *)mem_alloc(rs->work_len * sizeof(float));
+	rs->work[1] = (float *)mem_alloc(rs->work_len * sizeof(float));
+    }
+
+    /* Lay out the history followed by the new block, per channel. */
+    memcpy(rs->work[0], rs->hist[0], taps * sizeof(float));
+    memcpy(rs->work[1], rs->hist[1], taps * sizeof(float));
+    for (c = 0; c < in_len; c++) {
+	rs->work[0][taps + c] = (float)in[c * 2];
+	rs->work[1][taps + c] = (float)in[(c * 2) + 1];
+    }
+
+    step = (double)in_len / (double)out_len;
+    x = (double)(taps / 2);
+
+    for (j = 0; j < out_len; j++, x += step) {
+	i = (int)x;
+	f = (float)(x - i);
+
+	switch (rs->quality) {
+		case RESAMP_LINEAR:
+			w0 = &rs->work[0][i];
+			w1 = &rs->work[1][i];
+			l = w0[0] + (w0[1] - w0[0]) * f;
+			r = w1[0] + (w1[1] - w1[0]) * f;
+			break;
+
+		case RESAMP_CUBIC:
+			w0 = &rs->work[0][i - 1];
+			w1 = &rs->work[1][i - 1];
+			l = w0[1] + 0.5f * f * (w0[2] - w0[0] +
+			    f * (2.0f * w0[0] - 5.0f * w0[1] + 4.0f * w0[2] - w0[3] +
+			    f * (3.0f * (w0[1] - w0[2]) + w0[3] - w0[0])));
+			r = w1[1] + 0.5f * f * (w1[2] - w1[0] +
+			    f * (2.0f * w1[0] - 5.0f * w1[1] + 4.0f * w1[2] - w1[3] +
+			    f * (3.0f * (w1[1] - w1[2]) + w1[3] - w1[0])));
+			break;
+
+		default:
+			w0 = &rs->work[0][i - (SINC_TAPS / 2) + 1];
+			w1 = &rs->work[1][i - (SINC_TAPS / 2) + 1];
+			c = (int)((x - i) * SINC_PHASES);
+			if (c >= SINC_PHASES)
+				c = SINC_PHASES - 1;
+			k = &sinc_table[c * SINC_TAPS];
+			l = r = 0.0f;
+			for (c = 0; c < SINC_TAPS; c++) {
+				l += w0[c] * k[c];
+				r += w1[c] * k[c];
+			}
+			break;
+	}
+
+	out[j * 2] += (int32_t)l;
+	out[(j * 2) + 1] += (int32_t)r;
+    }
+
+    /* Keep the tail of this block as history for the next one. */
+    memcpy(rs->hist[0], &rs->work[0][in_len], taps * sizeof(float));
+    memcpy(rs->hist[1], &rs->work[1][in_len], taps * sizeof(float));
+}
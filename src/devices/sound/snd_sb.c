@@ -10,7 +10,7 @@
  *
  * FIXME:	THIS FILE IS A HORRIBLE NIGHTMARE
  *
- * Version:	@(#)snd_sb.c	1.0.20	2021/03/16
+ * Version:	@(#)snd_sb.c	1.0.21	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -47,6 +47,7 @@
 #include <wchar.h>
 #define dbglog sound_card_log
 #include "../../emu.h"
+#include "../../config.h"
 #include "../../timer.h"
 #include "../../io.h"
 #include "../../cpu/cpu.h"
@@ -60,6 +61,7 @@
 #include "snd_emu8k.h"
 #include "snd_mpu401.h"
 #include "snd_opl.h"
+#include "snd_resamp.h"
 #include "snd_sb.h"
 #include "snd_sb_dsp.h"
 
@@ -170,6 +172,8 @@ typedef struct
         mpu_t		*mpu;
 
         emu8k_t         emu8k;
+        resamp_t        *emu8k_resamp;
+        int32_t         emu8k_buffer[SOUNDBUFLEN * 2];
 
         int pos;
         uint8_t pos_regs[8];
@@ -415,20 +419,23 @@ static void sb_get_buffer_emu8k(int32_t *buffer, int len, priv_t priv)
 
         emu8k_update(&sb->emu8k);
 
+        /* Bring the EMU8000 output from 44.1 kHz up to our rate. */
+        memset(sb->emu8k_buffer, 0, len * 2 * sizeof(int32_t));
+        resamp_process(sb->emu8k_resamp, sb->emu8k.buffer, sb->emu8k.pos, sb->emu8k_buffer, len);
+
         sb_dsp_update(&sb->dsp);
 
         for (c = 0; c < len * 2; c += 2)
         {
                 int32_t out_l = 0, out_r = 0, in_l, in_r;
-                int c_emu8k = (((c/2) * 44100) / 48000)*2;
                 
 		if (sb->opl_enabled) {
                 	out_l = ((((sb->opl.buffer[c]     * mixer->fm_l) >> 15) * (sb->opl_emu ? 47000 : 51000)) >> 16);
                 	out_r = ((((sb->opl.buffer[c + 1] * mixer->fm_r) >> 15) * (sb->opl_emu ? 47000 : 51000)) >> 16);
 		}
 
-               	out_l += ((sb->emu8k.buffer[c_emu8k]     * mixer->fm_l) >> 15);
-               	out_r += ((sb->emu8k.buffer[c_emu8k + 1] * mixer->fm_r) >> 15);
+               	out_l += ((sb->emu8k_buffer[c]     * mixer->fm_l) >> 15);
+               	out_r += ((sb->emu8k_buffer[c + 1] * mixer->fm_r) >> 15);
                 
                 /*TODO: multi-recording mic with agc/+20db, cd and line in with channel inversion  */
                 in_l = (mixer->input_selector_left&INPUT_MIDI_L) ? out_l : 0 + (mixer->input_selector_left&INPUT_MIDI_R) ? out_r : 0;
@@ -1386,6 +1393,7 @@ sb_awe32_init(const device_t *info, UNUSED(void *parent))
 	} else
 		sb->mpu = NULL;
         emu8k_init(&sb->emu8k, ROM_PATH_AWE32, emu_addr, onboard_ram);
+        sb->emu8k_resamp = resamp_init(config.sound_quality);
 
         return (priv_t)sb;
 }
@@ -1415,6 +1423,7 @@ void sb_awe32_close(priv_t priv)
         sb_t *sb = (sb_t *)priv;
         
         emu8k_close(&sb->emu8k);
+        resamp_close(sb->emu8k_resamp);
 
         sb_close(sb);
 }
@@ -8,7 +8,7 @@
  *
  *		Sound emulation core.
  *
- * Version:	@(#)sound.c	1.0.21	2020/07/14
+ * Version:	@(#)sound.c	1.0.25	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -54,6 +54,7 @@
 #include "midi.h"
 #include "snd_mpu401.h"
 #include "snd_opl.h"
+#include "snd_resamp.h"
 #include "snd_sb.h"
 #include "snd_sb_dsp.h"
 #include "snd_speaker.h"
@@ -61,7 +62,14 @@
 
 typedef struct {
     void	(*get_buffer)(int32_t *buffer, int len, priv_t);
+    int		(*get_native)(int32_t *buffer, int max, priv_t);
+    resamp_t	*resamp;
     priv_t	priv;
+
+    const char	*name;				/* owning device */
+    uint64_t	time,				/* host time spent */
+		time_max,
+		time_last;
 } sndhnd_t;
 
 
@@ -76,6 +84,7 @@ static int	handlers_num;
 static tmrval_t	poll_time = 0,
 		poll_latch;
 static int32_t	*outbuffer;
+static int32_t	*nativebuffer;
 static float	*outbuffer_ex;
 static int16_t	*outbuffer_ex_int16;
 
@@ -91,6 +100,16 @@ static int	cd_buf_update = CD_BUFLEN / SOUNDBUFLEN;
 static int	cd_thread_enable = 0;
 static volatile int cd_audioon = 0;
 
+static uint64_t	stat_polls,			/* buffers mixed */
+		stat_freq;			/* host timer ticks/sec */
+static volatile uint64_t cd_wake_time;		/* when CD thread was woken */
+static uint64_t	cd_late,			/* total CD wakeup lateness */
+		cd_late_max,
+		cd_late_last;
+static uint32_t	cd_wakeups;
+static FILE	*trace_fp = NULL;
+static int	trace_hdr;
+
 
 static void
 cd_thread(void *param)
@@ -110,6 +129,13 @@ cd_thread(void *param)
 
 	if (! cd_audioon) return;
 
+	/* How long did it take us to get going? */
+	cd_late_last = plat_timer_read() - cd_wake_time;
+	cd_late += cd_late_last;
+	if (cd_late_last > cd_late_max)
+		cd_late_max = cd_late_last;
+	cd_wakeups++;
+
 	for (c = 0; c < CD_BUFLEN*2; c += 2) {
 		if (config.sound_is_float) {
 			cd_out_buffer[c] = 0.0;
@@ -245,11 +271,45 @@ cd_thread_end(void)
 }
 
 
+/* Convert host timer ticks to microseconds. */
+static uint32_t
+ticks_us(uint64_t ticks)
+{
+    return((uint32_t)((ticks * 1000000) / stat_freq));
+}
+
+
+/* Write one line per mixed buffer to the trace file. */
 static void
-sound_poll(void *priv)
+trace_write(void)
 {
+    int depth, under, dropped;
     int c;
 
+    if (trace_hdr) {
+	fprintf(trace_fp, "# time_ms");
+	for (c = 0; c < handlers_num; c++)
+		fprintf(trace_fp, ",%s", (handlers[c].name != NULL) ? handlers[c].name : "?");
+	fprintf(trace_fp, ",al_depth,al_underruns,al_drops,cd_late_us\n");
+	trace_hdr = 0;
+    }
+
+    openal_get_stats(0, &depth, &under, &dropped);
+
+    fprintf(trace_fp, "%u", plat_timer_ms());
+    for (c = 0; c < handlers_num; c++)
+	fprintf(trace_fp, ",%u", ticks_us(handlers[c].time_last));
+    fprintf(trace_fp, ",%i,%i,%i,%u\n",
+	    depth, under, dropped, ticks_us(cd_late_last));
+}
+
+
+static void
+sound_poll(void *priv)
+{
+    uint64_t start;
+    int c, n;
+
     poll_time += poll_latch;
 
     midi_poll();
@@ -258,19 +318,39 @@ sound_poll(void *priv)
     if (sound_pos_global == SOUNDBUFLEN) {
 	memset(outbuffer, 0, SOUNDBUFLEN * 2 * sizeof(int32_t));
 
-	for (c = 0; c < handlers_num; c++)
-		handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, handlers[c].priv);
+	for (c = 0; c < handlers_num; c++) {
+		start = plat_timer_read();
 
-	for (c = 0; c < SOUNDBUFLEN * 2; c++) {
-		if (config.sound_is_float) {
-			outbuffer_ex[c] = (float)((outbuffer[c]) / 32768.0);
-		} else {
-			if (outbuffer[c] > 32767)
-				outbuffer[c] = 32767;
-			if (outbuffer[c] < -32768)
-				outbuffer[c] = -32768;
+		if (handlers[c].get_native != NULL) {
+			/* Native-rate source, convert to our rate. */
+			memset(nativebuffer, 0, SOUND_NATIVE_MAX * 2 * sizeof(int32_t));
+			n = handlers[c].get_native(nativebuffer, SOUND_NATIVE_MAX,
+						   handlers[c].priv);
+			resamp_process(handlers[c].resamp, nativebuffer, n,
+				       outbuffer, SOUNDBUFLEN);
+		} else
+			handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, handlers[c].priv);
 
-			outbuffer_ex_int16[c] = outbuffer[c];
+		handlers[c].time_last = plat_timer_read() - start;
+		handlers[c].time += handlers[c].time_last;
+		if (handlers[c].time_last > handlers[c].time_max)
+			handlers[c].time_max = handlers[c].time_last;
+	}
+	stat_polls++;
+
+	/* Hand a copy to the capture file, if we have one. */
+	sound_wav_write(outbuffer);
+
+	/* Keep these loops branch-free so they can be vectorized. */
+	if (config.sound_is_float) {
+		for (c = 0; c < SOUNDBUFLEN * 2; c++)
+			outbuffer_ex[c] = (float)outbuffer[c] * (1.0f / 32768.0f);
+	} else {
+		for (c = 0; c < SOUNDBUFLEN * 2; c++) {
+			n = outbuffer[c];
+			n = (n > 32767) ? 32767 : n;
+			n = (n < -32768) ? -32768 : n;
+			outbuffer_ex_int16[c] = (int16_t)n;
 		}
 	}
 
@@ -283,15 +363,69 @@ sound_poll(void *priv)
 		cd_buf_update--;
 		if (! cd_buf_update) {
 			cd_buf_update = (48000 / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
+			cd_wake_time = plat_timer_read();
 			thread_set_event(cd_event);
 		}
 	}
 
+	if (trace_fp != NULL)
+		trace_write();
+
 	sound_pos_global = 0;
     }
 }
 
 
+static void
+handlers_close(void)
+{
+    int c;
+
+    for (c = 0; c < handlers_num; c++) {
+	if (handlers[c].resamp != NULL)
+		resamp_close(handlers[c].resamp);
+	handlers[c].resamp = NULL;
+    }
+
+    handlers_num = 0;
+
+    stat_polls = 0;
+    cd_late = cd_late_max = 0;
+    cd_wakeups = 0;
+}
+
+
+static void
+trace_close(void)
+{
+    if (trace_fp == NULL) return;
+
+    (void)fclose(trace_fp);
+    trace_fp = NULL;
+}
+
+
+/* Open the trace file, if enabled. */
+static void
+trace_open(void)
+{
+    wchar_t path[1024];
+
+    trace_close();
+
+    if (! config.sound_trace) return;
+
+    plat_append_filename(path, usr_path, SOUND_TRACE_FILE);
+    trace_fp = plat_fopen(path, L"w");
+    if (trace_fp == NULL) {
+	ERRLOG("SOUND: unable to create trace file '%ls'\n", path);
+	return;
+    }
+
+    trace_hdr = 1;
+}
+
+
 #ifdef _LOGGING
 void
 sound_log(int level, const char *fmt, ...)
@@ -330,8 +464,13 @@ sound_reset(void)
       else
 	outbuffer_ex_int16 = (int16_t *)mem_alloc(SOUNDBUFLEN * 2 * sizeof(int16_t));
 
+    /* Log the statistics of the previous run before they are cleared. */
+    if (stat_polls > 0)
+	sound_stats_dump();
+
     /* Reset the sound module data handlers. */
-    handlers_num = 0;
+    handlers_close();
+    trace_open();
 
     /* Reset the MIDI devices. */
     midi_device_init();
@@ -387,7 +526,10 @@ sound_init(void)
     outbuffer_ex = NULL;
     outbuffer_ex_int16 = NULL;
 
+    stat_freq = plat_timer_freq();
+
     outbuffer = (int32_t *)mem_alloc(SOUNDBUFLEN * 2 * sizeof(int32_t));
+    nativebuffer = (int32_t *)mem_alloc(SOUND_NATIVE_MAX * 2 * sizeof(int32_t));
 
     /* Set up the CD-AUDIO thread. */
     drives = 0;
@@ -414,6 +556,10 @@ sound_init(void)
 	cd_audioon = 0;
 
     cd_thread_enable = drives ? 1 : 0;
+
+    /* Start capturing the output if requested. */
+    if (audio_path[0] != L'\0')
+	(void)sound_wav_open(audio_path);
 }
 
 
@@ -427,6 +573,15 @@ sound_close(void)
     /* Close down the MIDI module. */
     midi_close();
 
+    /* Log the statistics, and release the data handlers. */
+    if (stat_polls > 0)
+	sound_stats_dump();
+    handlers_close();
+    trace_close();
+
+    /* Finish the capture file. */
+    sound_wav_close();
+
     /* Close the OpenAL interface. */
     openal_close();
 }
@@ -474,11 +629,71 @@ void
 sound_add_handler(void (*get_buffer)(int32_t *buffer, int len, void *p), void *p)
 {
     handlers[handlers_num].get_buffer = get_buffer;
+    handlers[handlers_num].get_native = NULL;
+    handlers[handlers_num].resamp = NULL;
+    handlers[handlers_num].priv = p;
+    handlers[handlers_num].name = device_get_current_name();
+    handlers[handlers_num].time = 0;
+    handlers[handlers_num].time_max = 0;
+    handlers[handlers_num].time_last = 0;
+    handlers_num++;
+}
+
+
+/*
+ * Add a source which renders at its own sample rate. The callback
+ * fills up to 'max' stereo frames and returns how many it made; they
+ * are then converted to our output rate by the shared resampler at
+ * the configured quality, so the device need not do this itself.
+ */
+void
+sound_add_source(int (*get_buffer)(int32_t *buffer, int max, void *p), void *p)
+{
+    handlers[handlers_num].get_buffer = NULL;
+    handlers[handlers_num].get_native = get_buffer;
+    handlers[handlers_num].resamp = resamp_init(config.sound_quality);
     handlers[handlers_num].priv = p;
+    handlers[handlers_num].name = device_get_current_name();
+    handlers[handlers_num].time = 0;
+    handlers[handlers_num].time_max = 0;
+    handlers[handlers_num].time_last = 0;
     handlers_num++;
 }
 
 
+/* Dump the mixer statistics to the log. */
+void
+sound_stats_dump(void)
+{
+    int depth, under, dropped;
+    int c;
+
+    if (stat_polls == 0) {
+	INFO("SOUND: no statistics yet\n");
+	return;
+    }
+
+    INFO("SOUND: %u buffers mixed\n", (uint32_t)stat_polls);
+
+    for (c = 0; c < handlers_num; c++) {
+	INFO("SOUND: handler %i (%s): avg %u us, max %u us per buffer\n",
+	     c, (handlers[c].name != NULL) ? handlers[c].name : "?",
+	     ticks_us(handlers[c].time / stat_polls),
+	     ticks_us(handlers[c].time_max));
+    }
+
+    for (c = 0; c < 3; c++) {
+	openal_get_stats(c, &depth, &under, &dropped);
+	INFO("SOUND: output %i: %i queued, %i underruns, %i drops\n",
+	     c, depth, under, dropped);
+    }
+
+    if (cd_wakeups > 0)
+	INFO("SOUND: CD thread: %u wakeups, avg %u us, max %u us late\n",
+	     cd_wakeups, ticks_us(cd_late / cd_wakeups), ticks_us(cd_late_max));
+}
+
+
 void
 sound_speed_changed(void)
 {
@@ -8,7 +8,7 @@
  *
  *		Definitions for the Sound Emulation core.
  *
- * Version:	@(#)sound.h	1.0.13	2021/06/03
+ * Version:	@(#)sound.h	1.0.16	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -41,10 +41,13 @@
 
 
 #define SOUNDBUFLEN	(48000/50)
+#define SOUND_NATIVE_MAX (SOUNDBUFLEN * 2)	/* max native frames per poll */
 
 #define CD_FREQ		44100
 #define CD_BUFLEN	(CD_FREQ / 10)
 
+#define SOUND_TRACE_FILE L"sound_trace.csv"
+
 #define SOUND_NONE	0
 #define SOUND_INTERNAL	1
 
@@ -90,6 +93,8 @@ extern void	sound_log(int level, const char *fmt, ...);
 
 extern void	sound_add_handler(void (*get_buffer)(int32_t *buffer, \
 				  int len, void *p), void *p);
+extern void	sound_add_source(int (*get_buffer)(int32_t *buffer, \
+				 int max, void *p), void *p);
 
 extern void	sound_card_log(int level, const char *fmt, ...);
 extern int	sound_card_available(int card);
@@ -109,6 +114,12 @@ extern void	sound_reset(void);
 extern void	sound_init(void);
 extern void	sound_close(void);
 
+extern void	sound_stats_dump(void);
+
+extern int	sound_wav_open(const wchar_t *fn);
+extern void	sound_wav_close(void);
+extern void	sound_wav_write(const int32_t *buf);
+
 extern void	sound_cd_stop(void);
 extern void	sound_cd_set_volume(unsigned int vol_l, unsigned int vol_r);
 
@@ -119,6 +130,8 @@ extern void	openal_buffer(void *buf);
 extern void	openal_buffer_cd(void *buf);
 extern void	openal_buffer_midi(void *buf, uint32_t size);
 extern void	openal_set_midi(int freq, int buf_size);
+extern void	openal_get_stats(int src, int *depth, int *under,
+				 int *dropped);
 
 extern void	resid_init(void);
 
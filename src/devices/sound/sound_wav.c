@@ -0,0 +1,248 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Capture of the mixed sound output to a WAV file.
+ *
+ *		Every buffer mixed by the sound module is copied into a
+ *		ring of blocks, which a writer thread drains to disk. The
+ *		emulator never waits for the disk; if the writer cannot
+ *		keep up, blocks are dropped and counted instead. Since the
+ *		samples are taken right after mixing, the file does not
+ *		depend on the host audio device, or on having one at all.
+ *
+ * Version:	@(#)sound_wav.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "../../emu.h"
+#include "../../plat.h"
+#include "sound.h"
+
+
+#define WAV_BLOCKS	256			/* blocks in the ring */
+#define WAV_HDRLEN	44
+#define WAV_MAXDATA	(0xffffffffUL - 36)	/* RIFF size is 32 bits */
+#define WAV_BLKSIZE	(SOUNDBUFLEN * 2 * sizeof(int16_t))
+
+
+static FILE		*wav_fp = NULL;
+static thread_t		*wav_thread = NULL;
+static event_t		*wav_event = NULL;
+static volatile int	wav_stop,
+			wav_full;		/* file hit the RIFF limit */
+static int16_t		*wav_ring = NULL;
+static volatile uint32_t wav_head,		/* written by emulator */
+			wav_tail;		/* written by writer thread */
+static uint32_t		wav_drops;
+static uint32_t		wav_bytes;
+
+
+static void
+put_le16(uint8_t *p, uint16_t val)
+{
+    p[0] = (uint8_t)val;
+    p[1] = (uint8_t)(val >> 8);
+}
+
+
+static void
+put_le32(uint8_t *p, uint32_t val)
+{
+    p[0] = (uint8_t)val;
+    p[1] = (uint8_t)(val >> 8);
+    p[2] = (uint8_t)(val >> 16);
+    p[3] = (uint8_t)(val >> 24);
+}
+
+
+/* (Re-)write the file header for the current data length. */
+static void
+wav_header(void)
+{
+    uint8_t hdr[WAV_HDRLEN];
+
+    memcpy(hdr, "RIFF", 4);
+    put_le32(hdr + 4, 36 + wav_bytes);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    put_le32(hdr + 16, 16);			/* fmt chunk length */
+    put_le16(hdr + 20, 1);			/* PCM */
+    put_le16(hdr + 22, 2);			/* channels */
+    put_le32(hdr + 24, 48000);			/* sample rate */
+    put_le32(hdr + 28, 48000 * 2 * 2);		/* byte rate */
+    put_le16(hdr + 32, 2 * 2);			/* block align */
+    put_le16(hdr + 34, 16);			/* bits per sample */
+    memcpy(hdr + 36, "data", 4);
+    put_le32(hdr + 40, wav_bytes);
+
+    (void)fseek(wav_fp, 0, SEEK_SET);
+    (void)fwrite(hdr, 1, sizeof(hdr), wav_fp);
+}
+
+
+/* Write out all blocks queued so far. */
+static void
+wav_drain(void)
+{
+    uint32_t tail = wav_tail;
+    int16_t *p;
+
+    while (tail != wav_head) {
+	/* One more block would no longer fit in the RIFF header. */
+	if (!wav_full && (wav_bytes > (WAV_MAXDATA - WAV_BLKSIZE))) {
+		ERRLOG("SOUND: capture file full (4 GB), recording stopped\n");
+		wav_full = 1;
+	}
+
+	p = &wav_ring[(tail % WAV_BLOCKS) * SOUNDBUFLEN * 2];
+	if (!wav_full && (fwrite(p, WAV_BLKSIZE, 1, wav_fp) == 1))
+		wav_bytes += WAV_BLKSIZE;
+
+	/* Only now hand the block back to the emulator. */
+	wav_tail = ++tail;
+    }
+}
+
+
+static void
+wav_writer(void *arg)
+{
+    for (;;) {
+	thread_wait_event(wav_event, 100);
+	thread_reset_event(wav_event);
+
+	wav_drain();
+
+	if (wav_stop) break;
+    }
+
+    /* Catch anything queued while we were stopping. */
+    wav_drain();
+}
+
+
+/* Start capturing to the named file. */
+int
+sound_wav_open(const wchar_t *fn)
+{
+    sound_wav_close();
+
+    wav_fp = plat_fopen(fn, L"wb");
+    if (wav_fp == NULL) {
+	ERRLOG("SOUND: unable to create capture file '%ls'\n", fn);
+	return(0);
+    }
+
+    wav_ring = (int16_t *)mem_alloc(WAV_BLOCKS * SOUNDBUFLEN * 2 * sizeof(int16_t));
+    wav_head = wav_tail = 0;
+    wav_drops = 0;
+    wav_bytes = 0;
+    wav_header();
+
+    wav_stop = wav_full = 0;
+    wav_event = thread_create_event();
+    wav_thread = thread_create(wav_writer, NULL);
+
+    INFO("SOUND: capturing output to '%ls'\n", fn);
+
+    return(1);
+}
+
+
+/* Stop capturing, and finish the file. */
+void
+sound_wav_close(void)
+{
+    if (wav_fp == NULL) return;
+
+    wav_stop = 1;
+    thread_set_event(wav_event);
+    (void)thread_wait(wav_thread, -1);
+    wav_thread = NULL;
+    thread_destroy_event(wav_event);
+    wav_event = NULL;
+
+    wav_header();
+    (void)fclose(wav_fp);
+    wav_fp = NULL;
+
+    free(wav_ring);
+    wav_ring = NULL;
+
+    INFO("SOUND: capture done, %u bytes written, %u blocks dropped\n",
+	 wav_bytes, wav_drops);
+}
+
+
+/* Queue one mixed buffer; called from the emulator thread. */
+void
+sound_wav_write(const int32_t *buf)
+{
+    uint32_t head = wav_head;
+    int16_t *p;
+    int32_t n;
+    int c;
+
+    if ((wav_fp == NULL) || wav_full) return;
+
+    if ((head - wav_tail) >= WAV_BLOCKS) {
+	/* Writer is behind, we do not wait for it. */
+	wav_drops++;
+	return;
+    }
+
+    p = &wav_ring[(head % WAV_BLOCKS) * SOUNDBUFLEN * 2];
+    for (c = 0; c < SOUNDBUFLEN * 2; c++) {
+	n = buf[c];
+	n = (n > 32767) ? 32767 : n;
+	n = (n < -32768) ? -32768 : n;
+	p[c] = (int16_t)n;
+    }
+
+    wav_head = head + 1;
+
+    /* Wake the writer every few blocks. */
+    if ((wav_head & 7) == 0)
+	thread_set_event(wav_event);
+}
@@ -0,0 +1,281 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Common command FIFO for the 2D accelerators.
+ *
+ *		Register writes to the accelerators are queued in a ring
+ *		and handled by a worker thread. The ring has exactly one
+ *		writer (the emulator) and one reader (the worker), so the
+ *		indexes alone are enough to pass entries along, and the
+ *		events are only used when one side has to go to sleep.
+ *
+ *		The worker takes everything that is in the ring at once,
+ *		and only reads the timer and signals the emulator once
+ *		per batch. When the ring runs dry, it spins for a little
+ *		while, as writes tend to come in bursts, before it marks
+ *		itself as sleeping and blocks; the emulator only sets the
+ *		wake event if it sees that flag.
+ *
+ *		While statistics are collected, each entry is timed on
+ *		its own, and filed under the command the card named for
+ *		it with ACCEL_FIFO_OP (or "reg" for plain register
+ *		writes.) The totals are handed over once per batch.
+ *
+ * Version:	@(#)vid_accel_fifo.c	1.0.4	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+#include "../../emu.h"
+#include "../../plat.h"
+#include "video.h"
+#include "vid_accel_fifo.h"
+
+
+/* Number of times the worker checks for work before it blocks. */
+#define FIFO_SPIN	4096
+
+/* Number of distinct commands counted per batch. */
+#define FIFO_OPS	16
+
+
+typedef struct {
+    const char	*op;
+    uint64_t	count,
+		ticks;
+} fifo_op_t;
+
+
+/*
+ * A full barrier, for the two places where one side sets its flag and
+ * then checks the other side's index; without it, the store and load
+ * could pass each other, and both sides would end up waiting.
+ */
+#ifdef _MSC_VER
+# define FIFO_FENCE()	_mm_mfence()
+# define FIFO_BARRIER()	_ReadWriteBarrier()
+#else
+# define FIFO_FENCE()	__sync_synchronize()
+# define FIFO_BARRIER()	__asm__ __volatile__("" ::: "memory")
+#endif
+
+
+/* Count one entry for the command it worked on. */
+static void
+fifo_op_add(fifo_op_t *ops, int *num, const char *op, uint64_t ticks)
+{
+    int i;
+
+    if (op == NULL)
+	op = "reg";
+
+    for (i = 0; i < *num; i++) {
+	if (ops[i].op == op)
+		break;
+    }
+
+    if (i == *num) {
+	if (*num == FIFO_OPS)
+		return;
+	ops[i].op = op;
+	ops[i].count = ops[i].ticks = 0;
+	(*num)++;
+    }
+
+    ops[i].count++;
+    ops[i].ticks += ticks;
+}
+
+
+static void
+fifo_thread(void *param)
+{
+    accel_fifo_t *f = (accel_fifo_t *)param;
+    fifo_op_t ops[FIFO_OPS];
+    accel_fifo_entry_t *ent;
+    uint64_t start, t;
+    uint32_t end;
+    int spin, stats, num, i;
+
+    while (! f->stop) {
+	for (spin = 0; ACCEL_FIFO_EMPTY(f) && spin < FIFO_SPIN; spin++)
+		;
+
+	if (ACCEL_FIFO_EMPTY(f)) {
+		f->sleeping = 1;
+		FIFO_FENCE();
+		if (ACCEL_FIFO_EMPTY(f) && !f->stop)
+			thread_wait_event(f->wake, -1);
+		f->sleeping = 0;
+		continue;
+	}
+
+	f->busy = 1;
+	stats = video_stats_on;
+	num = 0;
+	start = plat_timer_read();
+
+	/* Take all entries that are in the ring right now. */
+	end = f->write_idx;
+	FIFO_BARRIER();
+	while (f->read_idx != end) {
+		ent = &f->ring[f->read_idx & ACCEL_FIFO_MASK];
+		if (stats) {
+			f->op = NULL;
+			t = plat_timer_read();
+			f->process(f->priv, ent->addr_type, ent->val);
+			fifo_op_add(ops, &num, f->op, plat_timer_read() - t);
+		} else
+			f->process(f->priv, ent->addr_type, ent->val);
+
+		/* Entries are retired one by one, for the status bits. */
+		f->read_idx++;
+
+		if (f->waiting)
+			thread_set_event(f->not_full);
+	}
+
+	f->time += plat_timer_read() - start;
+	for (i = 0; i < num; i++)
+		video_stats_add(VSTAT_ACCEL, f->name, ops[i].op,
+				ops[i].count, ops[i].ticks);
+
+	if (ACCEL_FIFO_EMPTY(f)) {
+		f->busy = 0;
+		if (f->idle != NULL)
+			f->idle(f->priv);
+	}
+    }
+
+    f->busy = 0;
+}
+
+
+void
+accel_fifo_init(accel_fifo_t *f, const char *name,
+		void (*process)(priv_t, uint32_t, uint32_t),
+		void (*idle)(priv_t), priv_t priv)
+{
+    f->read_idx = f->write_idx = 0;
+    f->sleeping = f->waiting = f->busy = f->stop = 0;
+    f->time = 0;
+
+    f->name = name;
+    f->op = NULL;
+
+    f->process = process;
+    f->idle = idle;
+    f->priv = priv;
+
+    f->wake = thread_create_event();
+    f->not_full = thread_create_event();
+    f->thread = thread_create(fifo_thread, f);
+}
+
+
+void
+accel_fifo_close(accel_fifo_t *f)
+{
+    if (f->thread == NULL) return;
+
+    f->stop = 1;
+    thread_set_event(f->wake);
+    (void)thread_wait(f->thread, -1);
+    f->thread = NULL;
+
+    thread_destroy_event(f->wake);
+    thread_destroy_event(f->not_full);
+}
+
+
+/* Wake up the worker, if it went to sleep. */
+void
+accel_fifo_wake(accel_fifo_t *f)
+{
+    FIFO_FENCE();
+    if (f->sleeping)
+	thread_set_event(f->wake);
+}
+
+
+/* Add an entry to the ring; this only blocks if the ring is full. */
+void
+accel_fifo_queue(accel_fifo_t *f, uint32_t addr_type, uint32_t val)
+{
+    accel_fifo_entry_t *ent;
+
+    while (ACCEL_FIFO_ENTRIES(f) >= ACCEL_FIFO_SIZE) {
+	f->waiting = 1;
+	accel_fifo_wake(f);
+	if (ACCEL_FIFO_ENTRIES(f) >= ACCEL_FIFO_SIZE)
+		thread_wait_event(f->not_full, 1);
+	f->waiting = 0;
+    }
+
+    ent = &f->ring[f->write_idx & ACCEL_FIFO_MASK];
+    ent->addr_type = addr_type;
+    ent->val = val;
+
+    /* The entry must be in place before the worker can see it. */
+    FIFO_BARRIER();
+    f->write_idx++;
+
+    accel_fifo_wake(f);
+}
+
+
+/* Wait until the worker has handled all queued entries. */
+void
+accel_fifo_wait_idle(accel_fifo_t *f)
+{
+    while (! ACCEL_FIFO_EMPTY(f)) {
+	f->waiting = 1;
+	accel_fifo_wake(f);
+	if (! ACCEL_FIFO_EMPTY(f))
+		thread_wait_event(f->not_full, 1);
+	f->waiting = 0;
+    }
+}
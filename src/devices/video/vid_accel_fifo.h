@@ -0,0 +1,111 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Definitions for the common accelerator command FIFO.
+ *
+ * Version:	@(#)vid_accel_fifo.h	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef VIDEO_ACCEL_FIFO_H
+# define VIDEO_ACCEL_FIFO_H
+
+
+#define ACCEL_FIFO_SIZE		65536
+#define ACCEL_FIFO_MASK		(ACCEL_FIFO_SIZE - 1)
+
+#define ACCEL_FIFO_ENTRIES(f)	((int)((f)->write_idx - (f)->read_idx))
+#define ACCEL_FIFO_EMPTY(f)	((f)->read_idx == (f)->write_idx)
+
+/* Name the command the current entry works on, for the statistics. */
+#define ACCEL_FIFO_OP(f, n)	((f)->op = (n))
+
+
+typedef struct {
+    uint32_t	addr_type;
+    uint32_t	val;
+} accel_fifo_entry_t;
+
+typedef struct {
+    accel_fifo_entry_t	ring[ACCEL_FIFO_SIZE];
+
+    volatile uint32_t	read_idx,	/* only written by the worker */
+			write_idx;	/* only written by the emulator */
+
+    volatile int	sleeping,	/* worker is (about to be) blocked */
+			waiting,	/* emulator waits for the worker */
+			busy,		/* worker is processing a batch */
+			stop;
+
+    uint64_t		time;		/* time spent processing entries */
+
+    const char		*name;		/* card name, for the statistics */
+    const char		*op;		/* command of the current entry */
+
+    thread_t		*thread;
+    event_t		*wake;
+    event_t		*not_full;
+
+    void		(*process)(priv_t, uint32_t addr_type, uint32_t val);
+    void		(*idle)(priv_t);
+    priv_t		priv;
+} accel_fifo_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void	accel_fifo_init(accel_fifo_t *f, const char *name,
+				void (*process)(priv_t, uint32_t, uint32_t),
+				void (*idle)(priv_t), priv_t priv);
+extern void	accel_fifo_close(accel_fifo_t *f);
+
+extern void	accel_fifo_queue(accel_fifo_t *f, uint32_t addr_type,
+				 uint32_t val);
+extern void	accel_fifo_wake(accel_fifo_t *f);
+extern void	accel_fifo_wait_idle(accel_fifo_t *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/*VIDEO_ACCEL_FIFO_H*/
@@ -8,7 +8,7 @@
  *
  *		ATi Mach64 graphics card emulation.
  *
- * Version:	@(#)vid_ati_mach64.c	1.0.22	2020/11/01
+ * Version:	@(#)vid_ati_mach64.c	1.0.25	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -53,6 +53,8 @@
 #include "video.h"
 #include "vid_svga.h"
 #include "vid_svga_render.h"
+#include "vid_blit.h"
+#include "vid_accel_fifo.h"
 #include "vid_ati.h"
 #include "vid_ati68860_ramdac.h"
 #include "vid_ics2595.h"
@@ -68,13 +70,9 @@
 #define BIOS_ROMVT2_PATH	L"video/ati/mach64/atimach64vt2pci.bin"
 
 
-#define FIFO_SIZE 65536
-#define FIFO_MASK (FIFO_SIZE - 1)
-#define FIFO_ENTRY_SIZE (1 << 31)
-
-#define FIFO_ENTRIES (mach64->fifo_write_idx - mach64->fifo_read_idx)
-#define FIFO_FULL    ((mach64->fifo_write_idx - mach64->fifo_read_idx) >= FIFO_SIZE)
-#define FIFO_EMPTY   (mach64->fifo_read_idx == mach64->fifo_write_idx)
+#define FIFO_ENTRIES ACCEL_FIFO_ENTRIES(&mach64->fifo)
+#define FIFO_FULL    (FIFO_ENTRIES >= ACCEL_FIFO_SIZE)
+#define FIFO_EMPTY   ACCEL_FIFO_EMPTY(&mach64->fifo)
 
 #define FIFO_TYPE 0xff000000
 #define FIFO_ADDR 0x00ffffff
@@ -87,12 +85,6 @@ enum
         FIFO_WRITE_DWORD = (0x03 << 24)
 };
 
-typedef struct
-{
-        uint32_t addr_type;
-        uint32_t val;
-} fifo_entry_t;
-
 enum
 {
         MACH64_GX = 0,
@@ -233,15 +225,8 @@ typedef struct mach64_t
                 int poly_draw;
         } accel;
 
-        fifo_entry_t fifo[FIFO_SIZE];
-        volatile int fifo_read_idx, fifo_write_idx;
+        accel_fifo_t fifo;
 
-        thread_t *fifo_thread;
-        event_t *wake_fifo_thread;
-        event_t *fifo_not_full_event;
-        
-        int blitter_busy;
-        uint64_t blitter_time;
         uint64_t status_time;
         
         uint16_t pci_id;
@@ -618,18 +603,9 @@ static void mach64_update_irqs(mach64_t *mach64)
                 pci_clear_irq(mach64->card, PCI_INTA);
 }
 
-static __inline void wake_fifo_thread(mach64_t *mach64)
-{
-        thread_set_event(mach64->wake_fifo_thread); /*Wake up FIFO thread if moving from idle*/
-}
-
 static void mach64_wait_fifo_idle(mach64_t *mach64)
 {
-        while (!FIFO_EMPTY)
-        {
-                wake_fifo_thread(mach64);
-                thread_wait_event(mach64->fifo_not_full_event, 1);
-        }
+        accel_fifo_wait_idle(&mach64->fifo);
 }
 
 #define READ8(addr, var)        switch ((addr) & 3)                                     \
@@ -900,68 +876,27 @@ static void mach64_accel_write_fifo_l(mach64_t *mach64, uint32_t addr, uint32_t
         }
 }
 
-static void fifo_thread(void *param)
+static void mach64_fifo_process(priv_t priv, uint32_t addr_type, uint32_t val)
 {
-        mach64_t *mach64 = (mach64_t *)param;
-        
-        while (1)
-        {
-                thread_set_event(mach64->fifo_not_full_event);
-                thread_wait_event(mach64->wake_fifo_thread, -1);
-                thread_reset_event(mach64->wake_fifo_thread);
-                mach64->blitter_busy = 1;
-                while (!FIFO_EMPTY)
-                {
-                        uint64_t start_time = plat_timer_read();
-                        uint64_t end_time;
-                        fifo_entry_t *fifo = &mach64->fifo[mach64->fifo_read_idx & FIFO_MASK];
-
-                        switch (fifo->addr_type & FIFO_TYPE)
-                        {
-                                case FIFO_WRITE_BYTE:
-                                mach64_accel_write_fifo(mach64, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                                case FIFO_WRITE_WORD:
-                                mach64_accel_write_fifo_w(mach64, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                                case FIFO_WRITE_DWORD:
-                                mach64_accel_write_fifo_l(mach64, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                        }
-                                                
-                        mach64->fifo_read_idx++;
-                        fifo->addr_type = FIFO_INVALID;
-
-                        if (FIFO_ENTRIES > 0xe000)
-                                thread_set_event(mach64->fifo_not_full_event);
+        mach64_t *mach64 = (mach64_t *)priv;
 
-                        end_time = plat_timer_read();
-                        mach64->blitter_time += end_time - start_time;
-                }
-                mach64->blitter_busy = 0;
+        switch (addr_type & FIFO_TYPE)
+        {
+                case FIFO_WRITE_BYTE:
+                mach64_accel_write_fifo(mach64, addr_type & FIFO_ADDR, val);
+                break;
+                case FIFO_WRITE_WORD:
+                mach64_accel_write_fifo_w(mach64, addr_type & FIFO_ADDR, val);
+                break;
+                case FIFO_WRITE_DWORD:
+                mach64_accel_write_fifo_l(mach64, addr_type & FIFO_ADDR, val);
+                break;
         }
 }
 
 static void mach64_queue(mach64_t *mach64, uint32_t addr, uint32_t val, uint32_t type)
 {
-        fifo_entry_t *fifo = &mach64->fifo[mach64->fifo_write_idx & FIFO_MASK];
-
-        if (FIFO_FULL)
-        {
-                thread_reset_event(mach64->fifo_not_full_event);
-                if (FIFO_FULL)
-                {
-                        thread_wait_event(mach64->fifo_not_full_event, -1); /*Wait for room in ringbuffer*/
-                }
-        }
-
-        fifo->val = val;
-        fifo->addr_type = (addr & FIFO_ADDR) | type;
-
-        mach64->fifo_write_idx++;
-        
-        if (FIFO_ENTRIES > 0xe000 || FIFO_ENTRIES < 8)
-                wake_fifo_thread(mach64);
+        accel_fifo_queue(&mach64->fifo, (addr & FIFO_ADDR) | type, val);
 }
 
 void mach64_cursor_dump(mach64_t *mach64)
@@ -1076,6 +1011,7 @@ void mach64_start_fill(mach64_t *mach64)
 
         mach64->accel.busy = 1;
         mach64->accel.op = OP_RECT;
+        ACCEL_FIFO_OP(&mach64->fifo, "rect");
 }
 
 void mach64_start_line(mach64_t *mach64)
@@ -1148,6 +1084,7 @@ void mach64_start_line(mach64_t *mach64)
 
         mach64->accel.busy = 1;
         mach64->accel.op = OP_LINE;
+        ACCEL_FIFO_OP(&mach64->fifo, "line");
 }
 
 #define READ(addr, dat, width) if (width == 0)      dat =               svga->vram[((addr))      & mach64->vram_mask]; 	\
@@ -1205,6 +1142,137 @@ void mach64_start_line(mach64_t *mach64)
                                         svga->changedvram[(((addr) >> 3) & mach64->vram_mask) >> 12] = changeframecount;        \
                                 }
 
+/*Result of a mix that does not depend on the destination, if any*/
+static int mach64_mix_const(int mix, uint32_t src_dat, uint32_t *col)
+{
+        switch (mix)
+        {
+                case 0x1: *col =  0;       break;
+                case 0x2: *col = ~0;       break;
+                case 0x4: *col = ~src_dat; break;
+                case 0x7: *col =  src_dat; break;
+                default: return 0;
+        }
+        return 1;
+}
+
+/*
+ * Do a whole solid fill, pattern fill or screen-to-screen copy at once,
+ * clipped to the scissors. Returns 0 if the blit needs the pixel loop.
+ */
+static int mach64_blit_fast(mach64_t *mach64)
+{
+        svga_t *svga = &mach64->svga;
+        int size = mach64->accel.dst_size;
+        int xinc = mach64->accel.xinc, yinc = mach64->accel.yinc;
+        int w = mach64->accel.dst_width, h = mach64->accel.dst_height;
+        int x0 = mach64->accel.dst_x_start, y0 = mach64->accel.dst_y_start;
+        int sx0 = mach64->accel.src_x_start, sy0 = mach64->accel.src_y_start;
+        int left, top, right, bottom, x, y;
+        uint32_t fg, bg, pat[64];
+        int64_t dst, src;
+        blit_surf_t bs;
+        int ok = 1;
+
+        if (size == WIDTH_1BIT || w <= 0 || h <= 0 || mach64->accel.source_host ||
+            (mach64->dst_cntl & (DST_POLYGON_EN | DST_24_ROT_EN)) ||
+            mach64->accel.clr_cmp_fn == 1 || mach64->accel.clr_cmp_fn == 4 ||
+            mach64->accel.clr_cmp_fn == 5)
+                return 0;
+
+        /*The coordinates must not wrap around*/
+        left = (xinc > 0) ? x0 : (x0 - w + 1);
+        top  = (yinc > 0) ? y0 : (y0 - h + 1);
+        if (left < 0 || top < 0 || (left + w) > 0x1000 || (top + h) > 0x1000)
+                return 0;
+
+        switch (mach64->accel.source_mix)
+        {
+                case MONO_SRC_1:
+                if (mach64->accel.source_fg == SRC_BLITSRC)
+                {
+                        if (mach64->accel.mix_fg != 7 || mach64->accel.src_size != size ||
+                            (mach64->src_cntl & 7) || mach64->accel.src_width1 < w ||
+                            (sx0 - x0 + left) < 0 || (sx0 - x0 + left + w) > 0x1000 ||
+                            (sy0 - y0 + top) < 0 || (sy0 - y0 + top + h) > 0x1000)
+                                return 0;
+                        break;
+                }
+                if (mach64->accel.source_fg != SRC_FG && mach64->accel.source_fg != SRC_BG)
+                        return 0;
+                if (! mach64_mix_const(mach64->accel.mix_fg,
+                                       (mach64->accel.source_fg == SRC_FG) ? mach64->accel.dp_frgd_clr : mach64->accel.dp_bkgd_clr, &fg))
+                        return 0;
+                break;
+
+                case MONO_SRC_PAT:
+                if ((mach64->accel.source_fg != SRC_FG && mach64->accel.source_fg != SRC_BG) ||
+                    (mach64->accel.source_bg != SRC_FG && mach64->accel.source_bg != SRC_BG))
+                        return 0;
+                if (! mach64_mix_const(mach64->accel.mix_fg,
+                                       (mach64->accel.source_fg == SRC_FG) ? mach64->accel.dp_frgd_clr : mach64->accel.dp_bkgd_clr, &fg) ||
+                    ! mach64_mix_const(mach64->accel.mix_bg,
+                                       (mach64->accel.source_bg == SRC_FG) ? mach64->accel.dp_frgd_clr : mach64->accel.dp_bkgd_clr, &bg))
+                        return 0;
+                for (y = 0; y < 8; y++)
+                {
+                        for (x = 0; x < 8; x++)
+                                pat[y * 8 + x] = mach64->accel.pattern[y][x] ? fg : bg;
+                }
+                break;
+
+                default:
+                return 0;
+        }
+
+        /*Clip to the scissors, outside of which nothing is drawn*/
+        right = left + w - 1;
+        bottom = top + h - 1;
+        if (left < mach64->accel.sc_left) left = mach64->accel.sc_left;
+        if (right > mach64->accel.sc_right) right = mach64->accel.sc_right;
+        if (top < mach64->accel.sc_top) top = mach64->accel.sc_top;
+        if (bottom > mach64->accel.sc_bottom) bottom = mach64->accel.sc_bottom;
+
+        if (left <= right && top <= bottom)
+        {
+                bs.vram = svga->vram;
+                bs.changed = svga->changedvram;
+                bs.mask = mach64->vram_mask;
+
+                y = (yinc > 0) ? top : bottom;
+                dst = ((int64_t)mach64->accel.dst_offset + ((int64_t)y * mach64->accel.dst_pitch) + left) << size;
+
+                if (mach64->accel.source_mix == MONO_SRC_PAT)
+                        ok = blit_pattern(&bs, dst, (mach64->accel.dst_pitch << size) * yinc,
+                                          right - left + 1, bottom - top + 1, 1 << size,
+                                          pat, left, y, yinc);
+                else if (mach64->accel.source_fg == SRC_BLITSRC)
+                {
+                        src = ((int64_t)mach64->accel.src_offset + ((int64_t)(y - y0 + sy0) * mach64->accel.src_pitch) + (left - x0 + sx0)) << size;
+                        ok = blit_copy(&bs, dst, src,
+                                       (mach64->accel.dst_pitch << size) * yinc,
+                                       (mach64->accel.src_pitch << size) * yinc,
+                                       right - left + 1, bottom - top + 1, 1 << size, xinc);
+                }
+                else
+                        ok = blit_fill(&bs, dst, (mach64->accel.dst_pitch << size) * yinc,
+                                       right - left + 1, bottom - top + 1, 1 << size, fg);
+        }
+        if (! ok)
+                return 0;
+
+        /*Blit finished*/
+        mach64->accel.dst_x = 0;
+        mach64->accel.dst_y = h * yinc;
+        mach64->accel.dst_height = 0;
+        mach64->accel.busy = 0;
+        if (mach64->dst_cntl & DST_X_TILE)
+                mach64->dst_y_x = (mach64->dst_y_x & 0xfff) | ((mach64->dst_y_x + (mach64->accel.dst_width << 16)) & 0xfff0000);
+        if (mach64->dst_cntl & DST_Y_TILE)
+                mach64->dst_y_x = (mach64->dst_y_x & 0xfff0000) | ((mach64->dst_y_x + (mach64->dst_height_width & 0x1fff)) & 0xfff);
+        return 1;
+}
+
 void mach64_blit(uint32_t cpu_dat, int count, mach64_t *mach64)
 {
         svga_t *svga = &mach64->svga;
@@ -1215,9 +1283,12 @@ void mach64_blit(uint32_t cpu_dat, int count, mach64_t *mach64)
                 DEBUG("mach64_blit : return as not busy\n");
                 return;
         }
+        ACCEL_FIFO_OP(&mach64->fifo, (mach64->accel.op == OP_LINE) ? "line" : "rect");
         switch (mach64->accel.op)
         {
                 case OP_RECT:
+                if (count == -1 && mach64_blit_fast(mach64))
+                        return;
                 while (count)
                 {
                         uint32_t src_dat, dest_dat;
@@ -2037,7 +2108,7 @@ uint8_t mach64_ext_readb(uint32_t addr, priv_t priv)
                 
                 case 0x310: case 0x311:
                 if (!FIFO_EMPTY)
-                        wake_fifo_thread(mach64);
+                        accel_fifo_wake(&mach64->fifo);
                 ret = 0;
                 if (FIFO_FULL)
                         ret = 0xff;
@@ -2063,7 +2134,7 @@ uint8_t mach64_ext_readb(uint32_t addr, priv_t priv)
                 
                 case 0x338:
 /*                if (!FIFO_EMPTY)
-                        wake_fifo_thread(mach64);*/
+                        accel_fifo_wake(&mach64->fifo);*/
                 ret = FIFO_EMPTY ? 0 : 1;
                 break;
 
@@ -3351,9 +3422,7 @@ mach64_common_init(const device_t *info)
                 
         mach64->dst_cntl = 3;
 
-        mach64->wake_fifo_thread = thread_create_event();
-        mach64->fifo_not_full_event = thread_create_event();
-        mach64->fifo_thread = thread_create(fifo_thread, mach64);
+        accel_fifo_init(&mach64->fifo, info->name, mach64_fifo_process, NULL, mach64);
         
 	video_inform(DEVICE_VIDEO_GET(info->flags),
 		     (const video_timings_t *)info->vid_timing);
@@ -3420,11 +3489,9 @@ mach64_close(priv_t priv)
 {
         mach64_t *mach64 = (mach64_t *)priv;
 
+        accel_fifo_close(&mach64->fifo);
+
         svga_close(&mach64->svga);
-        
-        thread_kill(mach64->fifo_thread);
-        thread_destroy_event(mach64->wake_fifo_thread);
-        thread_destroy_event(mach64->fifo_not_full_event);
 
         free(mach64);
 }
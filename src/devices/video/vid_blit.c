@@ -0,0 +1,304 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Common kernels for the 2D blitters.
+ *
+ *		The accelerators all run their blits through a loop that
+ *		reads, mixes and writes one pixel at a time, which is the
+ *		only way to get the odd cases right. Most blits, however,
+ *		are plain fills, screen-to-screen copies, pattern fills
+ *		or text, and for those a card can decide at the start of
+ *		the blit that the whole rectangle can be done here, a row
+ *		at a time.
+ *
+ *		All kernels work on byte addresses in a blit_surf_t, and
+ *		refuse (return 0) if any part of the rectangle would wrap
+ *		around the end of video memory, in which case the caller
+ *		falls back to its own loop.
+ *
+ * Version:	@(#)vid_blit.c	1.0.2	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#include "../../emu.h"
+#include "video.h"
+#include "vid_blit.h"
+
+
+/* Mark a range of video memory as changed. */
+static void
+blit_dirty(const blit_surf_t *bs, uint32_t addr, int len)
+{
+    uint32_t pg, end;
+
+    end = (addr + len - 1) >> 12;
+    for (pg = addr >> 12; pg <= end; pg++)
+	bs->changed[pg] = changeframecount;
+}
+
+
+static __inline void
+put_pixel(uint8_t *p, int bpp, uint32_t col)
+{
+    switch (bpp) {
+	case 1:
+		*p = col;
+		break;
+
+	case 2:
+		*(uint16_t *)p = col;
+		break;
+
+	case 3:
+		p[0] = col;
+		p[1] = col >> 8;
+		p[2] = col >> 16;
+		break;
+
+	case 4:
+		*(uint32_t *)p = col;
+		break;
+    }
+}
+
+
+/* Check that h rows of len bytes all lie within video memory. */
+int
+blit_fits(const blit_surf_t *bs, int64_t addr, int pitch, int len, int h)
+{
+    int64_t lo, hi;
+
+    if (len <= 0 || h <= 0)
+	return(0);
+
+    lo = addr;
+    hi = addr + (int64_t)pitch * (h - 1);
+    if (hi < lo) {
+	lo = hi;
+	hi = addr;
+    }
+
+    return(lo >= 0 && (hi + len) <= ((int64_t)bs->mask + 1));
+}
+
+
+/* Fill a rectangle of w by h pixels with a solid color. */
+int
+blit_fill(const blit_surf_t *bs, int64_t addr, int pitch, int w, int h,
+	  int bpp, uint32_t col)
+{
+    uint8_t *p;
+    uint32_t a;
+    int x, y;
+
+    if (! blit_fits(bs, addr, pitch, w * bpp, h))
+	return(0);
+
+    for (y = 0; y < h; y++) {
+	a = (uint32_t)(addr + (int64_t)pitch * y);
+	p = &bs->vram[a];
+
+	if (bpp == 1) {
+		memset(p, col, w);
+	} else if (bpp == 3) {
+		/* Write one pixel, then double it up to the full row. */
+		put_pixel(p, 3, col);
+		for (x = 3; x < w * 3; x <<= 1)
+			memcpy(p + x, p, ((w * 3) - x) < x ? (w * 3) - x : x);
+	} else for (x = 0; x < w; x++) {
+		put_pixel(p, bpp, col);
+		p += bpp;
+	}
+
+	blit_dirty(bs, a, w * bpp);
+    }
+
+    return(1);
+}
+
+
+/*
+ * Copy a rectangle, with rows handled in the caller's order.
+ *
+ * The pitches carry the vertical direction of the blit, and xdir is
+ * the direction in which the caller's loop would walk each row. A row
+ * can only be moved as a whole if that gives the same result as the
+ * pixel loop would, which is not the case when the loop runs into the
+ * part of the row it has already written; leave those to the caller.
+ */
+int
+blit_copy(const blit_surf_t *bs, int64_t dst, int64_t src, int dpitch,
+	  int spitch, int w, int h, int bpp, int xdir)
+{
+    int64_t d, s;
+    int len = w * bpp;
+    int y;
+
+    if (! blit_fits(bs, dst, dpitch, len, h) ||
+	! blit_fits(bs, src, spitch, len, h)) return(0);
+
+    for (y = 0; y < h; y++) {
+	d = dst + (int64_t)dpitch * y;
+	s = src + (int64_t)spitch * y;
+	if (d > s && d < (s + len) && xdir > 0)
+		return(0);
+	if (d < s && (d + len) > s && xdir < 0)
+		return(0);
+    }
+
+    for (y = 0; y < h; y++) {
+	d = dst + (int64_t)dpitch * y;
+	s = src + (int64_t)spitch * y;
+
+	memmove(&bs->vram[(uint32_t)d], &bs->vram[(uint32_t)s], len);
+
+	blit_dirty(bs, (uint32_t)d, len);
+    }
+
+    return(1);
+}
+
+
+/*
+ * Fill a rectangle of len bytes by h rows from a tile.
+ *
+ * The tile is tw bytes wide and th rows high, and is aligned so that
+ * the leftmost byte of the first row comes from column tx of tile row
+ * ty; every next row uses the tile row tydir further on.
+ */
+int
+blit_tile(const blit_surf_t *bs, int64_t addr, int pitch, int len, int h,
+	  const uint8_t *tile, int tw, int th, int tx, int ty, int tydir)
+{
+    const uint8_t *row;
+    uint8_t *p;
+    uint32_t a;
+    int n, x, y, r;
+
+    if (tw <= 0 || th <= 0 || ! blit_fits(bs, addr, pitch, len, h))
+	return(0);
+
+    tx %= tw;
+    if (tx < 0)
+	tx += tw;
+
+    for (y = 0; y < h; y++) {
+	a = (uint32_t)(addr + (int64_t)pitch * y);
+	p = &bs->vram[a];
+
+	r = (ty + (y * tydir)) % th;
+	if (r < 0)
+		r += th;
+	row = &tile[r * tw];
+
+	/* Partial tile up to the first boundary, then whole tiles. */
+	n = tw - tx;
+	if (n > len)
+		n = len;
+	memcpy(p, &row[tx], n);
+	for (x = n; x < len; x += tw)
+		memcpy(p + x, row, (len - x) < tw ? (len - x) : tw);
+
+	blit_dirty(bs, a, len);
+    }
+
+    return(1);
+}
+
+
+/*
+ * Fill a rectangle of w by h pixels from an 8x8 color pattern.
+ *
+ * The pattern is indexed [y * 8 + x], and (px,py) are the pattern
+ * coordinates of the leftmost pixel of the first row.
+ */
+int
+blit_pattern(const blit_surf_t *bs, int64_t addr, int pitch, int w, int h,
+	     int bpp, const uint32_t *pat, int px, int py, int pydir)
+{
+    uint8_t tile[8 * 8 * 4];
+    int x, y;
+
+    for (y = 0; y < 8; y++)
+	for (x = 0; x < 8; x++)
+		put_pixel(&tile[(y * 8 + x) * bpp], bpp, pat[y * 8 + x]);
+
+    return(blit_tile(bs, addr, pitch, w * bpp, h, tile, 8 * bpp, 8,
+		     (px & 7) * bpp, py & 7, pydir));
+}
+
+
+/*
+ * Expand up to 32 bits of monochrome data into a row of n pixels.
+ *
+ * Bits are used from the MSB down, leftmost pixel first. Any of the
+ * BLIT_TRANS flags leave the pixels for the matching bits untouched.
+ */
+int
+blit_mono(const blit_surf_t *bs, int64_t addr, int n, int bpp,
+	  uint32_t bits, uint32_t fg, uint32_t bg, int trans)
+{
+    uint8_t *p;
+    int x;
+
+    if (n > 32 || ! blit_fits(bs, addr, 0, n * bpp, 1))
+	return(0);
+
+    p = &bs->vram[(uint32_t)addr];
+    for (x = 0; x < n; x++) {
+	if (bits & 0x80000000) {
+		if (! (trans & BLIT_TRANS_FG))
+			put_pixel(p, bpp, fg);
+	} else {
+		if (! (trans & BLIT_TRANS_BG))
+			put_pixel(p, bpp, bg);
+	}
+	bits <<= 1;
+	p += bpp;
+    }
+
+    blit_dirty(bs, (uint32_t)addr, n * bpp);
+
+    return(1);
+}
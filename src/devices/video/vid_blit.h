@@ -0,0 +1,136 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Definitions for the common 2D blitter kernels.
+ *
+ * Version:	@(#)vid_blit.h	1.0.2	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef VIDEO_BLIT_H
+# define VIDEO_BLIT_H
+
+
+/* Common ternary raster operations. */
+#define ROP_BLACKNESS	0x00
+#define ROP_SRCCOPY	0xcc
+#define ROP_PATCOPY	0xf0
+#define ROP_WHITENESS	0xff
+
+/* Mono expansion: leave pixels for 0 (background) or 1 bits alone. */
+#define BLIT_TRANS_BG	0x01
+#define BLIT_TRANS_FG	0x02
+
+
+/* The video memory a blitter draws in. */
+typedef struct {
+    uint8_t	*vram;
+    uint8_t	*changed;		/* dirty map, one entry per 4K */
+    uint32_t	mask;			/* byte address mask */
+} blit_surf_t;
+
+
+/*
+ * Evaluate a ternary raster operation on all bits of a word at once.
+ *
+ * Each bit of the ROP code is the result for one combination of the
+ * pattern, source and destination bits, so we OR together the minterms
+ * selected by the code instead of looking up every bit separately.
+ */
+static __inline uint32_t
+blit_rop3(uint8_t rop, uint32_t dst, uint32_t src, uint32_t pat)
+{
+    uint32_t out = 0;
+
+    switch (rop) {
+	case ROP_BLACKNESS:
+		return(0);
+
+	case ROP_SRCCOPY:
+		return(src);
+
+	case ROP_PATCOPY:
+		return(pat);
+
+	case ROP_WHITENESS:
+		return(0xffffffff);
+    }
+
+    if (rop & 0x01) out |= ~pat & ~src & ~dst;
+    if (rop & 0x02) out |= ~pat & ~src &  dst;
+    if (rop & 0x04) out |= ~pat &  src & ~dst;
+    if (rop & 0x08) out |= ~pat &  src &  dst;
+    if (rop & 0x10) out |=  pat & ~src & ~dst;
+    if (rop & 0x20) out |=  pat & ~src &  dst;
+    if (rop & 0x40) out |=  pat &  src & ~dst;
+    if (rop & 0x80) out |=  pat &  src &  dst;
+
+    return(out);
+}
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int	blit_fits(const blit_surf_t *bs, int64_t addr, int pitch,
+			  int len, int h);
+
+extern int	blit_fill(const blit_surf_t *bs, int64_t addr, int pitch,
+			  int w, int h, int bpp, uint32_t col);
+extern int	blit_copy(const blit_surf_t *bs, int64_t dst, int64_t src,
+			  int dpitch, int spitch, int w, int h, int bpp,
+			  int xdir);
+extern int	blit_tile(const blit_surf_t *bs, int64_t addr, int pitch,
+			  int len, int h, const uint8_t *tile, int tw, int th,
+			  int tx, int ty, int tydir);
+extern int	blit_pattern(const blit_surf_t *bs, int64_t addr, int pitch,
+			     int w, int h, int bpp, const uint32_t *pat,
+			     int px, int py, int pydir);
+extern int	blit_mono(const blit_surf_t *bs, int64_t addr, int n,
+			  int bpp, uint32_t bits, uint32_t fg, uint32_t bg,
+			  int trans);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/*VIDEO_BLIT_H*/
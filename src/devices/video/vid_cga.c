@@ -8,7 +8,7 @@
  *
  *		Emulation of the old and new IBM CGA graphics cards.
  *
- * Version:	@(#)vid_cga.c	1.0.21	2021/05/24
+ * Version:	@(#)vid_cga.c	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -54,6 +54,7 @@
 #include "video.h"
 #include "vid_cga.h"
 #include "vid_cga_comp.h"
+#include "vid_text.h"
 
 
 #define CGA_RGB 0
@@ -285,6 +286,7 @@ cga_poll(priv_t priv)
     int cols[4];
     int col;
     int oldsc;
+    pel_t *p;
 
     if (! dev->linepos) {
 	dev->vidtime += dev->dispofftime;
@@ -326,7 +328,11 @@ cga_poll(priv_t priv)
 			}
 		}
 
-		if (dev->cgamode & 1) {
+		if (! video_draw) {
+			/* Not shown, only keep the address going. */
+			dev->ma += dev->crtc[1];
+		} else if (dev->cgamode & 1) {
+			p = &screen->line[dev->displine << 1][8];
 			for (x = 0; x < dev->crtc[1]; x++) {
 				if (dev->cgamode & 8) {	
 					chr = dev->charbuffer[x << 1];
@@ -342,21 +348,20 @@ cga_poll(priv_t priv)
 				} else
 					cols[0] = (attr >> 4) + 16;
 				if (drawcursor) {
-					for (c = 0; c < 8; c++) {
-						screen->line[(dev->displine << 1)][(x << 3) + c + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 3) + c + 8].pal =
-							cols[(fontdat[chr + dev->fontbase][dev->sc & 7] & (1 << (c ^ 7))) ? 1 : 0] ^ 15;
-					}
-				} else {
-					for (c = 0; c < 8; c++) {
-						screen->line[(dev->displine << 1)][(x << 3) + c + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 3) + c + 8].pal =
-							cols[(fontdat[chr + dev->fontbase][dev->sc & 7] & (1 << (c ^ 7))) ? 1 : 0];
-					}
+					cols[0] ^= 15;
+					cols[1] ^= 15;
 				}
+				text_put8_pal(&p[x << 3],
+					      fontdat[chr + dev->fontbase][dev->sc & 7],
+					      cols[1], cols[0]);
 				dev->ma++;
 			}
+
+			/* Both lines are the same. */
+			memcpy(&screen->line[(dev->displine << 1) + 1][8], p,
+			       (dev->crtc[1] << 3) * sizeof(pel_t));
 		} else if (! (dev->cgamode & 2)) {
+			p = &screen->line[dev->displine << 1][8];
 			for (x = 0; x < dev->crtc[1]; x++) {
 				if (dev->cgamode & 8) {
 					chr  = dev->vram[((dev->ma << 1) & 0x3fff)];
@@ -373,23 +378,16 @@ cga_poll(priv_t priv)
 					cols[0] = (attr >> 4) + 16;
 				dev->ma++;
 				if (drawcursor) {
-					for (c = 0; c < 8; c++) {
-						screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 8].pal =
-						screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 1 + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 1 + 8].pal =
-							cols[(fontdat[chr + dev->fontbase][dev->sc & 7] & (1 << (c ^ 7))) ? 1 : 0] ^ 15;
-					}
-				} else {
-					for (c = 0; c < 8; c++) {
-						screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 8].pal =
-						screen->line[(dev->displine << 1)][(x << 4) + (c << 1) + 1 + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 8].pal =
-						screen->line[(dev->displine << 1) + 1][(x << 4) + (c << 1) + 1 + 8].pal =
-						cols[(fontdat[chr + dev->fontbase][dev->sc & 7] & (1 << (c ^ 7))) ? 1 : 0];
-					}
+					cols[0] ^= 15;
+					cols[1] ^= 15;
 				}
+				text_put16_pal(&p[x << 4],
+					       fontdat[chr + dev->fontbase][dev->sc & 7],
+					       cols[1], cols[0]);
 			}
+
+			memcpy(&screen->line[(dev->displine << 1) + 1][8], p,
+			       (dev->crtc[1] << 4) * sizeof(pel_t));
 		} else if (! (dev->cgamode & 16)) {
 			cols[0] = (dev->cgacol & 15) | 16;
 			col = (dev->cgacol & 16) ? 24 : 16;
@@ -438,7 +436,7 @@ cga_poll(priv_t priv)
 				}
 			}
 		}
-	} else {
+	} else if (video_draw) {
 		cols[0] = ((dev->cgamode & 0x12) == 0x12) ? 0 : (dev->cgacol & 15) + 16;
 		if (dev->cgamode & 1) {
 			cga_hline(screen, 0, (dev->displine << 1), (dev->crtc[1] << 3) + 16, cols[0]);
@@ -454,7 +452,7 @@ cga_poll(priv_t priv)
 	else
 		x = (dev->crtc[1] << 4) + 16;
 
-	if (dev->composite) {
+	if (dev->composite && video_draw) {
 		if (dev->cgamode & 0x10)
 			border = 0x00;
 		else
@@ -15,7 +15,12 @@
  *
  *		Reworked to have its data on the heap.
  *
- * Version:	@(#)vid_cga_comp.c	1.0.9	2019/05/17
+ *		Most games draw the same lines over and over, and the CGA
+ *		even sends every line twice, so we remember the last few
+ *		hundred lines we decoded, by content, and just copy their
+ *		output if the same line shows up again.
+ *
+ * Version:	@(#)vid_cga_comp.c	1.0.10	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -86,6 +91,20 @@ static const double intensity[4] = {
 /* 2048x1536 is the maximum we can possibly support. */
 #define SCALER_MAXWIDTH 2048
 
+#define COMP_CACHE_SIZE	256			/* decoded lines we keep */
+
+
+/* A decoded line, with the input it was decoded from. */
+typedef struct {
+    uint32_t	hash;
+    uint32_t	gen;
+    int		w;
+    uint8_t	mode,
+		border;
+    uint8_t	in[SCALER_MAXWIDTH];
+    uint32_t	out[SCALER_MAXWIDTH];
+} comp_line_t;
+
 
 typedef struct {
     int		new_cga;
@@ -95,7 +114,7 @@ typedef struct {
 		mode_contrast,
 		mode_hue,
 		min_v, max_v;
-    double	video_ri, video_rq, video_gi,
+    int		video_ri, video_rq, video_gi,
 		video_gq, video_bi, video_bq;
     double	brightness,
 		contrast,
@@ -108,6 +127,10 @@ typedef struct {
     int		btemp[SCALER_MAXWIDTH + 2];
 
     int		table[1024];
+
+    uint32_t	gen;				/* bumped on update */
+    uint8_t	in[SCALER_MAXWIDTH];
+    comp_line_t	*cache[COMP_CACHE_SIZE];
 } cga_comp_t;
 
 
@@ -125,7 +148,13 @@ cga_comp_process(priv_t priv, uint8_t cgamode, uint8_t border,
 		 uint32_t blocks/*, int8_t doublewidth*/, pel_t *pels)
 {
     cga_comp_t *state = (cga_comp_t *)priv;
-    uint32_t x2;
+    int ri = state->video_ri, rq = state->video_rq;
+    int gi = state->video_gi, gq = state->video_gq;
+    int bi = state->video_bi, bq = state->video_bq;
+    int sharpness = state->video_sharpness;
+    comp_line_t *cl;
+    uint32_t x2, h, v;
+    uint8_t mode;
     pel_t *ptr;
     int x, w = blocks*4;
     int *o, *b2, *i, *ap, *bp;
@@ -136,10 +165,10 @@ cga_comp_process(priv_t priv, uint8_t cgamode, uint8_t border,
         b = bp[0]; \
         c = i[0]+i[0]; \
         d = i[-1]+i[1]; \
-        y = ((c+d)<<8) + state->video_sharpness*(c-d); \
-        rr = (int)(y + state->video_ri*(I) + state->video_rq*(Q)); \
-        gg = (int)(y + state->video_gi*(I) + state->video_gq*(Q)); \
-        bb = (int)(y + state->video_bi*(I) + state->video_bq*(Q)); \
+        y = ((c+d)<<8) + sharpness*(c-d); \
+        rr = y + ri*(I) + rq*(Q); \
+        gg = y + gi*(I) + gq*(Q); \
+        bb = y + bi*(I) + bq*(Q); \
         ++i; \
         ++ap; \
         ++bp; \
@@ -149,6 +178,30 @@ cga_comp_process(priv_t priv, uint8_t cgamode, uint8_t border,
 
 #define OUT(v) do { *o = (v); ++o; } while (0)
 
+    if (blocks > (SCALER_MAXWIDTH / 4)) {
+	blocks = SCALER_MAXWIDTH / 4;
+	w = blocks * 4;
+    }
+
+    /* Gather the input, and see if we decoded this line before. */
+    mode = cgamode & 4;
+    for (x = 0; x < w; x++)
+	state->in[x] = pels[x].pal & 0x0f;
+    h = 2166136261u ^ (w << 8) ^ (mode << 4) ^ border;
+    for (x = 0; x < w; x += 4) {
+	memcpy(&v, &state->in[x], 4);
+	h = (h ^ v) * 16777619u;
+    }
+
+    cl = state->cache[h % COMP_CACHE_SIZE];
+    if (cl != NULL && cl->hash == h && cl->gen == state->gen &&
+	cl->w == w && cl->mode == mode && cl->border == border &&
+	!memcmp(cl->in, state->in, w)) {
+	for (x = 0; x < w; x++)
+		pels[x].val = cl->out[x];
+	return;
+    }
+
     /* Simulate CGA composite output. */
     ptr = pels;
     o = state->temp;
@@ -173,7 +226,7 @@ cga_comp_process(priv_t priv, uint8_t cgamode, uint8_t border,
 	for (x2 = 0; x2 < blocks*4; ++x2) {
 		int c = (i[0]+i[0])<<3;
 		int d = (i[-1]+i[1])<<3;
-		int y = ((c+d)<<8) + state->video_sharpness*(c-d);
+		int y = ((c+d)<<8) + sharpness*(c-d);
 		++i;
 		ptr[0].val = byte_clamp(y)*0x10101;
 		ptr++;
@@ -202,6 +255,21 @@ cga_comp_process(priv_t priv, uint8_t cgamode, uint8_t border,
 		COMPOSITE_CONVERT(b, -a);
 	}
     }
+
+    /* Remember this line. */
+    cl = state->cache[h % COMP_CACHE_SIZE];
+    if (cl == NULL) {
+	cl = (comp_line_t *)mem_alloc(sizeof(comp_line_t));
+	state->cache[h % COMP_CACHE_SIZE] = cl;
+    }
+    cl->hash = h;
+    cl->gen = state->gen;
+    cl->w = w;
+    cl->mode = mode;
+    cl->border = border;
+    memcpy(cl->in, state->in, w);
+    for (x = 0; x < w; x++)
+	cl->out[x] = pels[x].val;
 }
 
 
@@ -283,6 +351,9 @@ cga_comp_update(priv_t priv, uint8_t cgamode)
     state->video_bi = (int) (bi * iq_adjust_i + bq * iq_adjust_q);
     state->video_bq = (int) (-bi * iq_adjust_q + bq * iq_adjust_i);
     state->video_sharpness = (int) ((state->sharpness * 256) / 100);
+
+    /* Anything we decoded before is no longer valid. */
+    state->gen++;
 }
 
 
@@ -309,6 +380,12 @@ void
 cga_comp_close(priv_t priv)
 {
     cga_comp_t *state = (cga_comp_t *)priv;
+    int i;
+
+    for (i = 0; i < COMP_CACHE_SIZE; i++) {
+	if (state->cache[i] != NULL)
+		free(state->cache[i]);
+    }
 
     free(state);
 }
@@ -8,7 +8,7 @@
  *
  *		Emulation of Cirrus Logic cards.
  *
- * Version:	@(#)vid_cl54xx.c	1.0.41	2021/03/19
+ * Version:	@(#)vid_cl54xx.c	1.0.42	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1139,6 +1139,7 @@ gd54xx_out(uint16_t addr, uint8_t val, priv_t priv)
 							svga_recalctimings(svga);
 					}
 				} else {
+					svga_render_sync(svga);
 					svga->vgapal[indx].r = svga->dac_r;
 					svga->vgapal[indx].g = svga->dac_g;
 					svga->vgapal[indx].b = val; 
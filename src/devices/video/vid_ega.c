@@ -9,7 +9,7 @@
  *		Emulation of the EGA, Chips & Technologies SuperEGA, and
  *		AX JEGA graphics cards.
  *
- * Version:	@(#)vid_ega.c	1.0.21	2019/05/17
+ * Version:	@(#)vid_ega.c	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -54,6 +54,7 @@
 #include "video.h"
 #include "vid_ega.h"
 #include "vid_ega_render.h"
+#include "vid_text.h"
 
 
 #define BIOS_IBM_PATH		L"video/ibm/ega/ibm_6277356_ega_card_u44_27128.bin"
@@ -269,6 +270,8 @@ ega_recalctimings(ega_t *dev)
     double _dispontime, _dispofftime, disptime;
     double crtcconst;
 
+    text_cache_flush((text_cache_t *)dev->text);
+
     dev->vtotal = dev->crtc[6];
     dev->dispend = dev->crtc[0x12];
     dev->vsyncstart = dev->crtc[0x10];
@@ -347,18 +350,24 @@ ega_poll(priv_t priv)
 			video_blit_wait_buffer();
 		}
 
-		if (dev->scrblank)
+		if (! video_draw) {
+			/* Not shown, so draw all of the next one that is. */
+			fullchange = changeframecount;
+		} else if (dev->scrblank) {
 			ega_render_blank(dev);
-		else if (!(dev->gdcreg[6] & 1)) {
+			text_cache_flush((text_cache_t *)dev->text);
+		} else if (!(dev->gdcreg[6] & 1)) {
 			if (fullchange) {
 #ifdef JEGA
-				if (jega_enabled(dev))
+				if (jega_enabled(dev)) {
 					ega_render_text_jega(dev, drawcursor);
-				else
+					text_cache_flush((text_cache_t *)dev->text);
+				} else
 #endif
 				ega_render_text_standard(dev, drawcursor);
 			}
 		} else {
+			text_cache_flush((text_cache_t *)dev->text);
 			switch (dev->gdcreg[5] & 0x20) {
 				case 0x00:
 					if (dev->seqregs[1] & 8)
@@ -1117,6 +1126,8 @@ ega_close(priv_t priv)
 {
     ega_t *dev = (ega_t *)priv;
 
+    text_cache_close((text_cache_t *)dev->text);
+
     free(dev->vram);
 
     free(dev);
@@ -1185,6 +1196,9 @@ ega_standalone_init(const device_t *info, UNUSED(void *parent))
     dev->vram_limit = device_get_config_int("memory") * 1024;
     dev->vrammask = dev->vram_limit - 1;
 
+    /* Only a standalone card owns the screen, so it can cache text. */
+    dev->text = text_cache_init();
+
     mem_map_add(&dev->mapping, 0xa0000, 0x20000,
 		ega_read,NULL,NULL, ega_write,NULL,NULL,
 		NULL, MEM_MAPPING_EXTERNAL, (priv_t)dev);
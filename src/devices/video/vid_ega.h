@@ -8,7 +8,7 @@
  *
  *		Definitions for the IBM EGA driver.
  *
- * Version:	@(#)vid_ega.h	1.0.7	2019/05/17
+ * Version:	@(#)vid_ega.h	1.0.8	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -146,6 +146,8 @@ typedef struct {
 
     int		video_res_x, video_res_y, video_bpp;
 
+    priv_t	text;			/* text cell cache, if any */
+
 #ifdef JEGA
     uint8_t	RMOD1, RMOD2, RDAGS, RDFFB, RDFSB, RDFAP,
 		RPESL, RPULP, RPSSC, RPSSU, RPSSL;
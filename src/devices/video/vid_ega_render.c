@@ -9,7 +9,7 @@
  *		EGA renderers.
  * NOTE:	FIXME: make sure this works (line 99 shadow parameter)
  *
- * Version:	@(#)vid_ega_render.c	1.0.7	2019/05/17
+ * Version:	@(#)vid_ega_render.c	1.0.8	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -49,6 +49,7 @@
 #include "video.h"
 #include "vid_ega.h"
 #include "vid_ega_render.h"
+#include "vid_text.h"
 
 
 int
@@ -97,69 +98,115 @@ ega_render_blank(ega_t *ega)
 }
 
 
+/*
+ * Get the cell cache for the current line, or NULL if the whole line
+ * has to be drawn.
+ */
+static uint32_t *
+text_line(ega_t *ega, int dl, int cw, int x_add, int cells)
+{
+    uint32_t st[16 + 6];
+    int c;
+
+    for (c = 0; c < 16; c++)
+	st[c] = ega->pallook[ega->egapal[c]];
+    st[16] = ega->ma;
+    st[17] = ega->sc;
+    st[18] = cw;
+    st[19] = x_add;
+    st[20] = cells;
+    st[21] = ega->attrregs[0x10] & 0x0c;
+
+    return(text_cache_line((text_cache_t *)ega->text, dl,
+			   text_hash(TEXT_HASH_INIT, st, 16 + 6), cells));
+}
+
+
 void
 ega_render_text_standard(ega_t *ega, int draw)
 {
     int x_add = (enable_overscan) ? 8 : 0;
     int dl = ega_display_line(ega);
-    int x, xx;
-	
-    for (x = 0; x < ega->hdisp; x++) {
+    int cw, cells, wide, x;
+    uint32_t *cp;
+    pel_t *p;
+
+    wide = (ega->seqregs[1] & 8) ? 1 : 0;
+    cw = (ega->seqregs[1] & 1) ? 8 : 9;
+    if (wide)
+	cw <<= 1;
+
+    /* Only draw the cells that fit on the line. */
+    cells = ega->hdisp;
+    if ((32 + x_add + (cells * cw)) > 2048)
+	cells = (2048 - 32 - x_add) / cw;
+
+    cp = text_line(ega, dl, cw, x_add, cells);
+    p = &screen->line[dl][32 + x_add];
+
+    for (x = 0; x < cells; x++, p += cw) {
 	int do_draw = ((ega->ma == ega->ca) && ega->con && ega->cursoron);
 	uint8_t chr  = ega->vram[(ega->ma << 1) & ega->vrammask];
 	uint8_t attr = ega->vram[((ega->ma << 1) + 1) & ega->vrammask];
+	int blink = (attr & 0x80) && (ega->attrregs[0x10] & 8);
 	uint8_t dat;
-	uint32_t fg, bg;
+	uint32_t fg, bg, key;
 	uint32_t charaddr;
-	
+
 	if (attr & 8)
 		charaddr = ega->charsetb + (chr * 128);
 	else
 		charaddr = ega->charseta + (chr * 128);
+	dat = ega->vram[charaddr + (ega->sc << 2)];
+
+	ega->ma += 4;
+	ega->ma &= ega->vrammask;
 
-	if (do_draw) { 
-		bg = ega->pallook[ega->egapal[attr & 15]]; 
-		fg = ega->pallook[ega->egapal[attr >> 4]]; 
+	if (cp != NULL) {
+		key = chr | (attr << 8) | (dat << 16);
+		if (do_draw)
+			key |= TEXT_CELL_CURSOR;
+		if (blink && (ega->blink & 16))
+			key |= TEXT_CELL_BLINK;
+		if (cp[x] == key)
+			continue;
+		cp[x] = key;
+	}
+
+	if (do_draw) {
+		bg = ega->pallook[ega->egapal[attr & 15]];
+		fg = ega->pallook[ega->egapal[attr >> 4]];
 	} else {
 		fg = ega->pallook[ega->egapal[attr & 15]];
 		bg = ega->pallook[ega->egapal[attr >> 4]];
-		if (attr & 0x80 && ega->attrregs[0x10] & 8) {
+		if (blink) {
 			bg = ega->pallook[ega->egapal[(attr >> 4) & 7]];
-			if (ega->blink & 16) 
+			if (ega->blink & 16)
 				fg = bg;
 		}
 	}
 
-	dat = ega->vram[charaddr + (ega->sc << 2)];
-	if (ega->seqregs[1] & 8) {
-		if (ega->seqregs[1] & 1) { 
-			for (xx = 0; xx < 8; xx++) 
-				screen->line[dl][((x << 4) + 32 + (xx << 1) + x_add) & 2047].val = screen->line[dl][((x << 4) + 33 + (xx << 1) + x_add) & 2047].val = (dat & (0x80 >> xx)) ? fg : bg; 
-		} else {
-			for (xx = 0; xx < 8; xx++) 
-				screen->line[dl][((x * 18) + 32 + (xx << 1) + x_add) & 2047].val = screen->line[dl][((x * 18) + 33 + (xx << 1) + x_add) & 2047].val = (dat & (0x80 >> xx)) ? fg : bg;
-			if ((chr & ~0x1f) != 0xc0 || !(ega->attrregs[0x10] & 4)) 
-				screen->line[dl][((x * 18) + 32 + 16 + x_add) & 2047].val = screen->line[dl][((x * 18) + 32 + 17 + x_add) & 2047].val = bg;
+	if (wide) {
+		text_put16(p, dat, fg, bg);
+		if (cw == 18) {
+			if ((chr & ~0x1f) != 0xc0 || !(ega->attrregs[0x10] & 4))
+				p[16].val = p[17].val = bg;
 			else
-				screen->line[dl][((x * 18) + 32 + 16 + x_add) & 2047].val = screen->line[dl][((x * 18) + 32 + 17 + x_add) & 2047].val = (dat & 1) ? fg : bg;
+				p[16].val = p[17].val = (dat & 1) ? fg : bg;
 		}
 	} else {
-		if (ega->seqregs[1] & 1) { 
-			for (xx = 0; xx < 8; xx++) 
-				screen->line[dl][((x << 3) + 32 + xx + x_add) & 2047].val = (dat & (0x80 >> xx)) ? fg : bg; 
-		} else {
-			for (xx = 0; xx < 8; xx++) 
-				screen->line[dl][((x * 9) + 32 + xx + x_add) & 2047].val = (dat & (0x80 >> xx)) ? fg : bg;
-			if ((chr & ~0x1f) != 0xc0 || !(ega->attrregs[0x10] & 4)) 
-				screen->line[dl][((x * 9) + 32 + 8 + x_add) & 2047].val = bg;
-			else		  
-				screen->line[dl][((x * 9) + 32 + 8 + x_add) & 2047].val = (dat & 1) ? fg : bg;
+		text_put8(p, dat, fg, bg);
+		if (cw == 9) {
+			if ((chr & ~0x1f) != 0xc0 || !(ega->attrregs[0x10] & 4))
+				p[8].val = bg;
+			else
+				p[8].val = (dat & 1) ? fg : bg;
 		}
 	}
-
-	ega->ma += 4; 
-	ega->ma &= ega->vrammask;
     }
+
+    /* Skip over anything we did not draw. */
+    ega->ma = (ega->ma + ((ega->hdisp - cells) << 2)) & ega->vrammask;
 }
 
 
@@ -12,7 +12,7 @@
  *
  * FIXME:	Note the madness on line 1163, fix that somehow?  --FvK
  *
- * Version:	@(#)vid_et4000w32.c	1.0.25	2020/12/02
+ * Version:	@(#)vid_et4000w32.c	1.0.28	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -57,6 +57,8 @@
 #include "../system/pci.h"
 #include "video.h"
 #include "vid_svga.h"
+#include "vid_blit.h"
+#include "vid_accel_fifo.h"
 #include "vid_icd2061.h"
 #include "vid_stg_ramdac.h"
 
@@ -65,13 +67,9 @@
 #define BIOS_ROM_PATH_CARDEX	L"video/tseng/et4000w32/cardex.vbi"
 
 
-#define FIFO_SIZE 65536
-#define FIFO_MASK (FIFO_SIZE - 1)
-#define FIFO_ENTRY_SIZE (1 << 31)
-
-#define FIFO_ENTRIES (et4000->fifo_write_idx - et4000->fifo_read_idx)
-#define FIFO_FULL    ((et4000->fifo_write_idx - et4000->fifo_read_idx) >= (FIFO_SIZE-1))
-#define FIFO_EMPTY   (et4000->fifo_read_idx == et4000->fifo_write_idx)
+#define FIFO_ENTRIES ACCEL_FIFO_ENTRIES(&et4000->fifo)
+#define FIFO_FULL    (FIFO_ENTRIES >= (ACCEL_FIFO_SIZE-1))
+#define FIFO_EMPTY   ACCEL_FIFO_EMPTY(&et4000->fifo)
 
 #define FIFO_TYPE 0xff000000
 #define FIFO_ADDR 0x00ffffff
@@ -89,12 +87,6 @@ enum
         FIFO_WRITE_MMU  = (0x02 << 24)
 };
 
-typedef struct
-{
-        uint32_t addr_type;
-        uint32_t val;
-} fifo_entry_t;
-
 typedef struct
 {
         mem_map_t linear_mapping;
@@ -149,15 +141,8 @@ typedef struct
                 uint8_t ctrl;
         } mmu;
 
-        fifo_entry_t fifo[FIFO_SIZE];
-        volatile int fifo_read_idx, fifo_write_idx;
+        accel_fifo_t fifo;
 
-        thread_t *fifo_thread;
-        event_t *wake_fifo_thread;
-        event_t *fifo_not_full_event;
-        
-        int blitter_busy;
-        uint64_t blitter_time;
         uint64_t status_time;
 	int type;
 } et4000w32p_t;
@@ -167,6 +152,7 @@ static uint8_t et4000w32p_mmu_read(uint32_t addr, priv_t);
 static void et4000w32p_mmu_write(uint32_t addr, uint8_t val, priv_t);
 static void et4000w32_blit_start(et4000w32p_t *et4000);
 static void et4000w32_blit(int count, uint32_t mix, uint32_t sdat, int cpu_input, et4000w32p_t *et4000);
+static int et4000w32_blit_fast(et4000w32p_t *et4000);
 
 
 static void
@@ -482,7 +468,8 @@ static void et4000w32p_accel_write_fifo(et4000w32p_t *et4000, uint32_t addr, uin
                 et4000w32_blit_start(et4000);
                 if (!(et4000->acl.queued.ctrl_routing & 0x43))
                 {
-                        et4000w32_blit(0xFFFFFF, ~0, 0, 0, et4000);
+                        if (!et4000w32_blit_fast(et4000))
+                                et4000w32_blit(0xFFFFFF, ~0, 0, 0, et4000);
                 }
                 if ((et4000->acl.queued.ctrl_routing & 0x40) && !(et4000->acl.internal.ctrl_routing & 3))
                         et4000w32_blit(4, ~0, 0, 0, et4000);
@@ -519,83 +506,29 @@ static void et4000w32p_accel_write_mmu(et4000w32p_t *et4000, uint32_t addr, uint
         }
 }
 
-static void fifo_thread(void *param)
+static void et4000w32p_fifo_process(priv_t priv, uint32_t addr_type, uint32_t val)
 {
-        et4000w32p_t *et4000 = (et4000w32p_t *)param;
-
-	uint64_t start_time = 0;
-	uint64_t end_time = 0;
+        et4000w32p_t *et4000 = (et4000w32p_t *)priv;
 
-	fifo_entry_t *fifo;
-        
-        while (1)
+        switch (addr_type & FIFO_TYPE)
         {
-                thread_set_event(et4000->fifo_not_full_event);
-                thread_wait_event(et4000->wake_fifo_thread, -1);
-                thread_reset_event(et4000->wake_fifo_thread);
-                et4000->blitter_busy = 1;
-                while (!FIFO_EMPTY)
-                {
-                        start_time = plat_timer_read();
-                        fifo = &et4000->fifo[et4000->fifo_read_idx & FIFO_MASK];
-
-                        switch (fifo->addr_type & FIFO_TYPE)
-                        {
-                                case FIFO_WRITE_BYTE:
-                                et4000w32p_accel_write_fifo(et4000, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                                case FIFO_WRITE_MMU:
-                                et4000w32p_accel_write_mmu(et4000, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                        }
-                                                
-                        et4000->fifo_read_idx++;
-                        fifo->addr_type = FIFO_INVALID;
-
-                        if (FIFO_ENTRIES > 0xe000)
-                                thread_set_event(et4000->fifo_not_full_event);
-
-                        end_time = plat_timer_read();
-                        et4000->blitter_time += end_time - start_time;
-                }
-                et4000->blitter_busy = 0;
+                case FIFO_WRITE_BYTE:
+                et4000w32p_accel_write_fifo(et4000, addr_type & FIFO_ADDR, val);
+                break;
+                case FIFO_WRITE_MMU:
+                et4000w32p_accel_write_mmu(et4000, addr_type & FIFO_ADDR, val);
+                break;
         }
 }
 
-static __inline void wake_fifo_thread(et4000w32p_t *et4000)
-{
-        thread_set_event(et4000->wake_fifo_thread); /*Wake up FIFO thread if moving from idle*/
-}
-
 static void et4000w32p_wait_fifo_idle(et4000w32p_t *et4000)
 {
-        while (!FIFO_EMPTY)
-        {
-                wake_fifo_thread(et4000);
-                thread_wait_event(et4000->fifo_not_full_event, 1);
-        }
+        accel_fifo_wait_idle(&et4000->fifo);
 }
 
 static void et4000w32p_queue(et4000w32p_t *et4000, uint32_t addr, uint32_t val, uint32_t type)
 {
-        fifo_entry_t *fifo = &et4000->fifo[et4000->fifo_write_idx & FIFO_MASK];
-
-        if (FIFO_FULL)
-        {
-                thread_reset_event(et4000->fifo_not_full_event);
-                if (FIFO_FULL)
-                {
-                        thread_wait_event(et4000->fifo_not_full_event, -1); /*Wait for room in ringbuffer*/
-                }
-        }
-
-        fifo->val = val;
-        fifo->addr_type = (addr & FIFO_ADDR) | type;
-
-        et4000->fifo_write_idx++;
-        
-        if (FIFO_ENTRIES > 0xe000 || FIFO_ENTRIES < 8)
-                wake_fifo_thread(et4000);
+        accel_fifo_queue(&et4000->fifo, (addr & FIFO_ADDR) | type, val);
 }
 
 static void et4000w32p_mmu_write(uint32_t addr, uint8_t val, priv_t priv)
@@ -748,6 +681,7 @@ static unsigned int et4000w32_wrap_y[8]={1,2,4,8,0xFFFFFFFF,0xFFFFFFFF,0xFFFFFFF
 /* int bltout=0; */
 static void et4000w32_blit_start(et4000w32p_t *et4000)
 {
+        ACCEL_FIFO_OP(&et4000->fifo, (et4000->acl.internal.xy_dir & 0x80) ? "line" : "bitblt");
         if (!(et4000->acl.queued.xy_dir & 0x20))
            et4000->acl.internal.error = et4000->acl.internal.dmaj / 2;
         et4000->acl.pattern_addr= et4000->acl.internal.pattern_addr;
@@ -866,15 +800,110 @@ void et4000w32_decy(et4000w32p_t *et4000)
 #endif
 }
 
+/*
+ * Do a whole screen-to-screen rectangle blit at once if it is a plain
+ * copy, pattern fill or solid fill. Returns 0 if it needs the pixel
+ * loop; the status is all the guest can see of the blitter state.
+ */
+static int et4000w32_blit_fast(et4000w32p_t *et4000)
+{
+        svga_t *svga = &et4000->svga;
+        int xdir = (et4000->acl.internal.xy_dir & 1) ? -1 : 1;
+        int ydir = (et4000->acl.internal.xy_dir & 2) ? -1 : 1;
+        int w = et4000->acl.internal.count_x + 1;
+        int h = et4000->acl.internal.count_y + 1;
+        int dpitch = (et4000->acl.internal.dest_off + 1) * ydir;
+        int64_t dst = et4000->acl.dest_addr, src;
+        uint8_t tile[64 * 8];
+        uint32_t addr;
+        int tw, th, poff, x, y;
+        blit_surf_t bs;
+        int ok;
+
+        if (!(et4000->acl.status & ACL_XYST) || (et4000->acl.internal.xy_dir & 0x80) ||
+            (et4000->acl.internal.ctrl_routing & 0x40) ||
+            (et4000->acl.internal.ctrl_routing & 0xa) == 8 ||
+            ((int64_t)w * h) > 0xFFFFFF)
+                return 0;
+
+        bs.vram = svga->vram;
+        bs.changed = svga->changedvram;
+        bs.mask = 0x1fffff;
+
+        if (xdir < 0)
+                dst -= w - 1;
+
+        switch (et4000->acl.internal.rop_fg)
+        {
+                case ROP_BLACKNESS:
+                case ROP_WHITENESS:
+                ok = blit_fill(&bs, dst, dpitch, w, h, 1, et4000->acl.internal.rop_fg);
+                break;
+
+                case ROP_SRCCOPY:
+                /*The source must be linear, without X or Y wrapping*/
+                x = et4000->acl.internal.source_wrap & 7;
+                if ((x >= 2 && x <= 6) || ((et4000->acl.internal.source_wrap >> 4) & 7) < 4)
+                        return 0;
+                if (x == 7 && xdir > 0 && (et4000->acl.source_x + w) >= et4000w32_max_x[7])
+                        return 0;
+                src = (uint32_t)(et4000->acl.source_addr + et4000->acl.source_x);
+                if (xdir < 0)
+                        src -= w - 1;
+                ok = blit_copy(&bs, dst, src, dpitch,
+                               (et4000->acl.internal.source_off + 1) * ydir,
+                               w, h, 1, xdir);
+                break;
+
+                case ROP_PATCOPY:
+                /*Only a proper tile, walked forward, can be repeated*/
+                x = et4000->acl.internal.pattern_wrap & 7;
+                y = (et4000->acl.internal.pattern_wrap >> 4) & 7;
+                if (xdir < 0 || ydir < 0 || x < 2 || x > 6 || y > 3)
+                        return 0;
+                tw = et4000w32_max_x[x];
+                th = et4000w32_wrap_y[y];
+                poff = et4000->acl.internal.pattern_off + 1;
+                if (et4000->acl.pattern_addr != et4000->acl.pattern_back + (et4000->acl.pattern_y * poff))
+                        return 0;
+
+                /*It also must not be drawn over while we use it*/
+                addr = et4000->acl.pattern_back & 0x1fffff;
+                if (! blit_fits(&bs, addr, poff, tw, th) ||
+                    ! blit_fits(&bs, dst, dpitch, w, h))
+                        return 0;
+                if (addr < (dst + ((int64_t)dpitch * (h - 1)) + w) &&
+                    (addr + ((int64_t)poff * (th - 1)) + tw) > dst)
+                        return 0;
+
+                for (y = 0; y < th; y++)
+                        memcpy(&tile[y * tw], &svga->vram[addr + (y * poff)], tw);
+
+                ok = blit_tile(&bs, dst, dpitch, w, h, tile, tw, th,
+                               et4000->acl.pattern_x, et4000->acl.pattern_y, 1);
+                break;
+
+                default:
+                return 0;
+        }
+        if (! ok)
+                return 0;
+
+        et4000->acl.internal.pos_x = 0;
+        et4000->acl.internal.pos_y = h;
+        et4000->acl.status &= ~(ACL_XYST | ACL_SSO);
+        return 1;
+}
+
 static void et4000w32_blit(int count, uint32_t mix, uint32_t sdat, int cpu_input, et4000w32p_t *et4000)
 {
         svga_t *svga = &et4000->svga;
-        int c,d;
         uint8_t pattern, source, dest, out;
         uint8_t rop;
         int mixdat;
 
         if (!(et4000->acl.status & ACL_XYST)) return;
+        ACCEL_FIFO_OP(&et4000->fifo, (et4000->acl.internal.xy_dir & 0x80) ? "line" : "bitblt");
         if (et4000->acl.internal.xy_dir & 0x80) /*Line draw*/
         {
                 while (count--)
@@ -904,13 +933,7 @@ static void et4000w32_blit(int count, uint32_t mix, uint32_t sdat, int cpu_input
                         }
                         et4000->acl.mix_addr++;
                         rop = mixdat ? et4000->acl.internal.rop_fg : et4000->acl.internal.rop_bg;
-                        for (c = 0; c < 8; c++)
-                        {
-                                d = (dest & (1 << c)) ? 1 : 0;
-                                if (source & (1 << c))  d |= 2;
-                                if (pattern & (1 << c)) d |= 4;
-                                if (rop & (1 << d)) out |= (1 << c);
-                        }
+                        out = blit_rop3(rop, dest, source, pattern);
                         /* if (bltout) DEBUG("%06X = %02X\n", et4000->acl.dest_addr & 0x1fffff, out); */
                         if (!(et4000->acl.internal.ctrl_routing & 0x40))
                         {
@@ -1021,13 +1044,7 @@ static void et4000w32_blit(int count, uint32_t mix, uint32_t sdat, int cpu_input
                         }
 
                         rop = mixdat ? et4000->acl.internal.rop_fg : et4000->acl.internal.rop_bg;
-                        for (c = 0; c < 8; c++)
-                        {
-                                d = (dest & (1 << c)) ? 1 : 0;
-                                if (source & (1 << c))  d |= 2;
-                                if (pattern & (1 << c)) d |= 4;
-                                if (rop & (1 << d)) out |= (1 << c);
-                        }
+                        out = blit_rop3(rop, dest, source, pattern);
                         /* if (bltout) DEBUG("%06X = %02X\n", et4000->acl.dest_addr & 0x1fffff, out); */
                         if (!(et4000->acl.internal.ctrl_routing & 0x40))
                         {
@@ -1308,9 +1325,7 @@ et4000w32p_init(const device_t *info, UNUSED(void *parent))
     et4000->pci_regs[0x32] = 0x00;
     et4000->pci_regs[0x33] = 0xf0;
 
-    et4000->wake_fifo_thread = thread_create_event();
-    et4000->fifo_not_full_event = thread_create_event();
-    et4000->fifo_thread = thread_create(fifo_thread, et4000);
+    accel_fifo_init(&et4000->fifo, info->name, et4000w32p_fifo_process, NULL, et4000);
 
     video_inform(DEVICE_VIDEO_GET(info->flags),
 		 (const video_timings_t *)info->vid_timing);
@@ -1324,11 +1339,9 @@ et4000w32p_close(priv_t priv)
 {
     et4000w32p_t *et4000 = (et4000w32p_t *)priv;
 
-    svga_close(&et4000->svga);
+    accel_fifo_close(&et4000->fifo);
 
-    thread_kill(et4000->fifo_thread);
-    thread_destroy_event(et4000->wake_fifo_thread);
-    thread_destroy_event(et4000->fifo_not_full_event);
+    svga_close(&et4000->svga);
 
     free(et4000);
 }
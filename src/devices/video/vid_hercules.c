@@ -8,7 +8,7 @@
  *
  *		Hercules emulation.
  *
- * Version:	@(#)vid_hercules.c	1.0.22	2019/05/17
+ * Version:	@(#)vid_hercules.c	1.0.24	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -53,6 +53,7 @@
 #include "../system/clk.h"
 #include "../ports/parallel.h"
 #include "video.h"
+#include "vid_text.h"
 
 
 typedef struct {
@@ -263,7 +264,10 @@ hercules_poll(priv_t priv)
 		}
 		dev->lastline = dev->displine;
 
-		if ((dev->ctrl & 2) && (dev->ctrl2 & 1)) {
+		if (! video_draw) {
+			/* Not shown, only keep the address going. */
+			dev->ma += dev->crtc[1];
+		} else if ((dev->ctrl & 2) && (dev->ctrl2 & 1)) {
 			ca = (dev->sc & 3) * 0x2000;
 			if ((dev->ctrl & 0x80) && (dev->ctrl2 & 2)) 
 				ca += 0x8000;
@@ -298,8 +302,10 @@ hercules_poll(priv_t priv)
 					for (c = 0; c < 9; c++)
 					    screen->line[dev->displine][(x * 9) + c].pal = dev->cols[attr][blink][1];
 				} else {
-					for (c = 0; c < 8; c++)
-					    screen->line[dev->displine][(x * 9) + c].pal = dev->cols[attr][blink][(fontdatm[chr][dev->sc] & (1 << (c ^ 7))) ? 1 : 0];
+					text_put8_pal(&screen->line[dev->displine][x * 9],
+						      fontdatm[chr][dev->sc],
+						      dev->cols[attr][blink][1],
+						      dev->cols[attr][blink][0]);
 
 					if ((chr & ~0x1f) == 0xc0)
 						screen->line[dev->displine][(x * 9) + 8].pal = dev->cols[attr][blink][fontdatm[chr][dev->sc] & 1];
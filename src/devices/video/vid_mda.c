@@ -8,7 +8,7 @@
  *
  *		MDA emulation.
  *
- * Version:	@(#)vid_mda.c	1.0.18	2019/05/17
+ * Version:	@(#)vid_mda.c	1.0.20	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -53,6 +53,7 @@
 #include "../ports/parallel.h"
 #include "video.h"
 #include "vid_mda.h"
+#include "vid_text.h"
 
 
 static const video_timings_t mda_timings = { VID_ISA,8,16,32,8,16,32 };
@@ -189,7 +190,10 @@ mda_poll(priv_t priv)
 		}
 		dev->lastline = dev->displine;
 
-		for (x = 0; x < dev->crtc[1]; x++) {
+		/* If not shown, only keep the address going. */
+		if (! video_draw)
+			dev->ma += dev->crtc[1];
+		else for (x = 0; x < dev->crtc[1]; x++) {
 			chr  = dev->vram[(dev->ma << 1) & 0xfff];
 			attr = dev->vram[((dev->ma << 1) + 1) & 0xfff];
 			drawcursor = ((dev->ma == ca) && dev->con && dev->cursoron);
@@ -198,8 +202,9 @@ mda_poll(priv_t priv)
 				for (c = 0; c < 9; c++)
 				    pels[(x * 9) + c].pal = dev->cols[attr][blink][1];
 			} else {
-				for (c = 0; c < 8; c++)
-				    pels[(x * 9) + c].pal = dev->cols[attr][blink][(fontdatm[chr][dev->sc] & (1 << (c ^ 7))) ? 1 : 0];
+				text_put8_pal(&pels[x * 9], fontdatm[chr][dev->sc],
+					      dev->cols[attr][blink][1],
+					      dev->cols[attr][blink][0]);
 				if ((chr & ~0x1f) == 0xc0)
 					pels[(x * 9) + 8].pal = dev->cols[attr][blink][fontdatm[chr][dev->sc] & 1];
 				else
@@ -10,7 +10,7 @@
  *
  * NOTE:	ROM images need more/better organization per chipset.
  *
- * Version:	@(#)vid_s3.c	1.0.24	2021/02/22
+ * Version:	@(#)vid_s3.c	1.0.27	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -55,6 +55,8 @@
 #include "video.h"
 #include "vid_svga.h"
 #include "vid_svga_render.h"
+#include "vid_blit.h"
+#include "vid_accel_fifo.h"
 #include "vid_sdac_ramdac.h"
 #include "vid_att20c49x_ramdac.h"
 #include "vid_bt48x_ramdac.h"
@@ -111,13 +113,9 @@ enum {
     VRAM_512KB = 7
 };
 
-#define FIFO_SIZE 65536
-#define FIFO_MASK (FIFO_SIZE - 1)
-#define FIFO_ENTRY_SIZE (1 << 31)
-
-#define FIFO_ENTRIES (s3->fifo_write_idx - s3->fifo_read_idx)
-#define FIFO_FULL    ((s3->fifo_write_idx - s3->fifo_read_idx) >= FIFO_SIZE)
-#define FIFO_EMPTY   (s3->fifo_read_idx == s3->fifo_write_idx)
+#define FIFO_ENTRIES ACCEL_FIFO_ENTRIES(&s3->fifo)
+#define FIFO_FULL    (FIFO_ENTRIES >= ACCEL_FIFO_SIZE)
+#define FIFO_EMPTY   ACCEL_FIFO_EMPTY(&s3->fifo)
 
 #define FIFO_TYPE 0xff000000
 #define FIFO_ADDR 0x00ffffff
@@ -132,11 +130,6 @@ enum {
     FIFO_OUT_DWORD   = (0x06 << 24)
 };
 
-typedef struct {
-    uint32_t addr_type;
-    uint32_t val;
-} fifo_entry_t;
-
 typedef struct {
     mem_map_t linear_mapping;
     mem_map_t mmio_mapping;
@@ -208,15 +201,8 @@ typedef struct {
 	int dat_count;
     } accel;
 
-    fifo_entry_t fifo[FIFO_SIZE];
-    volatile int fifo_read_idx, fifo_write_idx;
-
-    thread_t *fifo_thread;
-    event_t *wake_fifo_thread;
-    event_t *fifo_not_full_event;
+    accel_fifo_t fifo;
 
-    int blitter_busy;
-    uint64_t blitter_time;
     uint64_t status_time;
 
     uint8_t subsys_cntl, subsys_stat;
@@ -262,21 +248,9 @@ void s3_accel_out_w(uint16_t port, uint16_t val, priv_t);
 void s3_accel_out_l(uint16_t port, uint32_t val, priv_t);
 uint8_t s3_accel_in(uint16_t port, priv_t);
 
-static __inline void
-wake_fifo_thread(s3_t *s3)
-{
-    /*Wake up FIFO thread if moving from idle*/
-    thread_set_event(s3->wake_fifo_thread);
-}
-
-
 static void s3_wait_fifo_idle(s3_t *s3)
 {
-	while (!FIFO_EMPTY)
-	{
-		wake_fifo_thread(s3);
-		thread_wait_event(s3->fifo_not_full_event, 1);
-	}
+	accel_fifo_wait_idle(&s3->fifo);
 }
 
 static void s3_update_irqs(s3_t *s3)
@@ -1001,57 +975,39 @@ static void s3_accel_write_fifo_l(s3_t *s3, uint32_t addr, uint32_t val)
 	}
 }
 
-static void fifo_thread(void *param)
+static void s3_fifo_process(priv_t priv, uint32_t addr_type, uint32_t val)
 {
-	s3_t *s3 = (s3_t *)param;
-	
-	while (1)
-	{
-		thread_set_event(s3->fifo_not_full_event);
-		thread_wait_event(s3->wake_fifo_thread, -1);
-		thread_reset_event(s3->wake_fifo_thread);
-		s3->blitter_busy = 1;
-		while (!FIFO_EMPTY)
-		{
-			uint64_t start_time = plat_timer_read();
-			uint64_t end_time;
-			fifo_entry_t *fifo = &s3->fifo[s3->fifo_read_idx & FIFO_MASK];
+	s3_t *s3 = (s3_t *)priv;
 
-			switch (fifo->addr_type & FIFO_TYPE)
-			{
-				case FIFO_WRITE_BYTE:
-				s3_accel_write_fifo(s3, fifo->addr_type & FIFO_ADDR, fifo->val);
-				break;
-				case FIFO_WRITE_WORD:
-				s3_accel_write_fifo_w(s3, fifo->addr_type & FIFO_ADDR, fifo->val);
-				break;
-				case FIFO_WRITE_DWORD:
-				s3_accel_write_fifo_l(s3, fifo->addr_type & FIFO_ADDR, fifo->val);
-				break;
-				case FIFO_OUT_BYTE:
-				s3_accel_out_fifo(s3, fifo->addr_type & FIFO_ADDR, fifo->val);
-				break;
-				case FIFO_OUT_WORD:
-				s3_accel_out_fifo_w(s3, fifo->addr_type & FIFO_ADDR, fifo->val);
-				break;
-				case FIFO_OUT_DWORD:
-				s3_accel_out_fifo_l(s3, fifo->addr_type & FIFO_ADDR, fifo->val);
-				break;
-			}
-						
-			s3->fifo_read_idx++;
-			fifo->addr_type = FIFO_INVALID;
+	switch (addr_type & FIFO_TYPE)
+	{
+		case FIFO_WRITE_BYTE:
+		s3_accel_write_fifo(s3, addr_type & FIFO_ADDR, val);
+		break;
+		case FIFO_WRITE_WORD:
+		s3_accel_write_fifo_w(s3, addr_type & FIFO_ADDR, val);
+		break;
+		case FIFO_WRITE_DWORD:
+		s3_accel_write_fifo_l(s3, addr_type & FIFO_ADDR, val);
+		break;
+		case FIFO_OUT_BYTE:
+		s3_accel_out_fifo(s3, addr_type & FIFO_ADDR, val);
+		break;
+		case FIFO_OUT_WORD:
+		s3_accel_out_fifo_w(s3, addr_type & FIFO_ADDR, val);
+		break;
+		case FIFO_OUT_DWORD:
+		s3_accel_out_fifo_l(s3, addr_type & FIFO_ADDR, val);
+		break;
+	}
+}
 
-			if (FIFO_ENTRIES > 0xe000)
-				thread_set_event(s3->fifo_not_full_event);
+static void s3_fifo_idle(priv_t priv)
+{
+	s3_t *s3 = (s3_t *)priv;
 
-			end_time = plat_timer_read();
-			s3->blitter_time += end_time - start_time;
-		}
-		s3->blitter_busy = 0;
-		s3->subsys_stat |= INT_FIFO_EMP;
-		s3_update_irqs(s3);
-	}
+	s3->subsys_stat |= INT_FIFO_EMP;
+	s3_update_irqs(s3);
 }
 
 static void s3_vblank_start(svga_t *svga)
@@ -1064,24 +1020,7 @@ static void s3_vblank_start(svga_t *svga)
 
 static void s3_queue(s3_t *s3, uint32_t addr, uint32_t val, uint32_t type)
 {
-	fifo_entry_t *fifo = &s3->fifo[s3->fifo_write_idx & FIFO_MASK];
-
-	if (FIFO_FULL)
-	{
-		thread_reset_event(s3->fifo_not_full_event);
-		if (FIFO_FULL)
-		{
-			thread_wait_event(s3->fifo_not_full_event, -1); /*Wait for room in ringbuffer*/
-		}
-	}
-
-	fifo->val = val;
-	fifo->addr_type = (addr & FIFO_ADDR) | type;
-
-	s3->fifo_write_idx++;
-	
-	if (FIFO_ENTRIES > 0xe000 || FIFO_ENTRIES < 8)
-		wake_fifo_thread(s3);
+	accel_fifo_queue(&s3->fifo, (addr & FIFO_ADDR) | type, val);
 }
 
 void s3_hwcursor_draw(svga_t *svga, int displine)
@@ -1881,14 +1820,12 @@ uint8_t s3_accel_in(uint16_t port, priv_t priv)
 		return s3->accel.maj_axis_pcnt >> 8;
 
 		case 0x9948: case 0x9ae8:
-		if (!s3->blitter_busy)
-			wake_fifo_thread(s3);
+		accel_fifo_wake(&s3->fifo);
 		if (FIFO_FULL && s3->chip >= S3_VISION864)
 			return 0xff; /*FIFO full*/
 		return 0;    /*FIFO empty*/
 		case 0x9949: case 0x9ae9:
-		if (!s3->blitter_busy)
-			wake_fifo_thread(s3);
+		accel_fifo_wake(&s3->fifo);
 		temp = 0;
 		if (s3->chip < S3_VISION864)
 		{
@@ -2330,6 +2267,224 @@ int s3_data_len(s3_t *s3)
 
 	return 4;
 }
+
+/* Result of a mix that does not depend on the destination, if any. */
+static int
+s3_mix_const(uint8_t mix, uint32_t src_dat, uint32_t *col)
+{
+	switch (mix & 0xf) {
+		case 0x1: *col =  0;	   break;
+		case 0x2: *col = ~0;	   break;
+		case 0x4: *col = ~src_dat; break;
+		case 0x7: *col =  src_dat; break;
+		default:  return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Do a whole rectangle fill, BitBlt or pattern fill that does not
+ * involve the CPU at once, clipped to the scissors. Returns 0 if the
+ * operation needs the pixel loop.
+ */
+static int
+s3_accel_fast(s3_t *s3, int cmd, int frgd_mix, int clip_t, int clip_l, int clip_b, int clip_r)
+{
+	svga_t *svga = &s3->svga;
+	int bytes = (s3->bpp == 0) ? 1 : ((s3->bpp == 1) ? 2 : 4);
+	uint32_t pix_mask = (s3->bpp == 0) ? 0xff : ((s3->bpp == 1) ? 0xffff : 0xffffffff);
+	int xdir = (s3->accel.cmd & 0x20) ? 1 : -1;
+	int ydir = (s3->accel.cmd & 0x80) ? 1 : -1;
+	int w = (s3->accel.maj_axis_pcnt & 0xfff) + 1;
+	int h = s3->accel.sy + 1;
+	int x0, y0, left, top, right, bottom, y;
+	int src_dx = 0, src_dy = 0;
+	uint32_t pat[64], col = 0, src_dat;
+	int64_t dest, src, pattern;
+	int pitch = s3->width * bytes * ydir;
+	blit_surf_t bs;
+	int ok = 1;
+
+	if ((s3->accel.multifunc[0xa] & 0xc0) == 0xc0 ||
+	    ((s3->accel.multifunc[0xe] >> 7) & 3) >= 2 ||
+	    (s3->accel.wrt_mask & pix_mask) != pix_mask || h <= 0)
+		return 0;
+
+	/*The blit always uses the foreground mix, as mix_dat is all ones.*/
+	switch (frgd_mix) {
+		case 0: src_dat = s3->accel.bkgd_color; break;
+		case 1: src_dat = s3->accel.frgd_color; break;
+		case 3: src_dat = 0; break;
+		default: return 0;
+	}
+	if (frgd_mix == 3 && cmd != 2) {
+		if ((s3->accel.frgd_mix & 0xf) != 7)
+			return 0;
+	} else if (! s3_mix_const(s3->accel.frgd_mix, src_dat, &col))
+		return 0;
+
+	if (cmd == 2) {
+		x0 = s3->accel.cx;
+		y0 = s3->accel.cy;
+	} else {
+		x0 = s3->accel.dx;
+		y0 = s3->accel.dy;
+		src_dx = s3->accel.cx - x0;
+		src_dy = s3->accel.cy - y0;
+	}
+
+	/*Clip the rectangle; what is outside is never drawn anyway.*/
+	left = (xdir > 0) ? x0 : (x0 - w + 1);
+	top = (ydir > 0) ? y0 : (y0 - h + 1);
+	right = left + w - 1;
+	bottom = top + h - 1;
+	if (left < clip_l) left = clip_l;
+	if (right > clip_r) right = clip_r;
+	if (top < clip_t) top = clip_t;
+	if (bottom > clip_b) bottom = clip_b;
+
+	if (left <= right && top <= bottom) {
+		bs.vram = svga->vram;
+		bs.changed = svga->changedvram;
+		bs.mask = s3->vram_mask;
+
+		/*Start at the first row the pixel loop would do.*/
+		y = (ydir > 0) ? top : bottom;
+		dest = ((int64_t)y * s3->width + left) * bytes;
+
+		if (frgd_mix != 3 || cmd == 2) {
+			ok = blit_fill(&bs, dest, pitch, right - left + 1,
+				       bottom - top + 1, bytes, col);
+		} else if (cmd == 6) {
+			src = ((int64_t)(y + src_dy) * s3->width + left + src_dx) * bytes;
+			ok = blit_copy(&bs, dest, src, pitch, pitch,
+				       right - left + 1, bottom - top + 1,
+				       bytes, xdir);
+		} else {
+			/*Pattern must not be drawn over while we use it.*/
+			pattern = (int64_t)s3->accel.pattern * bytes;
+			if (! blit_fits(&bs, pattern, s3->width * bytes, 8 * bytes, 8) ||
+			    ! blit_fits(&bs, dest, pitch, (right - left + 1) * bytes, bottom - top + 1))
+				return 0;
+			if (pattern < ((int64_t)(bottom + 1) * s3->width + right + 1) * bytes &&
+			    (pattern + ((int64_t)7 * s3->width + 8) * bytes) > ((int64_t)top * s3->width + left) * bytes)
+				return 0;
+
+			for (y = 0; y < 64; y++) {
+				src = pattern + ((int64_t)(y >> 3) * s3->width + (y & 7)) * bytes;
+				if (bytes == 1)
+					pat[y] = svga->vram[src];
+				else if (bytes == 2)
+					pat[y] = *(uint16_t *)&svga->vram[src];
+				else
+					pat[y] = *(uint32_t *)&svga->vram[src];
+			}
+
+			ok = blit_pattern(&bs, dest, pitch, right - left + 1,
+					  bottom - top + 1, bytes, pat, left,
+					  (ydir > 0) ? top : bottom, ydir);
+		}
+	}
+	if (! ok)
+		return 0;
+
+	/*Leave the registers as the pixel loop would.*/
+	s3->accel.sx = s3->accel.maj_axis_pcnt & 0xfff;
+	s3->accel.sy = -1;
+	switch (cmd) {
+		case 2:
+			s3->accel.cy += h * ydir;
+			s3->accel.dest = s3->accel.cy * s3->width;
+			s3->accel.cur_x = s3->accel.cx;
+			s3->accel.cur_y = s3->accel.cy;
+			break;
+
+		case 6:
+			s3->accel.cy += h * ydir;
+			s3->accel.dy += h * ydir;
+			s3->accel.src  = s3->accel.cy * s3->width;
+			s3->accel.dest = s3->accel.dy * s3->width;
+			break;
+
+		case 7:
+			s3->accel.cy = (s3->accel.cy + h * ydir) & 7;
+			s3->accel.dy += h * ydir;
+			s3->accel.src  = s3->accel.pattern + (s3->accel.cy * s3->width);
+			s3->accel.dest = s3->accel.dy * s3->width;
+			break;
+	}
+
+	return 1;
+}
+
+/*
+ * Expand a run of CPU mix bits (text) within the current row of a
+ * rectangle fill. The last pixel of the row, and of the data, is left
+ * for the pixel loop, which takes care of moving to the next row.
+ */
+static void
+s3_accel_mono(s3_t *s3, int *count, uint32_t *mix_dat, uint32_t mix_mask,
+	      int frgd_mix, int bkgd_mix, int clip_t, int clip_l, int clip_b, int clip_r)
+{
+	svga_t *svga = &s3->svga;
+	int bytes = (s3->bpp == 0) ? 1 : ((s3->bpp == 1) ? 2 : 4);
+	uint32_t pix_mask = (s3->bpp == 0) ? 0xff : ((s3->bpp == 1) ? 0xffff : 0xffffffff);
+	uint32_t fg, bg, bits;
+	blit_surf_t bs;
+	int n, trans = 0;
+
+	n = *count - 1;
+	if (n > s3->accel.sx)
+		n = s3->accel.sx;
+	if (n < 2 || n > 31 || s3->accel.sy < 0 || !(s3->accel.cmd & 0x20) ||
+	    (s3->accel.multifunc[0xa] & 0xc0) != 0x80 || s3_cpu_dest(s3) ||
+	    ((s3->accel.multifunc[0xe] >> 7) & 3) >= 2 ||
+	    (s3->accel.wrt_mask & pix_mask) != pix_mask ||
+	    (frgd_mix != 0 && frgd_mix != 1) || (bkgd_mix != 0 && bkgd_mix != 1) ||
+	    s3->accel.cy < clip_t || s3->accel.cy > clip_b ||
+	    s3->accel.cx < clip_l || (s3->accel.cx + n - 1) > clip_r)
+		return;
+
+	switch (s3->accel.frgd_mix & 0xf) {
+		case 3: trans |= BLIT_TRANS_FG; break;
+		case 7: break;
+		default: return;
+	}
+	switch (s3->accel.bkgd_mix & 0xf) {
+		case 3: trans |= BLIT_TRANS_BG; break;
+		case 7: break;
+		default: return;
+	}
+
+	fg = frgd_mix ? s3->accel.frgd_color : s3->accel.bkgd_color;
+	bg = bkgd_mix ? s3->accel.frgd_color : s3->accel.bkgd_color;
+
+	bits = *mix_dat;
+	if (mix_mask == 0x80)
+		bits <<= 24;
+	else if (mix_mask == 0x8000)
+		bits <<= 16;
+
+	bs.vram = svga->vram;
+	bs.changed = svga->changedvram;
+	bs.mask = s3->vram_mask;
+	if (! blit_mono(&bs, ((int64_t)s3->accel.cy * s3->width + s3->accel.cx) * bytes,
+			n, bytes, bits, fg, bg, trans))
+		return;
+
+	*mix_dat = (*mix_dat << n) | ((1U << n) - 1);
+	*count -= n;
+	s3->accel.cx += n;
+	s3->accel.sx -= n;
+}
+
+/* Command names for the statistics, by (cmd >> 13), +8 for Trio64. */
+static const char *s3_cmd_names[16] = {
+	"nop", "line", "rect", "poly", "cmd4", "cmd5", "bitblt", "patblt",
+	"nop", "line", "rect", "polypat", "cmd12", "cmd13", "bitblt", "patblt"
+};
+
 void s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, s3_t *s3)
 {
 	svga_t *svga = &s3->svga;
@@ -2352,6 +2507,8 @@ void s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat
 
 	if ((s3->chip == S3_TRIO64) && (s3->accel.cmd & (1 << 11)))
 		cmd |= 8;
+
+	ACCEL_FIFO_OP(&s3->fifo, s3_cmd_names[cmd]);
 	
 	if ((s3->accel.multifunc[13] >> 4) & 7)
     	srcbase = 0x100000 * ((s3->accel.multifunc[13] >> 4) & 3);
@@ -2588,6 +2745,14 @@ void s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat
 		s3->accel.pix_trans[1] = 0xff;
 		s3->accel.pix_trans[2] = 0xff;
 		s3->accel.pix_trans[3] = 0xff;
+
+		if (!cpu_input && !s3_cpu_dest(s3) &&
+		    s3_accel_fast(s3, cmd, frgd_mix, clip_t, clip_l, clip_b, clip_r))
+			return;
+		if (cpu_input)
+			s3_accel_mono(s3, &count, &mix_dat, mix_mask, frgd_mix, bkgd_mix,
+				      clip_t, clip_l, clip_b, clip_r);
+
 		while (count-- && s3->accel.sy >= 0)
 		{
 			if (s3->accel.cx >= clip_l && s3->accel.cx <= clip_r &&
@@ -2712,6 +2877,10 @@ void s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat
 
 		frgd_mix = (s3->accel.frgd_mix >> 5) & 3;
 		bkgd_mix = (s3->accel.bkgd_mix >> 5) & 3;
+
+		if (!cpu_input &&
+		    s3_accel_fast(s3, cmd, frgd_mix, clip_t, clip_l, clip_b, clip_r))
+			return;
 		
 		if (!cpu_input && frgd_mix == 3 && !vram_mask && !compare_mode &&
 		    (s3->accel.cmd & 0xa0) == 0xa0 && (s3->accel.frgd_mix & 0xf) == 7 &&
@@ -2881,6 +3050,10 @@ void s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat
 		frgd_mix = (s3->accel.frgd_mix >> 5) & 3;
 		bkgd_mix = (s3->accel.bkgd_mix >> 5) & 3;
 
+		if (!cpu_input && s3->accel.sy >= 0 &&
+		    s3_accel_fast(s3, cmd, frgd_mix, clip_t, clip_l, clip_b, clip_r))
+			return;
+
 		while (count-- && s3->accel.sy >= 0)
 		{
 			if (s3->accel.dx >= clip_l && s3->accel.dx <= clip_r &&
@@ -3429,9 +3602,7 @@ s3_init(const device_t *info, UNUSED(void *parent))
 
 	s3->chip = chip;
 
-	s3->wake_fifo_thread = thread_create_event();
-	s3->fifo_not_full_event = thread_create_event();
-	s3->fifo_thread = thread_create(fifo_thread, s3);
+	accel_fifo_init(&s3->fifo, info->name, s3_fifo_process, s3_fifo_idle, s3);
 
 	s3->int_line = 0;
 
@@ -3559,11 +3730,9 @@ static void s3_close(priv_t priv)
 	s3_t *s3 = (s3_t *)priv;
 
 
-	svga_close(&s3->svga);
+	accel_fifo_close(&s3->fifo);
 
-	thread_kill(s3->fifo_thread);
-	thread_destroy_event(s3->wake_fifo_thread);
-	thread_destroy_event(s3->fifo_not_full_event);
+	svga_close(&s3->svga);
 
 	free(s3);
 }
@@ -8,7 +8,7 @@
  *
  *		S3 ViRGE emulation.
  *
- * Version:	@(#)vid_s3_virge.c	1.0.24	2021/06/26
+ * Version:	@(#)vid_s3_virge.c	1.0.28	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -55,6 +55,8 @@
 #include "vid_ddc.h"
 #include "vid_svga.h"
 #include "vid_svga_render.h"
+#include "vid_blit.h"
+#include "vid_accel_fifo.h"
 
 
 
@@ -76,13 +78,9 @@ static int dither[4][4] =
 #define RB_FULL (RB_ENTRIES == RB_SIZE)
 #define RB_EMPTY (!RB_ENTRIES)
 
-#define FIFO_SIZE 65536
-#define FIFO_MASK (FIFO_SIZE - 1)
-#define FIFO_ENTRY_SIZE (1 << 31)
-
-#define FIFO_ENTRIES (virge->fifo_write_idx - virge->fifo_read_idx)
-#define FIFO_FULL    ((virge->fifo_write_idx - virge->fifo_read_idx) >= FIFO_SIZE)
-#define FIFO_EMPTY   (virge->fifo_read_idx == virge->fifo_write_idx)
+#define FIFO_ENTRIES ACCEL_FIFO_ENTRIES(&virge->fifo)
+#define FIFO_FULL    (FIFO_ENTRIES >= ACCEL_FIFO_SIZE)
+#define FIFO_EMPTY   ACCEL_FIFO_EMPTY(&virge->fifo)
 
 #define FIFO_TYPE 0xff000000
 #define FIFO_ADDR 0x00ffffff
@@ -115,12 +113,6 @@ enum
         FIFO_WRITE_DWORD = (0x03 << 24)
 };
 
-typedef struct
-{
-        uint32_t addr_type;
-        uint32_t val;
-} fifo_entry_t;
-
 typedef struct s3d_t
 {
         uint32_t cmd_set;
@@ -284,14 +276,7 @@ typedef struct virge_t
                 int sec_x, sec_y, sec_w, sec_h;
         } streams;
 
-        fifo_entry_t fifo[FIFO_SIZE];
-        volatile int fifo_read_idx, fifo_write_idx;
-
-        thread_t *fifo_thread;
-        event_t *wake_fifo_thread;
-        event_t *fifo_not_full_event;
-        
-        int virge_busy;
+        accel_fifo_t fifo;
 
 	uint8_t subsys_stat, subsys_cntl;
 
@@ -304,11 +289,6 @@ static video_timings_t timing_diamond_stealth3d_2000	= {VID_BUS, 2,  2,  3,  28,
 static video_timings_t timing_diamond_stealth3d_3000	= {VID_BUS, 2,  2,  4,  26, 26, 42};
 static video_timings_t timing_virge_dx			= {VID_BUS, 2,  2,  3,  28, 28, 45};
 
-static __inline void wake_fifo_thread(virge_t *virge)
-{
-        thread_set_event(virge->wake_fifo_thread); /*Wake up FIFO thread if moving from idle*/
-}
-
 static void queue_triangle(virge_t *virge);
 
 static void s3_virge_recalctimings(svga_t *svga);
@@ -826,11 +806,7 @@ static void s3_virge_vblank_start(svga_t *svga)
 
 static void s3_virge_wait_fifo_idle(virge_t *virge)
 {
-        while (!FIFO_EMPTY)
-        {
-                wake_fifo_thread(virge);
-                thread_wait_event(virge->fifo_not_full_event, 1);
-        }
+        accel_fifo_wait_idle(&virge->fifo);
 }
 
 static uint8_t s3_virge_mmio_read(uint32_t addr, priv_t priv)
@@ -842,12 +818,11 @@ static uint8_t s3_virge_mmio_read(uint32_t addr, priv_t priv)
         switch (addr & 0xffff)
         {
                 case 0x8505:
-                if (virge->s3d_busy || virge->virge_busy || !FIFO_EMPTY)
+                if (virge->s3d_busy || virge->fifo.busy || !FIFO_EMPTY)
                         ret = 0x10;
                 else
                         ret = 0x10 | (1 << 5);
-                if (!virge->virge_busy)
-                        wake_fifo_thread(virge);
+                accel_fifo_wake(&virge->fifo);
                 return ret;
                 
                 case 0x83b0: case 0x83b1: case 0x83b2: case 0x83b3:
@@ -959,13 +934,12 @@ static uint32_t s3_virge_mmio_read_l(uint32_t addr, priv_t priv)
                 break;
                 
                 case 0x8504:
-                if (virge->s3d_busy || virge->virge_busy || !FIFO_EMPTY)
+                if (virge->s3d_busy || virge->fifo.busy || !FIFO_EMPTY)
                         ret = (0x10 << 8);
                 else
                         ret = (0x10 << 8) | (1 << 13);
 		ret |= virge->subsys_stat;
-                if (!virge->virge_busy)
-                        wake_fifo_thread(virge);
+                accel_fifo_wake(&virge->fifo);
                 break;
                 case 0xa4d4:
                 s3_virge_wait_fifo_idle(virge);
@@ -1034,391 +1008,347 @@ static uint32_t s3_virge_mmio_read_l(uint32_t addr, priv_t priv)
         return ret;
 }
 
-static void fifo_thread(void *param)
+static void s3_virge_fifo_process(priv_t priv, uint32_t addr_type, uint32_t val)
 {
-        virge_t *virge = (virge_t *)param;
-        
-        while (1)
+        virge_t *virge = (virge_t *)priv;
+
+        switch (addr_type & FIFO_TYPE)
         {
-                thread_set_event(virge->fifo_not_full_event);
-                thread_wait_event(virge->wake_fifo_thread, -1);
-                thread_reset_event(virge->wake_fifo_thread);
-                virge->virge_busy = 1;
-                while (!FIFO_EMPTY)
+                case FIFO_WRITE_BYTE:
+                if (((addr_type & FIFO_ADDR) & 0xfffc) < 0x8000)
+                        s3_virge_bitblt(virge, 8, val);
+                break;
+                case FIFO_WRITE_WORD:
+                if (((addr_type & FIFO_ADDR) & 0xfffc) < 0x8000)
                 {
-                        uint64_t start_time = plat_timer_read();
-                        uint64_t end_time;
-                        fifo_entry_t *fifo = &virge->fifo[virge->fifo_read_idx & FIFO_MASK];
-                        uint32_t val = fifo->val;
-
-                        switch (fifo->addr_type & FIFO_TYPE)
+                        if (virge->s3d.cmd_set & CMD_SET_MS)
+                                s3_virge_bitblt(virge, 16, ((val >> 8) | (val << 8)) << 16);
+                        else
+                                s3_virge_bitblt(virge, 16, val);
+                }
+                break;
+                case FIFO_WRITE_DWORD:
+                if (((addr_type & FIFO_ADDR) & 0xfffc) < 0x8000)
+                {
+                        if (virge->s3d.cmd_set & CMD_SET_MS)
+                                s3_virge_bitblt(virge, 32, ((val & 0xff000000) >> 24) | ((val & 0x00ff0000) >> 8) | ((val & 0x0000ff00) << 8) | ((val & 0x000000ff) << 24));
+                        else
+                                s3_virge_bitblt(virge, 32, val);
+                }
+                else
+                {
+                        switch ((addr_type & FIFO_ADDR) & 0xfffc)
                         {
-                                case FIFO_WRITE_BYTE:
-                                if (((fifo->addr_type & FIFO_ADDR) & 0xfffc) < 0x8000)
-                                        s3_virge_bitblt(virge, 8, val);
-                                break;
-                                case FIFO_WRITE_WORD:
-                                if (((fifo->addr_type & FIFO_ADDR) & 0xfffc) < 0x8000)
+                                case 0xa000: case 0xa004: case 0xa008: case 0xa00c:
+                                case 0xa010: case 0xa014: case 0xa018: case 0xa01c:
+                                case 0xa020: case 0xa024: case 0xa028: case 0xa02c:
+                                case 0xa030: case 0xa034: case 0xa038: case 0xa03c:
+                                case 0xa040: case 0xa044: case 0xa048: case 0xa04c:
+                                case 0xa050: case 0xa054: case 0xa058: case 0xa05c:
+                                case 0xa060: case 0xa064: case 0xa068: case 0xa06c:
+                                case 0xa070: case 0xa074: case 0xa078: case 0xa07c:
+                                case 0xa080: case 0xa084: case 0xa088: case 0xa08c:
+                                case 0xa090: case 0xa094: case 0xa098: case 0xa09c:
+                                case 0xa0a0: case 0xa0a4: case 0xa0a8: case 0xa0ac:
+                                case 0xa0b0: case 0xa0b4: case 0xa0b8: case 0xa0bc:
+                                case 0xa0c0: case 0xa0c4: case 0xa0c8: case 0xa0cc:
+                                case 0xa0d0: case 0xa0d4: case 0xa0d8: case 0xa0dc:
+                                case 0xa0e0: case 0xa0e4: case 0xa0e8: case 0xa0ec:
+                                case 0xa0f0: case 0xa0f4: case 0xa0f8: case 0xa0fc:
+                                case 0xa100: case 0xa104: case 0xa108: case 0xa10c:
+                                case 0xa110: case 0xa114: case 0xa118: case 0xa11c:
+                                case 0xa120: case 0xa124: case 0xa128: case 0xa12c:
+                                case 0xa130: case 0xa134: case 0xa138: case 0xa13c:
+                                case 0xa140: case 0xa144: case 0xa148: case 0xa14c:
+                                case 0xa150: case 0xa154: case 0xa158: case 0xa15c:
+                                case 0xa160: case 0xa164: case 0xa168: case 0xa16c:
+                                case 0xa170: case 0xa174: case 0xa178: case 0xa17c:
+                                case 0xa180: case 0xa184: case 0xa188: case 0xa18c:
+                                case 0xa190: case 0xa194: case 0xa198: case 0xa19c:
+                                case 0xa1a0: case 0xa1a4: case 0xa1a8: case 0xa1ac:
+                                case 0xa1b0: case 0xa1b4: case 0xa1b8: case 0xa1bc:
+                                case 0xa1c0: case 0xa1c4: case 0xa1c8: case 0xa1cc:
+                                case 0xa1d0: case 0xa1d4: case 0xa1d8: case 0xa1dc:
+                                case 0xa1e0: case 0xa1e4: case 0xa1e8: case 0xa1ec:
+                                case 0xa1f0: case 0xa1f4: case 0xa1f8: case 0xa1fc:
                                 {
-                                        if (virge->s3d.cmd_set & CMD_SET_MS)
-                                                s3_virge_bitblt(virge, 16, ((val >> 8) | (val << 8)) << 16);
-                                        else
-                                                s3_virge_bitblt(virge, 16, val);
+                                        int x = (addr_type & FIFO_ADDR) & 4;
+                                        int y = ((addr_type & FIFO_ADDR) >> 3) & 7;
+					int color, xx;
+					int byte, addr;
+
+                                        virge->s3d.pattern_8[y*8 + x]     = val & 0xff;
+                                        virge->s3d.pattern_8[y*8 + x + 1] = val >> 8;
+                                        virge->s3d.pattern_8[y*8 + x + 2] = val >> 16;
+                                        virge->s3d.pattern_8[y*8 + x + 3] = val >> 24;
+
+                                        x = ((addr_type & FIFO_ADDR) >> 1) & 6;
+                                        y = ((addr_type & FIFO_ADDR) >> 4) & 7;
+                                        virge->s3d.pattern_16[y*8 + x]     = val & 0xffff;
+                                        virge->s3d.pattern_16[y*8 + x + 1] = val >> 16;
+
+                                        addr = ((addr_type & FIFO_ADDR) & 0x00ff);
+					for (xx = 0; xx < 4; xx++) {
+						x = ((addr + xx) / 3) % 8;
+						y = ((addr + xx) / 24) % 8;
+						color = ((addr + xx) % 3) << 3;
+						byte = (xx << 3);
+						virge->s3d.pattern_24[y*8 + x] &= ~(0xff << color);
+						virge->s3d.pattern_24[y*8 + x] |= ((val >> byte) & 0xff) << color;
+					}
+
+                                        x = ((addr_type & FIFO_ADDR) >> 2) & 7;
+                                        y = ((addr_type & FIFO_ADDR) >> 5) & 7;
+                                        virge->s3d.pattern_32[y*8 + x] = val & 0xffffff;
                                 }
                                 break;
-                                case FIFO_WRITE_DWORD:
-                                if (((fifo->addr_type & FIFO_ADDR) & 0xfffc) < 0x8000)
-                                {
-                                        if (virge->s3d.cmd_set & CMD_SET_MS)
-                                                s3_virge_bitblt(virge, 32, ((val & 0xff000000) >> 24) | ((val & 0x00ff0000) >> 8) | ((val & 0x0000ff00) << 8) | ((val & 0x000000ff) << 24));
-                                        else
-                                                s3_virge_bitblt(virge, 32, val);
-                                }
-                                else
-                                {
-                                        switch ((fifo->addr_type & FIFO_ADDR) & 0xfffc)
-                                        {
-                                                case 0xa000: case 0xa004: case 0xa008: case 0xa00c:
-                                                case 0xa010: case 0xa014: case 0xa018: case 0xa01c:
-                                                case 0xa020: case 0xa024: case 0xa028: case 0xa02c:
-                                                case 0xa030: case 0xa034: case 0xa038: case 0xa03c:
-                                                case 0xa040: case 0xa044: case 0xa048: case 0xa04c:
-                                                case 0xa050: case 0xa054: case 0xa058: case 0xa05c:
-                                                case 0xa060: case 0xa064: case 0xa068: case 0xa06c:
-                                                case 0xa070: case 0xa074: case 0xa078: case 0xa07c:
-                                                case 0xa080: case 0xa084: case 0xa088: case 0xa08c:
-                                                case 0xa090: case 0xa094: case 0xa098: case 0xa09c:
-                                                case 0xa0a0: case 0xa0a4: case 0xa0a8: case 0xa0ac:
-                                                case 0xa0b0: case 0xa0b4: case 0xa0b8: case 0xa0bc:
-                                                case 0xa0c0: case 0xa0c4: case 0xa0c8: case 0xa0cc:
-                                                case 0xa0d0: case 0xa0d4: case 0xa0d8: case 0xa0dc:
-                                                case 0xa0e0: case 0xa0e4: case 0xa0e8: case 0xa0ec:
-                                                case 0xa0f0: case 0xa0f4: case 0xa0f8: case 0xa0fc:
-                                                case 0xa100: case 0xa104: case 0xa108: case 0xa10c:
-                                                case 0xa110: case 0xa114: case 0xa118: case 0xa11c:
-                                                case 0xa120: case 0xa124: case 0xa128: case 0xa12c:
-                                                case 0xa130: case 0xa134: case 0xa138: case 0xa13c:
-                                                case 0xa140: case 0xa144: case 0xa148: case 0xa14c:
-                                                case 0xa150: case 0xa154: case 0xa158: case 0xa15c:
-                                                case 0xa160: case 0xa164: case 0xa168: case 0xa16c:
-                                                case 0xa170: case 0xa174: case 0xa178: case 0xa17c:
-                                                case 0xa180: case 0xa184: case 0xa188: case 0xa18c:
-                                                case 0xa190: case 0xa194: case 0xa198: case 0xa19c:
-                                                case 0xa1a0: case 0xa1a4: case 0xa1a8: case 0xa1ac:
-                                                case 0xa1b0: case 0xa1b4: case 0xa1b8: case 0xa1bc:
-                                                case 0xa1c0: case 0xa1c4: case 0xa1c8: case 0xa1cc:
-                                                case 0xa1d0: case 0xa1d4: case 0xa1d8: case 0xa1dc:
-                                                case 0xa1e0: case 0xa1e4: case 0xa1e8: case 0xa1ec:
-                                                case 0xa1f0: case 0xa1f4: case 0xa1f8: case 0xa1fc:
-                                                {
-                                                        int x = (fifo->addr_type & FIFO_ADDR) & 4;
-                                                        int y = ((fifo->addr_type & FIFO_ADDR) >> 3) & 7;
-                					int color, xx;
-							int byte, addr;
-                
-                                                        virge->s3d.pattern_8[y*8 + x]     = val & 0xff;
-                                                        virge->s3d.pattern_8[y*8 + x + 1] = val >> 8;
-                                                        virge->s3d.pattern_8[y*8 + x + 2] = val >> 16;
-                                                        virge->s3d.pattern_8[y*8 + x + 3] = val >> 24;
-                        
-                                                        x = ((fifo->addr_type & FIFO_ADDR) >> 1) & 6;
-                                                        y = ((fifo->addr_type & FIFO_ADDR) >> 4) & 7;
-                                                        virge->s3d.pattern_16[y*8 + x]     = val & 0xffff;
-                                                        virge->s3d.pattern_16[y*8 + x + 1] = val >> 16;
-
-                                                        addr = ((fifo->addr_type & FIFO_ADDR) & 0x00ff);
-							for (xx = 0; xx < 4; xx++) {
-					                        x = ((addr + xx) / 3) % 8;
-				        	                y = ((addr + xx) / 24) % 8;
-								color = ((addr + xx) % 3) << 3;
-								byte = (xx << 3);
-								virge->s3d.pattern_24[y*8 + x] &= ~(0xff << color);
-				                	        virge->s3d.pattern_24[y*8 + x] |= ((val >> byte) & 0xff) << color;
-							}
-
-                                                        x = ((fifo->addr_type & FIFO_ADDR) >> 2) & 7;
-                                                        y = ((fifo->addr_type & FIFO_ADDR) >> 5) & 7;
-                                                        virge->s3d.pattern_32[y*8 + x] = val & 0xffffff;
-                                                }
-                                                break;
 
-                                                case 0xa4d4: case 0xa8d4:
-                                                virge->s3d.src_base = val & 0x3ffff8;
-                                                break;
-                                                case 0xa4d8: case 0xa8d8:
-                                                virge->s3d.dest_base = val & 0x3ffff8;
-                                                break;
-                                                case 0xa4dc: case 0xa8dc:
-                                                virge->s3d.clip_l = (val >> 16) & 0x7ff;
-                                                virge->s3d.clip_r = val & 0x7ff;
-                                                break;
-                                                case 0xa4e0: case 0xa8e0:
-                                                virge->s3d.clip_t = (val >> 16) & 0x7ff;
-                                                virge->s3d.clip_b = val & 0x7ff;
-                                                break;
-                                                case 0xa4e4: case 0xa8e4:
-                                                virge->s3d.dest_str = (val >> 16) & 0xff8;
-                                                virge->s3d.src_str = val & 0xff8;
-                                                break;
-                                                case 0xa4e8: case 0xace8:
-                                                virge->s3d.mono_pat_0 = val;
-                                                break;
-                                                case 0xa4ec: case 0xacec:
-                                                virge->s3d.mono_pat_1 = val;
-                                                break;
-                                                case 0xa4f0: case 0xacf0:
-                                                virge->s3d.pat_bg_clr = val;
-                                                break;
-                                                case 0xa4f4: case 0xa8f4: case 0xacf4:
-                                                virge->s3d.pat_fg_clr = val;
-                                                break;
-                                                case 0xa4f8:
-                                                virge->s3d.src_bg_clr = val;
-                                                break;
-                                                case 0xa4fc:
-                                                virge->s3d.src_fg_clr = val;
-                                                break;
-                                                case 0xa500: case 0xa900:
-                                                virge->s3d.cmd_set = val;
-                                                if (!(val & CMD_SET_AE))
-                                                        s3_virge_bitblt(virge, -1, 0);
-                                                break;
-                                                case 0xa504:
-                                                virge->s3d.r_width = (val >> 16) & 0x7ff;
-                                                virge->s3d.r_height = val & 0x7ff;
-                                                break;
-                                                case 0xa508:
-                                                virge->s3d.rsrc_x = (val >> 16) & 0x7ff;
-                                                virge->s3d.rsrc_y = val & 0x7ff;
-                                                break;
-                                                case 0xa50c:
-                                                virge->s3d.rdest_x = (val >> 16) & 0x7ff;
-                                                virge->s3d.rdest_y = val & 0x7ff;
-                                                if (virge->s3d.cmd_set & CMD_SET_AE)
-                                                        s3_virge_bitblt(virge, -1, 0);
-                                                break;
-                                                case 0xa96c:
-                                                virge->s3d.lxend0 = (val >> 16) & 0x7ff;
-                                                virge->s3d.lxend1 = val & 0x7ff;
-                                                break;
-                                                case 0xa970:
-                                                virge->s3d.ldx = (int32_t)val;
-                                                break;
-                                                case 0xa974:
-                                                virge->s3d.lxstart = val;
-                                                break;
-                                                case 0xa978:
-                                                virge->s3d.lystart = val & 0x7ff;
-                                                break;
-                                                case 0xa97c:
-                                                virge->s3d.lycnt = val & 0x7ff;
-                                                virge->s3d.line_dir = val >> 31;
-                                                if (virge->s3d.cmd_set & CMD_SET_AE)
-                                                        s3_virge_bitblt(virge, -1, 0);
-                                                break;
+                                case 0xa4d4: case 0xa8d4:
+                                virge->s3d.src_base = val & 0x3ffff8;
+                                break;
+                                case 0xa4d8: case 0xa8d8:
+                                virge->s3d.dest_base = val & 0x3ffff8;
+                                break;
+                                case 0xa4dc: case 0xa8dc:
+                                virge->s3d.clip_l = (val >> 16) & 0x7ff;
+                                virge->s3d.clip_r = val & 0x7ff;
+                                break;
+                                case 0xa4e0: case 0xa8e0:
+                                virge->s3d.clip_t = (val >> 16) & 0x7ff;
+                                virge->s3d.clip_b = val & 0x7ff;
+                                break;
+                                case 0xa4e4: case 0xa8e4:
+                                virge->s3d.dest_str = (val >> 16) & 0xff8;
+                                virge->s3d.src_str = val & 0xff8;
+                                break;
+                                case 0xa4e8: case 0xace8:
+                                virge->s3d.mono_pat_0 = val;
+                                break;
+                                case 0xa4ec: case 0xacec:
+                                virge->s3d.mono_pat_1 = val;
+                                break;
+                                case 0xa4f0: case 0xacf0:
+                                virge->s3d.pat_bg_clr = val;
+                                break;
+                                case 0xa4f4: case 0xa8f4: case 0xacf4:
+                                virge->s3d.pat_fg_clr = val;
+                                break;
+                                case 0xa4f8:
+                                virge->s3d.src_bg_clr = val;
+                                break;
+                                case 0xa4fc:
+                                virge->s3d.src_fg_clr = val;
+                                break;
+                                case 0xa500: case 0xa900:
+                                virge->s3d.cmd_set = val;
+                                if (!(val & CMD_SET_AE))
+                                        s3_virge_bitblt(virge, -1, 0);
+                                break;
+                                case 0xa504:
+                                virge->s3d.r_width = (val >> 16) & 0x7ff;
+                                virge->s3d.r_height = val & 0x7ff;
+                                break;
+                                case 0xa508:
+                                virge->s3d.rsrc_x = (val >> 16) & 0x7ff;
+                                virge->s3d.rsrc_y = val & 0x7ff;
+                                break;
+                                case 0xa50c:
+                                virge->s3d.rdest_x = (val >> 16) & 0x7ff;
+                                virge->s3d.rdest_y = val & 0x7ff;
+                                if (virge->s3d.cmd_set & CMD_SET_AE)
+                                        s3_virge_bitblt(virge, -1, 0);
+                                break;
+                                case 0xa96c:
+                                virge->s3d.lxend0 = (val >> 16) & 0x7ff;
+                                virge->s3d.lxend1 = val & 0x7ff;
+                                break;
+                                case 0xa970:
+                                virge->s3d.ldx = (int32_t)val;
+                                break;
+                                case 0xa974:
+                                virge->s3d.lxstart = val;
+                                break;
+                                case 0xa978:
+                                virge->s3d.lystart = val & 0x7ff;
+                                break;
+                                case 0xa97c:
+                                virge->s3d.lycnt = val & 0x7ff;
+                                virge->s3d.line_dir = val >> 31;
+                                if (virge->s3d.cmd_set & CMD_SET_AE)
+                                        s3_virge_bitblt(virge, -1, 0);
+                                break;
 
-                                                case 0xad00:
-                                                virge->s3d.cmd_set = val;
-                                                if (!(val & CMD_SET_AE))
-                                                        s3_virge_bitblt(virge, -1, 0);
-                                                break;
-                                                case 0xad68:
-                                                virge->s3d.prdx = val;
-                                                break;
-                                                case 0xad6c:
-                                                virge->s3d.prxstart = val;
-                                                break;
-                                                case 0xad70:
-                                                virge->s3d.pldx = val;
-                                                break;
-                                                case 0xad74:
-                                                virge->s3d.plxstart = val;
-                                                break;
-                                                case 0xad78:
-                                                virge->s3d.pystart = val & 0x7ff;
-                                                break;
-                                                case 0xad7c:
-                                                virge->s3d.pycnt = val & 0x300007ff;
-                                                if (virge->s3d.cmd_set & CMD_SET_AE)
-                                                        s3_virge_bitblt(virge, -1, 0);
-                                                break;
-                
-                                                case 0xb4d4:
-                                                virge->s3d_tri.z_base = val & 0x3ffff8;
-                                                break;
-                                                case 0xb4d8:
-                                                virge->s3d_tri.dest_base = val & 0x3ffff8;
-                                                break;
-                                                case 0xb4dc:
-                                                virge->s3d_tri.clip_l = (val >> 16) & 0x7ff;
-                                                virge->s3d_tri.clip_r = val & 0x7ff;
-                                                break;
-                                                case 0xb4e0:
-                                                virge->s3d_tri.clip_t = (val >> 16) & 0x7ff;
-                                                virge->s3d_tri.clip_b = val & 0x7ff;
-                                                break;
-                                                case 0xb4e4:
-                                                virge->s3d_tri.dest_str = (val >> 16) & 0xff8;
-                                                virge->s3d.src_str = val & 0xff8;
-                                                break;
-                                                case 0xb4e8:
-                                                virge->s3d_tri.z_str = val & 0xff8;
-                                                break;
-                                                case 0xb4ec:
-                                                virge->s3d_tri.tex_base = val & 0x3ffff8;
-                                                break;
-                                                case 0xb4f0:
-                                                virge->s3d_tri.tex_bdr_clr = val & 0xffffff;
-                                                break;
-                                                case 0xb500:
-                                                virge->s3d_tri.cmd_set = val;
-                                                if (!(val & CMD_SET_AE))
-                                                        queue_triangle(virge);
-                                                break;
-                                                case 0xb504:
-                                                virge->s3d_tri.tbv = val & 0xfffff;
-                                                break;
-                                                case 0xb508:
-                                                virge->s3d_tri.tbu = val & 0xfffff;
-                                                break;
-                                                case 0xb50c:
-                                                virge->s3d_tri.TdWdX = val;
-                                                break;
-                                                case 0xb510:
-                                                virge->s3d_tri.TdWdY = val;
-                                                break;
-                                                case 0xb514:
-                                                virge->s3d_tri.tws = val;
-                                                break;
-                                                case 0xb518:
-                                                virge->s3d_tri.TdDdX = val;
-                                                break;
-                                                case 0xb51c:
-                                                virge->s3d_tri.TdVdX = val;
-                                                break;
-                                                case 0xb520:
-                                                virge->s3d_tri.TdUdX = val;
-                                                break;
-                                                case 0xb524:
-                                                virge->s3d_tri.TdDdY = val;
-                                                break;
-                                                case 0xb528:
-                                                virge->s3d_tri.TdVdY = val;
-                                                break;
-                                                case 0xb52c:
-                                                virge->s3d_tri.TdUdY = val;
-                                                break;
-                                                case 0xb530:
-                                                virge->s3d_tri.tds = val;
-                                                break;
-                                                case 0xb534:
-                                                virge->s3d_tri.tvs = val;
-                                                break;
-                                                case 0xb538:
-                                                virge->s3d_tri.tus = val;
-                                                break;
-                                                case 0xb53c:
-                                                virge->s3d_tri.TdGdX = val >> 16;
-                                                virge->s3d_tri.TdBdX = val & 0xffff;
-                                                break;
-                                                case 0xb540:
-                                                virge->s3d_tri.TdAdX = val >> 16;
-                                                virge->s3d_tri.TdRdX = val & 0xffff;
-                                                break;
-                                                case 0xb544:
-                                                virge->s3d_tri.TdGdY = val >> 16;
-                                                virge->s3d_tri.TdBdY = val & 0xffff;
-                                                break;
-                                                case 0xb548:
-                                                virge->s3d_tri.TdAdY = val >> 16;
-                                                virge->s3d_tri.TdRdY = val & 0xffff;
-                                                break;
-                                                case 0xb54c:
-                                                virge->s3d_tri.tgs = (val >> 16) & 0xffff;
-                                                virge->s3d_tri.tbs = val & 0xffff;
-                                                break;
-                                                case 0xb550:
-                                                virge->s3d_tri.tas = (val >> 16) & 0xffff;
-                                                virge->s3d_tri.trs = val & 0xffff;
-                                                break;
-                
-                                                case 0xb554:
-                                                virge->s3d_tri.TdZdX = val;
-                                                break;
-                                                case 0xb558:
-                                                virge->s3d_tri.TdZdY = val;
-                                                break;
-                                                case 0xb55c:
-                                                virge->s3d_tri.tzs = val;
-                                                break;
-                                                case 0xb560:
-                                                virge->s3d_tri.TdXdY12 = val;
-                                                break;
-                                                case 0xb564:
-                                                virge->s3d_tri.txend12 = val;
-                                                break;
-                                                case 0xb568:
-                                                virge->s3d_tri.TdXdY01 = val;
-                                                break;
-                                                case 0xb56c:
-                                                virge->s3d_tri.txend01 = val;
-                                                break;
-                                                case 0xb570:
-                                                virge->s3d_tri.TdXdY02 = val;
-                                                break;
-                                                case 0xb574:
-                                                virge->s3d_tri.txs = val;
-                                                break;
-                                                case 0xb578:
-                                                virge->s3d_tri.tys = val;
-                                                break;
-                                                case 0xb57c:
-                                                virge->s3d_tri.ty01 = (val >> 16) & 0x7ff;
-                                                virge->s3d_tri.ty12 = val & 0x7ff;
-                                                virge->s3d_tri.tlr = val >> 31;
-                                                if (virge->s3d_tri.cmd_set & CMD_SET_AE)
-                                                        queue_triangle(virge);
-                                                break;
-                                        }
-                                }
+                                case 0xad00:
+                                virge->s3d.cmd_set = val;
+                                if (!(val & CMD_SET_AE))
+                                        s3_virge_bitblt(virge, -1, 0);
+                                break;
+                                case 0xad68:
+                                virge->s3d.prdx = val;
+                                break;
+                                case 0xad6c:
+                                virge->s3d.prxstart = val;
+                                break;
+                                case 0xad70:
+                                virge->s3d.pldx = val;
+                                break;
+                                case 0xad74:
+                                virge->s3d.plxstart = val;
+                                break;
+                                case 0xad78:
+                                virge->s3d.pystart = val & 0x7ff;
+                                break;
+                                case 0xad7c:
+                                virge->s3d.pycnt = val & 0x300007ff;
+                                if (virge->s3d.cmd_set & CMD_SET_AE)
+                                        s3_virge_bitblt(virge, -1, 0);
                                 break;
-                        }
-                                                
-                        virge->fifo_read_idx++;
-                        fifo->addr_type = FIFO_INVALID;
 
-                        if (FIFO_ENTRIES > 0xe000)
-                                thread_set_event(virge->fifo_not_full_event);
+                                case 0xb4d4:
+                                virge->s3d_tri.z_base = val & 0x3ffff8;
+                                break;
+                                case 0xb4d8:
+                                virge->s3d_tri.dest_base = val & 0x3ffff8;
+                                break;
+                                case 0xb4dc:
+                                virge->s3d_tri.clip_l = (val >> 16) & 0x7ff;
+                                virge->s3d_tri.clip_r = val & 0x7ff;
+                                break;
+                                case 0xb4e0:
+                                virge->s3d_tri.clip_t = (val >> 16) & 0x7ff;
+                                virge->s3d_tri.clip_b = val & 0x7ff;
+                                break;
+                                case 0xb4e4:
+                                virge->s3d_tri.dest_str = (val >> 16) & 0xff8;
+                                virge->s3d.src_str = val & 0xff8;
+                                break;
+                                case 0xb4e8:
+                                virge->s3d_tri.z_str = val & 0xff8;
+                                break;
+                                case 0xb4ec:
+                                virge->s3d_tri.tex_base = val & 0x3ffff8;
+                                break;
+                                case 0xb4f0:
+                                virge->s3d_tri.tex_bdr_clr = val & 0xffffff;
+                                break;
+                                case 0xb500:
+                                virge->s3d_tri.cmd_set = val;
+                                if (!(val & CMD_SET_AE))
+                                        queue_triangle(virge);
+                                break;
+                                case 0xb504:
+                                virge->s3d_tri.tbv = val & 0xfffff;
+                                break;
+                                case 0xb508:
+                                virge->s3d_tri.tbu = val & 0xfffff;
+                                break;
+                                case 0xb50c:
+                                virge->s3d_tri.TdWdX = val;
+                                break;
+                                case 0xb510:
+                                virge->s3d_tri.TdWdY = val;
+                                break;
+                                case 0xb514:
+                                virge->s3d_tri.tws = val;
+                                break;
+                                case 0xb518:
+                                virge->s3d_tri.TdDdX = val;
+                                break;
+                                case 0xb51c:
+                                virge->s3d_tri.TdVdX = val;
+                                break;
+                                case 0xb520:
+                                virge->s3d_tri.TdUdX = val;
+                                break;
+                                case 0xb524:
+                                virge->s3d_tri.TdDdY = val;
+                                break;
+                                case 0xb528:
+                                virge->s3d_tri.TdVdY = val;
+                                break;
+                                case 0xb52c:
+                                virge->s3d_tri.TdUdY = val;
+                                break;
+                                case 0xb530:
+                                virge->s3d_tri.tds = val;
+                                break;
+                                case 0xb534:
+                                virge->s3d_tri.tvs = val;
+                                break;
+                                case 0xb538:
+                                virge->s3d_tri.tus = val;
+                                break;
+                                case 0xb53c:
+                                virge->s3d_tri.TdGdX = val >> 16;
+                                virge->s3d_tri.TdBdX = val & 0xffff;
+                                break;
+                                case 0xb540:
+                                virge->s3d_tri.TdAdX = val >> 16;
+                                virge->s3d_tri.TdRdX = val & 0xffff;
+                                break;
+                                case 0xb544:
+                                virge->s3d_tri.TdGdY = val >> 16;
+                                virge->s3d_tri.TdBdY = val & 0xffff;
+                                break;
+                                case 0xb548:
+                                virge->s3d_tri.TdAdY = val >> 16;
+                                virge->s3d_tri.TdRdY = val & 0xffff;
+                                break;
+                                case 0xb54c:
+                                virge->s3d_tri.tgs = (val >> 16) & 0xffff;
+                                virge->s3d_tri.tbs = val & 0xffff;
+                                break;
+                                case 0xb550:
+                                virge->s3d_tri.tas = (val >> 16) & 0xffff;
+                                virge->s3d_tri.trs = val & 0xffff;
+                                break;
 
-                        end_time = plat_timer_read();
-                        virge_time += end_time - start_time;
+                                case 0xb554:
+                                virge->s3d_tri.TdZdX = val;
+                                break;
+                                case 0xb558:
+                                virge->s3d_tri.TdZdY = val;
+                                break;
+                                case 0xb55c:
+                                virge->s3d_tri.tzs = val;
+                                break;
+                                case 0xb560:
+                                virge->s3d_tri.TdXdY12 = val;
+                                break;
+                                case 0xb564:
+                                virge->s3d_tri.txend12 = val;
+                                break;
+                                case 0xb568:
+                                virge->s3d_tri.TdXdY01 = val;
+                                break;
+                                case 0xb56c:
+                                virge->s3d_tri.txend01 = val;
+                                break;
+                                case 0xb570:
+                                virge->s3d_tri.TdXdY02 = val;
+                                break;
+                                case 0xb574:
+                                virge->s3d_tri.txs = val;
+                                break;
+                                case 0xb578:
+                                virge->s3d_tri.tys = val;
+                                break;
+                                case 0xb57c:
+                                virge->s3d_tri.ty01 = (val >> 16) & 0x7ff;
+                                virge->s3d_tri.ty12 = val & 0x7ff;
+                                virge->s3d_tri.tlr = val >> 31;
+                                if (virge->s3d_tri.cmd_set & CMD_SET_AE)
+                                        queue_triangle(virge);
+                                break;
+                        }
                 }
-                virge->virge_busy = 0;
+                break;
         }
 }
 
 static void s3_virge_queue(virge_t *virge, uint32_t addr, uint32_t val, uint32_t type)
 {
-        fifo_entry_t *fifo = &virge->fifo[virge->fifo_write_idx & FIFO_MASK];
-
-        if (FIFO_FULL)
-        {
-                thread_reset_event(virge->fifo_not_full_event);
-                if (FIFO_FULL)
-                {
-                        thread_wait_event(virge->fifo_not_full_event, -1); /*Wait for room in ringbuffer*/
-                }
-        }
-
-        fifo->val = val;
-        fifo->addr_type = (addr & FIFO_ADDR) | type;
-
-        virge->fifo_write_idx++;
-        
-        /* if (FIFO_ENTRIES > 0xe000)
-                wake_fifo_thread(virge); */
-        if (FIFO_ENTRIES > 0xe000 || FIFO_ENTRIES < 8)
-                wake_fifo_thread(virge);
+        accel_fifo_queue(&virge->fifo, (addr & FIFO_ADDR) | type, val);
 }
 
 static void s3_virge_mmio_write(uint32_t addr, uint8_t val, priv_t priv)
@@ -2000,14 +1930,7 @@ static void s3_virge_mmio_write_l(uint32_t addr, uint32_t val, priv_t priv)
 #define MIX()                                                   \
         do                                                      \
         {                                                       \
-                int c;                                          \
-                for (c = 0; c < 24; c++)                        \
-                {                                               \
-                        int d = (dest & (1 << c)) ? 1 : 0;      \
-                        if (source & (1 << c))  d |= 2;         \
-                        if (pattern & (1 << c)) d |= 4;         \
-                        if (virge->s3d.rop & (1 << d)) out |= (1 << c);    \
-                }                                               \
+                out = blit_rop3(virge->s3d.rop, dest, source, pattern); \
         } while (0)
 
 #define WRITE(addr, val)                                                                        \
@@ -2031,6 +1954,118 @@ static void s3_virge_mmio_write_l(uint32_t addr, uint32_t val, priv_t priv)
                 }                                                                               \
         } while (0)
 
+/*
+ * Do a whole screen-to-screen BitBlt or a rectangle fill at once, if
+ * the ROP is a plain copy or fill and nothing needs per-pixel checks.
+ */
+static int s3_virge_bitblt_fast(virge_t *virge, int x_mul, const uint32_t *pattern_data)
+{
+        svga_t *svga = &virge->svga;
+        int x_inc = (virge->s3d.cmd_set & CMD_SET_XP) ? 1 : -1;
+        int y_inc = (virge->s3d.cmd_set & CMD_SET_YP) ? 1 : -1;
+        int w = virge->s3d.r_width + 1;
+        int h = virge->s3d.r_height;
+        int dest_x = virge->s3d.rdest_x, src_x = virge->s3d.rsrc_x;
+        int top = virge->s3d.rdest_y;
+        int64_t dest_addr, src_addr;
+        uint32_t col;
+        blit_surf_t bs;
+        int ok;
+
+        if (h <= 0)
+                return 0;
+
+        /*Leftmost pixels, and no wrapping of the X coordinates*/
+        if (x_inc < 0)
+        {
+                dest_x -= w - 1;
+                src_x -= w - 1;
+        }
+        if (dest_x < 0 || src_x < 0 || (dest_x + w) > 0x800 || (src_x + w) > 0x800)
+                return 0;
+
+        if (y_inc < 0)
+                top -= h - 1;
+        if ((virge->s3d.cmd_set & CMD_SET_HC) &&
+            (dest_x < virge->s3d.clip_l || (dest_x + w - 1) > virge->s3d.clip_r ||
+             top < virge->s3d.clip_t || (top + h - 1) > virge->s3d.clip_b))
+                return 0;
+
+        bs.vram = svga->vram;
+        bs.changed = svga->changedvram;
+        bs.mask = svga->vram_mask;
+
+        dest_addr = (int64_t)virge->s3d.dest_base + (dest_x * x_mul) + ((int64_t)virge->s3d.rdest_y * virge->s3d.dest_str);
+
+        if ((virge->s3d.cmd_set & CMD_SET_COMMAND_MASK) == CMD_SET_COMMAND_BITBLT)
+        {
+                if (virge->s3d.cmd_set & (CMD_SET_IDS | CMD_SET_TP))
+                        return 0;
+
+                switch (virge->s3d.rop)
+                {
+                        case ROP_SRCCOPY:
+                        src_addr = (int64_t)virge->s3d.src_base + (src_x * x_mul) + ((int64_t)virge->s3d.rsrc_y * virge->s3d.src_str);
+                        ok = blit_copy(&bs, dest_addr, src_addr,
+                                       virge->s3d.dest_str * y_inc, virge->s3d.src_str * y_inc,
+                                       w, h, x_mul, x_inc);
+                        break;
+
+                        case ROP_PATCOPY:
+                        ok = blit_pattern(&bs, dest_addr, virge->s3d.dest_str * y_inc,
+                                          w, h, x_mul, pattern_data,
+                                          dest_x, virge->s3d.rdest_y, y_inc);
+                        break;
+
+                        case ROP_BLACKNESS:
+                        case ROP_WHITENESS:
+                        ok = blit_fill(&bs, dest_addr, virge->s3d.dest_str * y_inc,
+                                       w, h, x_mul, blit_rop3(virge->s3d.rop, 0, 0, 0));
+                        break;
+
+                        default:
+                        return 0;
+                }
+        }
+        else
+        {
+                /*Source and pattern are both the pattern foreground*/
+                col = virge->s3d.pat_fg_clr;
+                switch (virge->s3d.rop)
+                {
+                        case ROP_SRCCOPY:
+                        case ROP_PATCOPY:
+                        case ROP_BLACKNESS:
+                        case ROP_WHITENESS:
+                        col = blit_rop3(virge->s3d.rop, 0, col, col);
+                        break;
+
+                        default:
+                        return 0;
+                }
+                ok = blit_fill(&bs, dest_addr, virge->s3d.dest_str * y_inc,
+                               w, h, x_mul, col);
+        }
+        if (! ok)
+                return 0;
+
+        /*Leave the registers as the pixel loop would*/
+        virge->s3d.src_x = virge->s3d.rsrc_x;
+        virge->s3d.dest_x = virge->s3d.rdest_x;
+        virge->s3d.w = virge->s3d.r_width;
+        virge->s3d.src_y = virge->s3d.rsrc_y + (h * y_inc);
+        virge->s3d.dest_y = virge->s3d.rdest_y + (h * y_inc);
+        virge->s3d.h = 0;
+
+        return 1;
+}
+
+/* 2D command names for the statistics, by CMD_SET bits 27-30. */
+static const char *virge_cmd_names[16] = {
+        "bitblt", "cmd1", "rectfill", "line", "cmd4", "poly", "cmd6", "cmd7",
+        "cmd8", "cmd9", "cmd10", "cmd11", "cmd12", "cmd13", "cmd14", "nop"
+};
+
 static void s3_virge_bitblt(virge_t *virge, int count, uint32_t cpu_dat)
 {
 	svga_t *svga = &virge->svga;
@@ -2110,6 +2145,8 @@ static void s3_virge_bitblt(virge_t *virge, int count, uint32_t cpu_dat)
                         }
                 }
         }
+        ACCEL_FIFO_OP(&virge->fifo, virge_cmd_names[(virge->s3d.cmd_set >> 27) & 15]);
+
         switch (virge->s3d.cmd_set & CMD_SET_COMMAND_MASK)
         {
                 case CMD_SET_COMMAND_NOP:
@@ -2140,6 +2177,9 @@ static void s3_virge_bitblt(virge_t *virge, int count, uint32_t cpu_dat)
                         
                         if (virge->s3d.cmd_set & CMD_SET_IDS)
                                 return;
+
+                        if (s3_virge_bitblt_fast(virge, x_mul, pattern_data))
+                                return;
                 }
                 if (!virge->s3d.h)
                         return;
@@ -2263,6 +2303,9 @@ static void s3_virge_bitblt(virge_t *virge, int count, uint32_t cpu_dat)
                                                                  virge->s3d.w,
                                                                  virge->s3d.h,
                                                                  virge->s3d.rop, virge->s3d.dest_base);
+
+                        if (s3_virge_bitblt_fast(virge, x_mul, pattern_data))
+                                return;
                 }
 
                 while (count && virge->s3d.h)
@@ -3453,20 +3496,28 @@ static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 static void render_thread(void *param)
 {
         virge_t *virge = (virge_t *)param;
+        uint64_t start;
+        int tris;
         
         while (1)
         {
                 thread_wait_event(virge->wake_render_thread, -1);
                 thread_reset_event(virge->wake_render_thread);
                 virge->s3d_busy = 1;
+                start = video_stats_on ? plat_timer_read() : 0;
+                tris = 0;
                 while (!RB_EMPTY)
                 {
                         s3_virge_triangle(virge, &virge->s3d_buffer[virge->s3d_read_idx & RB_MASK]);
                         virge->s3d_read_idx++;
+                        tris++;
                         
                         if (RB_ENTRIES == RB_SIZE - 1)
                                 thread_set_event(virge->not_full_event);
                 }
+                if (video_stats_on && tris)
+                        video_stats_add(VSTAT_ACCEL, virge->fifo.name, "triangle",
+                                        tris, plat_timer_read() - start);
                 virge->s3d_busy = 0;
                 virge->subsys_stat |= INT_S3D_DONE;
                 s3_virge_update_irqs(virge);
@@ -3475,6 +3526,9 @@ static void render_thread(void *param)
 
 static void queue_triangle(virge_t *virge)
 {
+        /* This only queues it, the render thread accounts for the drawing. */
+        ACCEL_FIFO_OP(&virge->fifo, "triangle_queue");
+
         if (RB_FULL)
         {
                 thread_reset_event(virge->not_full_event);
@@ -4050,9 +4104,7 @@ s3_virge_init(const device_t *info, UNUSED(void *parent))
     virge->not_full_event = thread_create_event();
     virge->render_thread = thread_create(render_thread, virge);
 
-    virge->wake_fifo_thread = thread_create_event();
-    virge->fifo_not_full_event = thread_create_event();
-    virge->fifo_thread = thread_create(fifo_thread, virge);
+    accel_fifo_init(&virge->fifo, info->name, s3_virge_fifo_process, NULL, virge);
 
     virge->i2c = i2c_gpio_init("ddc_s3_virge");
     virge->ddc = ddc_init(i2c_gpio_get_bus(virge->i2c));
@@ -4066,15 +4118,14 @@ s3_virge_close(priv_t priv)
 {
     virge_t *virge = (virge_t *)priv;
 
+    /* The FIFO worker can still queue 3D work, so stop it first. */
+    accel_fifo_close(&virge->fifo);
+
     thread_kill(virge->render_thread);
     thread_destroy_event(virge->not_full_event);
     thread_destroy_event(virge->wake_main_thread);
     thread_destroy_event(virge->wake_render_thread);
 
-    thread_kill(virge->fifo_thread);
-    thread_destroy_event(virge->wake_fifo_thread);
-    thread_destroy_event(virge->fifo_not_full_event);
-
     svga_close(&virge->svga);
 
     ddc_close(virge->ddc);
@@ -11,7 +11,16 @@
  *		This is intended to be used by another VGA/SVGA driver,
  *		and not as a card in it's own right.
  *
- * Version:	@(#)vid_svga.c	1.0.30	2021/02/11
+ *		For the packed pixel modes, scanlines can be rendered by a
+ *		small pool of worker threads. The poll routine then only
+ *		records the start address and the other per-line state
+ *		for each line, and the workers render the lines into the
+ *		screen buffer in parallel, each using its own copy of the
+ *		rest of the state. Anything that changes that state, such
+ *		as a palette write or a mode change, first waits for all
+ *		queued lines to be done, as does the end of the frame.
+ *
+ * Version:	@(#)vid_svga.c	1.0.38	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -52,11 +61,77 @@
 #include "../../mem.h"
 #include "../../rom.h"
 #include "../../timer.h"
+#include "../../plat.h"
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
 #include "../system/clk.h"
 #include "video.h"
 #include "vid_svga.h"
 #include "vid_svga_render.h"
+#include "vid_text.h"
+
+
+
+#define SVGA_RT_THREADS	2		/* scanline render workers */
+#define SVGA_RT_LINES	2048		/* must be a power of 2 */
+#define SVGA_RT_SPIN	4096
+
+
+/* Make the sleeping flags and the line indexes visible in order. */
+#ifdef _MSC_VER
+# define RT_FENCE()	_mm_mfence()
+# define RT_BARRIER()	_ReadWriteBarrier()
+#else
+# define RT_FENCE()	__sync_synchronize()
+# define RT_BARRIER()	__asm__ __volatile__("" ::: "memory")
+#endif
+
+
+/* The state latched for a queued scanline. */
+typedef struct {
+    void	(*render)(svga_t *svga);
+    uint32_t	ma;
+    int		displine,
+		scrollcache,
+		fullchange;
+} svga_line_t;
+
+struct svga_rt;
+
+typedef struct {
+    struct svga_rt *rt;
+    svga_t	*copy;			/* private copy of the state */
+    uint32_t	gen;
 
+    volatile uint32_t pos;		/* next line this worker renders */
+    volatile int sleeping;
+
+    int		first, last;		/* lines drawn since the last sync */
+
+    thread_t	*thread;
+    event_t	*wake;
+} svga_rtw_t;
+
+typedef struct svga_rt {
+    svga_t	*svga;
+
+    svga_line_t	line[SVGA_RT_LINES];
+    volatile uint32_t head;		/* next line to queue */
+    volatile uint32_t gen;		/* bumped when the state changed */
+
+    volatile int waiting,
+		stop;
+    event_t	*done;
+
+    void	(*checked)(svga_t *svga);
+    int		safe;
+
+    svga_rtw_t	w[SVGA_RT_THREADS];
+} svga_rt_t;
+
+/* Does a worker have lines left to render? */
+#define RT_PENDING(rt, w)	((int32_t)((rt)->head - (w)->pos) > 0)
 
 
 extern int	cyc_total;
@@ -86,6 +161,103 @@ svga_set_override(svga_t *svga, int val)
     svga->override = val;
 }
 
+
+/*
+ * Check if the linear framebuffer can be mapped directly.
+ *
+ * In packed-pixel modes with write mode 0, no rotation or
+ * logical operation, no bit masking and all planes enabled,
+ * a CPU write to the LFB is a plain write to VRAM, so its
+ * pages can go into the CPU's write lookup tables. When that stops
+ * being true, any pages mapped so far have to go.
+ */
+static void
+svga_lfb_update(svga_t *svga)
+{
+    int direct;
+
+    direct = svga->fast && (svga->writemode == 0) &&
+	     !(svga->gdcreg[3] & 0x07) && (svga->writemask == 0x0f) &&
+	     (svga->gdcreg[6] & 1) && !(svga->adv_flags & FLAG_ADDR_BY8);
+
+    if (svga->lfb_direct && !direct)
+	flushmmucache_nopc();
+
+    svga->lfb_direct = direct;
+}
+
+
+/*
+ * Map the LFB page for this write into the lookup tables.
+ *
+ * Writes then go through the page's own handlers, which keep
+ * its dirty mask for svga_lfb_dirty(). Reads are not mapped,
+ * as every read has to load the latches, which a later write
+ * mode 1 or logical operation will use. This is only done for
+ * CPU accesses that came in through our own handlers, not for
+ * cards that wrap them.
+ */
+static void
+svga_lfb_map(svga_t *svga, uint32_t addr)
+{
+    uint32_t virt = mem_logical_addr;
+    uint32_t phys = virt;
+    mem_map_t *map;
+
+    map = mem_map_get(addr, 1);
+    if ((map == NULL) || (map->p != svga) ||
+	(map->write_b != svga_write_linear)) return;
+
+    /* Make sure this is the page the CPU is accessing. */
+    if (cr0 >> 31)
+	phys = mmutranslate_noabrt(virt, 1);
+    if ((phys == 0xffffffff) || (((phys & rammask) ^ addr) & ~0xfff))
+	return;
+
+    addr &= svga->decode_mask;
+    if (addr >= svga->vram_max)
+	return;
+    addr &= svga->vram_mask;
+    if ((int)(addr >> 12) >= svga->lfb_npages)
+	return;
+
+    addwritelookup_page(virt, &svga->lfb_pages[addr >> 12]);
+}
+
+
+/*
+ * Collect the writes made through directly-mapped LFB pages.
+ *
+ * Each dirty mask bit covers 16 bytes, so we mark the page as
+ * changed for the renderer, and charge the access time for the
+ * writes in one go, as four dword writes per dirty block.
+ */
+static void
+svga_lfb_dirty(svga_t *svga)
+{
+    page_t *p;
+    uint64_t mask;
+    int blocks = 0;
+    int x, i;
+
+    for (x = 0; x < svga->lfb_npages; x++) {
+	p = &svga->lfb_pages[x];
+	if (!(p->dirty_mask[0] | p->dirty_mask[1] |
+	      p->dirty_mask[2] | p->dirty_mask[3])) continue;
+
+	for (i = 0; i < 4; i++) {
+		for (mask = p->dirty_mask[i]; mask; mask &= (mask - 1))
+			blocks++;
+		p->dirty_mask[i] = 0;
+	}
+
+	svga->changedvram[x] = changeframecount;
+    }
+
+    if (blocks > 0)
+	cycles -= blocks * 4 * video_timing_write_l;
+}
+
 void
 svga_out(uint16_t addr, uint8_t val, priv_t priv)
 {
@@ -174,6 +346,7 @@ svga_out(uint16_t addr, uint8_t val, priv_t priv)
 
 			case 2:
 				svga->writemask = val & 0xf; 
+				svga_lfb_update(svga);
 				break;
 
 			case 3:
@@ -190,6 +363,7 @@ svga_out(uint16_t addr, uint8_t val, priv_t priv)
 				svga->chain4 = val & 8;
 				svga->fast = (svga->gdcreg[8] == 0xff && !(svga->gdcreg[3] & 0x18) &&
 					      !svga->gdcreg[1]) && svga->chain4 && !(svga->adv_flags & FLAG_ADDR_BY8);
+				svga_lfb_update(svga);
 				break;
 		}
 		break;
@@ -219,6 +393,7 @@ svga_out(uint16_t addr, uint8_t val, priv_t priv)
 				break;
 
             case 2:
+				svga_render_sync(svga);
 				indx = svga->dac_addr & 255;
 				svga->vgapal[indx].r = svga->dac_r;
 				svga->vgapal[indx].g = svga->dac_g;
@@ -287,6 +462,7 @@ svga_out(uint16_t addr, uint8_t val, priv_t priv)
 		svga->gdcreg[svga->gdcaddr & 15] = val;                
 		svga->fast = (svga->gdcreg[8] == 0xff && !(svga->gdcreg[3] & 0x18) &&
 			     !svga->gdcreg[1]) && svga->chain4;
+		svga_lfb_update(svga);
 		if (((svga->gdcaddr & 15) == 5  && (val ^ o) & 0x70) ||
 		    ((svga->gdcaddr & 15) == 6 && (val ^ o) & 1))
 			svga_recalctimings(svga);
@@ -416,6 +592,8 @@ svga_set_ramdac_type(svga_t *svga, int type)
     int c;
 
     if (svga->ramdac_type != type) {
+	svga_render_sync(svga);
+
 	svga->ramdac_type = type;
 
 	for (c = 0; c < 256; c++) {
@@ -435,6 +613,9 @@ svga_recalctimings(svga_t *svga)
 {
     double crtcconst, _dispontime, _dispofftime, disptime;
 
+    svga_render_sync(svga);
+    text_cache_flush((text_cache_t *)svga->text);
+
     svga->vtotal = svga->crtc[6];
     svga->dispend = svga->crtc[0x12];
     svga->vsyncstart = svga->crtc[0x10];
@@ -589,6 +770,294 @@ svga_recalctimings(svga_t *svga)
 }
 
 
+/*
+ * The renderers that only use the per-line state, the palette and
+ * the video memory, and can therefore run on a worker.
+ */
+static void (*const svga_rt_safe[])(svga_t *svga) = {
+    svga_render_8bpp_lowres,		svga_render_8bpp_highres,
+    svga_render_8bpp_gs_lowres,		svga_render_8bpp_gs_highres,
+    svga_render_8bpp_rgb_lowres,	svga_render_8bpp_rgb_highres,
+    svga_render_15bpp_lowres,		svga_render_15bpp_highres,
+    svga_render_mixed_lowres,		svga_render_mixed_highres,
+    svga_render_16bpp_lowres,		svga_render_16bpp_highres,
+    svga_render_24bpp_lowres,		svga_render_24bpp_highres,
+    svga_render_32bpp_lowres,		svga_render_32bpp_highres,
+    svga_render_ABGR8888_highres,	svga_render_RGBA8888_highres,
+    NULL
+};
+
+
+static void
+svga_rt_thread(void *param)
+{
+    svga_rtw_t *w = (svga_rtw_t *)param;
+    svga_rt_t *rt = w->rt;
+    svga_line_t *ln;
+    svga_t *svga = w->copy;
+    int spin;
+
+    while (! rt->stop) {
+	for (spin = 0; !RT_PENDING(rt, w) && spin < SVGA_RT_SPIN; spin++)
+		;
+
+	if (! RT_PENDING(rt, w)) {
+		w->sleeping = 1;
+		RT_FENCE();
+		if (!RT_PENDING(rt, w) && !rt->stop)
+			thread_wait_event(w->wake, -1);
+		w->sleeping = 0;
+		continue;
+	}
+
+	/* The shared state only changes while no lines are queued. */
+	if (w->gen != rt->gen) {
+		memcpy(svga, rt->svga, sizeof(svga_t));
+		w->gen = rt->gen;
+	}
+
+	ln = &rt->line[w->pos & (SVGA_RT_LINES - 1)];
+	svga->ma = ln->ma;
+	svga->displine = ln->displine;
+	svga->scrollcache = ln->scrollcache;
+	svga->fullchange = ln->fullchange;
+	svga->firstline_draw = 2000;
+	svga->lastline_draw = 0;
+
+	ln->render(svga);
+
+	if (svga->firstline_draw != 2000) {
+		if (svga->firstline_draw < w->first)
+			w->first = svga->firstline_draw;
+		if (svga->lastline_draw > w->last)
+			w->last = svga->lastline_draw;
+	}
+
+	/* Every worker takes every SVGA_RT_THREADS'th line. */
+	RT_BARRIER();
+	w->pos += SVGA_RT_THREADS;
+
+	if (rt->waiting)
+		thread_set_event(rt->done);
+    }
+}
+
+
+/* Check if all workers are past the last queued line. */
+static int
+svga_rt_idle(svga_rt_t *rt)
+{
+    int i;
+
+    for (i = 0; i < SVGA_RT_THREADS; i++) {
+	if (RT_PENDING(rt, &rt->w[i]))
+		return(0);
+    }
+
+    return(1);
+}
+
+
+/*
+ * Wait until all queued lines have been rendered, and add the lines
+ * the workers drew to the ones that will be blitted.
+ */
+void
+svga_render_sync(svga_t *svga)
+{
+    svga_rt_t *rt = (svga_rt_t *)svga->rt;
+    svga_rtw_t *w;
+    int i;
+
+    if (rt == NULL) return;
+
+    while (! svga_rt_idle(rt)) {
+	rt->waiting = 1;
+	RT_FENCE();
+	for (i = 0; i < SVGA_RT_THREADS; i++) {
+		if (rt->w[i].sleeping)
+			thread_set_event(rt->w[i].wake);
+	}
+	if (! svga_rt_idle(rt))
+		thread_wait_event(rt->done, 1);
+	rt->waiting = 0;
+    }
+
+    for (i = 0; i < SVGA_RT_THREADS; i++) {
+	w = &rt->w[i];
+	if (w->first != 2000) {
+		if (w->first < svga->firstline_draw)
+			svga->firstline_draw = w->first;
+		if (w->last > svga->lastline_draw)
+			svga->lastline_draw = w->last;
+		w->first = 2000;
+		w->last = 0;
+	}
+    }
+
+    rt->gen++;
+}
+
+
+/* Queue the current line for the workers, if its renderer allows it. */
+static int
+svga_rt_queue(svga_t *svga)
+{
+    svga_rt_t *rt = (svga_rt_t *)svga->rt;
+    svga_line_t *ln;
+    int i;
+
+    if (rt->checked != svga->render) {
+	rt->checked = svga->render;
+	rt->safe = 0;
+	for (i = 0; svga_rt_safe[i] != NULL; i++) {
+		if (svga_rt_safe[i] == svga->render)
+			rt->safe = 1;
+	}
+    }
+    if (! rt->safe) return(0);
+
+    /* Should not happen, as we sync at the end of every frame. */
+    for (i = 0; i < SVGA_RT_THREADS; i++) {
+	if ((int32_t)(rt->head - rt->w[i].pos) >= (SVGA_RT_LINES - SVGA_RT_THREADS)) {
+		svga_render_sync(svga);
+		break;
+	}
+    }
+
+    ln = &rt->line[rt->head & (SVGA_RT_LINES - 1)];
+    ln->render = svga->render;
+    ln->ma = svga->ma;
+    ln->displine = svga->displine;
+    ln->scrollcache = svga->scrollcache;
+    ln->fullchange = svga->fullchange;
+
+    RT_BARRIER();
+    rt->head++;
+
+    RT_FENCE();
+    for (i = 0; i < SVGA_RT_THREADS; i++) {
+	if (rt->w[i].sleeping)
+		thread_set_event(rt->w[i].wake);
+    }
+
+    return(1);
+}
+
+
+static void
+svga_rt_init(svga_t *svga)
+{
+    svga_rt_t *rt;
+    int i;
+
+    rt = (svga_rt_t *)mem_alloc(sizeof(svga_rt_t));
+    memset(rt, 0x00, sizeof(svga_rt_t));
+    rt->svga = svga;
+    rt->gen = 1;
+    rt->done = thread_create_event();
+
+    for (i = 0; i < SVGA_RT_THREADS; i++) {
+	rt->w[i].rt = rt;
+	rt->w[i].copy = (svga_t *)mem_alloc(sizeof(svga_t));
+	rt->w[i].pos = i;
+	rt->w[i].first = 2000;
+	rt->w[i].wake = thread_create_event();
+	rt->w[i].thread = thread_create(svga_rt_thread, &rt->w[i]);
+    }
+
+    svga->rt = rt;
+}
+
+
+static void
+svga_rt_close(svga_t *svga)
+{
+    svga_rt_t *rt = (svga_rt_t *)svga->rt;
+    int i;
+
+    if (rt == NULL) return;
+
+    svga_render_sync(svga);
+    svga->rt = NULL;
+
+    rt->stop = 1;
+    for (i = 0; i < SVGA_RT_THREADS; i++) {
+	thread_set_event(rt->w[i].wake);
+	(void)thread_wait(rt->w[i].thread, -1);
+	thread_destroy_event(rt->w[i].wake);
+	free(rt->w[i].copy);
+    }
+    thread_destroy_event(rt->done);
+
+    free(rt);
+}
+
+
+/* Names of the common renderers, for the statistics. */
+static const struct {
+    void	(*render)(svga_t *svga);
+    const char	*name;
+} svga_render_names[] = {
+    { svga_render_null,			"null"		},
+    { svga_render_blank,		"blank"		},
+    { svga_render_text_40,		"text_40"	},
+    { svga_render_text_80,		"text_80"	},
+    { svga_render_text_80_ksc5601,	"text_80_ksc5601" },
+    { svga_render_2bpp_lowres,		"2bpp_lowres"	},
+    { svga_render_2bpp_highres,		"2bpp_highres"	},
+    { svga_render_4bpp_lowres,		"4bpp_lowres"	},
+    { svga_render_4bpp_highres,		"4bpp_highres"	},
+    { svga_render_8bpp_lowres,		"8bpp_lowres"	},
+    { svga_render_8bpp_highres,		"8bpp_highres"	},
+    { svga_render_8bpp_gs_lowres,	"8bpp_gs_lowres" },
+    { svga_render_8bpp_gs_highres,	"8bpp_gs_highres" },
+    { svga_render_8bpp_rgb_lowres,	"8bpp_rgb_lowres" },
+    { svga_render_8bpp_rgb_highres,	"8bpp_rgb_highres" },
+    { svga_render_15bpp_lowres,		"15bpp_lowres"	},
+    { svga_render_15bpp_highres,	"15bpp_highres"	},
+    { svga_render_mixed_lowres,		"mixed_lowres"	},
+    { svga_render_mixed_highres,	"mixed_highres"	},
+    { svga_render_16bpp_lowres,		"16bpp_lowres"	},
+    { svga_render_16bpp_highres,	"16bpp_highres"	},
+    { svga_render_24bpp_lowres,		"24bpp_lowres"	},
+    { svga_render_24bpp_highres,	"24bpp_highres"	},
+    { svga_render_32bpp_lowres,		"32bpp_lowres"	},
+    { svga_render_32bpp_highres,	"32bpp_highres"	},
+    { svga_render_ABGR8888_highres,	"ABGR8888_highres" },
+    { svga_render_RGBA8888_highres,	"RGBA8888_highres" },
+    { NULL,				NULL		}
+};
+
+
+/*
+ * Render a line and account for the time it took.
+ *
+ * Used instead of the render workers when collecting statistics, so
+ * the numbers are for one renderer on one thread.
+ */
+static void
+svga_render_timed(svga_t *svga)
+{
+    const char *name = "other";
+    uint64_t start;
+    int i;
+
+    start = plat_timer_read();
+    svga->render(svga);
+    start = plat_timer_read() - start;
+
+    for (i = 0; svga_render_names[i].render != NULL; i++) {
+	if (svga_render_names[i].render == svga->render) {
+		name = svga_render_names[i].name;
+		break;
+	}
+    }
+
+    video_stats_add_local(VSTAT_RENDER, "svga", name, 1, start);
+}
+
+
 void
 svga_poll(priv_t priv)
 {
@@ -654,8 +1123,24 @@ svga_poll(priv_t priv)
 							    svga->interlace ? 3 : 2;
 		}
 
-		if (!svga->override)
-			svga->render(svga);
+		/* Lines with a cursor or overlay are drawn here, in order. */
+		if (svga->override) {
+			text_cache_flush((text_cache_t *)svga->text);
+		} else if (! video_draw) {
+			/*
+			 * Not shown, so draw all of the next one that is. The
+			 * cursor and overlay still run, as they step the card's
+			 * own state along.
+			 */
+			svga->fullchange = changeframecount;
+		} else {
+			if (video_stats_on)
+				svga_render_timed(svga);
+			else if (svga->rt == NULL ||
+			    svga->hwcursor_on || svga->dac_hwcursor_on ||
+			    svga->overlay_on || !svga_rt_queue(svga))
+				svga->render(svga);
+		}
 
 		if (svga->overlay_on) {
 			if (!svga->override)
@@ -747,6 +1232,9 @@ svga_poll(priv_t priv)
 		else
 			svga->cursoron = svga->blink & 16;
 
+		/* All lines of this frame must be done before we age the changes. */
+		svga_render_sync(svga);
+
 		if (!(svga->gdcreg[6] & 1) && !(svga->blink & 15)) 
 			svga->fullchange = 2;
 		svga->blink++;
@@ -755,6 +1243,7 @@ svga_poll(priv_t priv)
 			if (svga->changedvram[x]) 
 				svga->changedvram[x]--;
 		}
+		svga_lfb_dirty(svga);
 		if (svga->fullchange) 
 			svga->fullchange--;
 	}
@@ -771,6 +1260,8 @@ svga_poll(priv_t priv)
 		wx = x;
 		wy = svga->lastline - svga->firstline;
 
+		svga_render_sync(svga);
+
 		if (!svga->override && (wx > 0) && (wy > 0))
 			svga_doblit(svga->firstline_draw, svga->lastline_draw + 1, wx, wy, svga);
 
@@ -873,6 +1364,17 @@ svga_init(svga_t *svga, priv_t priv, int vramsize,
     svga->vram_display_mask = svga->vram_mask = vramsize - 1;
     svga->decode_mask = 0x7fffff;
     svga->changedvram = (uint8_t *)mem_alloc(vramsize >> 12);
+
+    /* Pages for mapping the linear framebuffer directly. */
+    svga->lfb_npages = vramsize >> 12;
+    svga->lfb_pages = (page_t *)mem_alloc(svga->lfb_npages * sizeof(page_t));
+    memset(svga->lfb_pages, 0x00, svga->lfb_npages * sizeof(page_t));
+    for (c = 0; c < svga->lfb_npages; c++) {
+	svga->lfb_pages[c].write_b = mem_write_ramb_page;
+	svga->lfb_pages[c].write_w = mem_write_ramw_page;
+	svga->lfb_pages[c].write_l = mem_write_raml_page;
+	svga->lfb_pages[c].mem = &svga->vram[c << 12];
+    }
     svga->recalctimings_ex = recalctimings_ex;
     svga->video_in  = video_in;
     svga->video_out = video_out;
@@ -894,6 +1396,12 @@ svga_init(svga_t *svga, priv_t priv, int vramsize,
     svga->ramdac_type = RAMDAC_6BIT;
 
     svga->map8 = svga->pallook;
+
+    svga->text = text_cache_init();
+
+    if (SVGA_RT_THREADS > 0)
+	svga_rt_init(svga);
+
     return 0;
 }
 
@@ -901,6 +1409,10 @@ svga_init(svga_t *svga, priv_t priv, int vramsize,
 void
 svga_close(svga_t *svga)
 {
+    svga_rt_close(svga);
+    text_cache_close((text_cache_t *)svga->text);
+
+    free(svga->lfb_pages);
     free(svga->changedvram);
     free(svga->vram);
 
@@ -1227,6 +1739,11 @@ svga_write(uint32_t addr, uint8_t val, priv_t priv)
 void
 svga_write_linear(uint32_t addr, uint8_t val, priv_t priv)
 {
+    svga_t *svga = (svga_t *)priv;
+
+    if (svga->lfb_direct)
+	svga_lfb_map(svga, addr);
+
     svga_write_common(addr, val, 1, priv);
 }
 
@@ -1371,6 +1888,11 @@ svga_writew(uint32_t addr, uint16_t val, priv_t priv)
 void
 svga_writew_linear(uint32_t addr, uint16_t val, priv_t priv)
 {
+    svga_t *svga = (svga_t *)priv;
+
+    if (svga->lfb_direct)
+	svga_lfb_map(svga, addr);
+
     svga_writew_common(addr, val, 1, priv);
 }
 
@@ -1417,6 +1939,11 @@ svga_writel(uint32_t addr, uint32_t val, priv_t priv)
 void
 svga_writel_linear(uint32_t addr, uint32_t val, priv_t priv)
 {
+    svga_t *svga = (svga_t *)priv;
+
+    if (svga->lfb_direct)
+	svga_lfb_map(svga, addr);
+
     svga_writel_common(addr, val, 1, priv);
 }
 
@@ -8,7 +8,7 @@
  *
  *		Definitions for the generic SVGA driver.
  *
- * Version:	@(#)vid_svga.h	1.0.12	2021/02/03
+ * Version:	@(#)vid_svga.h	1.0.15	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -145,6 +145,17 @@ typedef struct svga_t
 
     priv_t	ramdac,
 		clock_gen;
+
+    /* Linear framebuffer pages mapped directly for the CPU. */
+    page_t	*lfb_pages;
+    int		lfb_npages,
+		lfb_direct;
+
+    /* Scanline render workers, if any. */
+    priv_t	rt;
+
+    /* What the text renderers last drew. */
+    priv_t	text;
 } svga_t;
 
 
@@ -155,6 +166,7 @@ extern int	svga_init(svga_t *svga, priv_t, int memsize,
 			  void (*hwcursor_draw)(struct svga_t *svga, int displine),
 			  void (*overlay_draw)(struct svga_t *svga, int displine));
 extern void	svga_recalctimings(svga_t *svga);
+extern void	svga_render_sync(svga_t *svga);
 extern void	svga_close(svga_t *svga);
 uint8_t		svga_read(uint32_t addr, priv_t);
 uint16_t	svga_readw(uint32_t addr, priv_t);
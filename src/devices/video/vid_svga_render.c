@@ -8,7 +8,7 @@
  *
  *		SVGA renderers.
  *
- * Version:	@(#)vid_svga_render.c	1.0.19	2020/11/16
+ * Version:	@(#)vid_svga_render.c	1.0.20	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -46,6 +46,7 @@
 #include "video.h"
 #include "vid_svga.h"
 #include "vid_svga_render.h"
+#include "vid_text.h"
 
 void 
 svga_render_null(svga_t *svga)
@@ -90,61 +91,126 @@ svga_render_blank(svga_t *svga)
 }
 
 
+/*
+ * Get the cell cache for the current line, or NULL if the whole line
+ * has to be drawn. The line key covers everything that applies to all
+ * cells, the cell keys what goes into each one.
+ */
+static uint32_t *
+text_line(svga_t *svga, int xinc, int x_add, int y_add)
+{
+    text_cache_t *tc = (text_cache_t *)svga->text;
+    uint32_t st[16 + 6];
+    int c;
+
+    /* Cursors and overlays are drawn over the text. */
+    if (svga->hwcursor_on || svga->dac_hwcursor_on || svga->overlay_on) {
+	text_cache_drop(tc, svga->displine + y_add);
+	return(NULL);
+    }
+
+    for (c = 0; c < 16; c++)
+	st[c] = svga->pallook[svga->egapal[c]];
+    st[16] = svga->ma;
+    st[17] = svga->sc;
+    st[18] = xinc;
+    st[19] = x_add;
+    st[20] = svga->hdisp;
+    st[21] = svga->attrregs[0x10] & 0x0c;
+
+    return(text_cache_line(tc, svga->displine + y_add,
+			   text_hash(TEXT_HASH_INIT, st, 16 + 6),
+			   (svga->hdisp + xinc - 1) / xinc));
+}
+
+
+/* Draw (if needed) one character cell of a text line. */
+static __inline void
+text_cell(svga_t *svga, pel_t *p, uint32_t *cells, int c, int wide)
+{
+    int drawcursor = ((svga->ma == svga->ca) && svga->con && svga->cursoron);
+    uint8_t chr, attr, dat;
+    uint32_t charaddr, key;
+    uint32_t fg, bg;
+    int blink;
+
+    chr  = svga->vram[(svga->ma << 1) & svga->vram_display_mask];
+    attr = svga->vram[((svga->ma << 1) + 1) & svga->vram_display_mask];
+
+    if (attr & 8)
+	charaddr = svga->charsetb + (chr * 128);
+    else
+	charaddr = svga->charseta + (chr * 128);
+    dat = svga->vram[charaddr + (svga->sc << 2)];
+
+    blink = (attr & 0x80) && (svga->attrregs[0x10] & 8);
+
+    if (cells != NULL) {
+	key = chr | (attr << 8) | (dat << 16);
+	if (drawcursor)
+		key |= TEXT_CELL_CURSOR;
+	if (blink && (svga->blink & 16))
+		key |= TEXT_CELL_BLINK;
+	if (cells[c] == key)
+		return;
+	cells[c] = key;
+    }
+
+    if (drawcursor) {
+	bg = svga->pallook[svga->egapal[attr & 15]];
+	fg = svga->pallook[svga->egapal[attr >> 4]];
+    } else {
+	fg = svga->pallook[svga->egapal[attr & 15]];
+	bg = svga->pallook[svga->egapal[attr >> 4]];
+	if (blink) {
+		bg = svga->pallook[svga->egapal[(attr >> 4) & 7]];
+		if (svga->blink & 16)
+			fg = bg;
+	}
+    }
+
+    if (wide) {
+	text_put16(p, dat, fg, bg);
+	if (! (svga->seqregs[1] & 1)) {
+		if ((chr & ~0x1F) != 0xC0 || !(svga->attrregs[0x10] & 4))
+			p[16].val = p[17].val = bg;
+		else
+			p[16].val = p[17].val = (dat & 1) ? fg : bg;
+	}
+    } else {
+	text_put8(p, dat, fg, bg);
+	if (! (svga->seqregs[1] & 1)) {
+		if ((chr & ~0x1F) != 0xC0 || !(svga->attrregs[0x10] & 4))
+			p[8].val = bg;
+		else
+			p[8].val = (dat & 1) ? fg : bg;
+	}
+    }
+}
+
+
 void
 svga_render_text_40(svga_t *svga)
-{     
+{
     int y_add = enable_overscan ? (overscan_y >> 1) : 0;
     int x_add = enable_overscan ? 8 : 0;
     int xinc = (svga->seqregs[1] & 1) ? 16 : 18;
-    uint8_t chr, attr, dat;
-    uint32_t charaddr;
-    int bg, fg, x, xx;
-    int drawcursor;
+    uint32_t *cells;
+    int c, x;
     pel_t *p;
 
-    if (svga->firstline_draw == 2000) 
+    if (svga->firstline_draw == 2000)
 	svga->firstline_draw = svga->displine;
     svga->lastline_draw = svga->displine;
-	
+
     if (svga->fullchange) {
 	p = &screen->line[svga->displine + y_add][32 + x_add];
+	cells = text_line(svga, xinc, x_add, y_add);
 
-	for (x = 0; x < svga->hdisp; x += xinc) {
-		drawcursor = ((svga->ma == svga->ca) && svga->con && svga->cursoron);
-		chr  = svga->vram[(svga->ma << 1) & svga->vram_display_mask];
-		attr = svga->vram[((svga->ma << 1) + 1) & svga->vram_display_mask];
-		if (attr & 8)
-			charaddr = svga->charsetb + (chr * 128);
-		else
-			charaddr = svga->charseta + (chr * 128);
-
-		if (drawcursor) { 
-			bg = svga->pallook[svga->egapal[attr & 15]]; 
-			fg = svga->pallook[svga->egapal[attr >> 4]]; 
-		} else {
-			fg = svga->pallook[svga->egapal[attr & 15]];
-			bg = svga->pallook[svga->egapal[attr >> 4]];
-			if (attr & 0x80 && svga->attrregs[0x10] & 8) {
-				bg = svga->pallook[svga->egapal[(attr >> 4) & 7]];
-				if (svga->blink & 16) 
-					fg = bg;
-			}
-		}
+	for (x = 0, c = 0; x < svga->hdisp; x += xinc, c++) {
+		text_cell(svga, p, cells, c, 1);
 
-		dat = svga->vram[charaddr + (svga->sc << 2)];
-		if (svga->seqregs[1] & 1) { 
-			for (xx = 0; xx < 16; xx += 2) 
-				p[xx].val = p[xx + 1].val = (dat & (0x80 >> (xx >> 1))) ? fg : bg;
-		} else {
-			for (xx = 0; xx < 16; xx += 2)
-				p[xx].val = p[xx + 1].val = (dat & (0x80 >> (xx >> 1))) ? fg : bg;
-			if ((chr & ~0x1F) != 0xC0 || !(svga->attrregs[0x10] & 4))
-				p[16].val = p[17].val = bg;
-			else		  
-				p[16].val = p[17].val = (dat & 1) ? fg : bg;
-		}
-
-		svga->ma += 4; 
+		svga->ma += 4;
 		p += xinc;
 	}
 
@@ -159,57 +225,22 @@ svga_render_text_80(svga_t *svga)
     int y_add = enable_overscan ? (overscan_y >> 1) : 0;
     int x_add = enable_overscan ? 8 : 0;
     int xinc = (svga->seqregs[1] & 1) ? 8 : 9;
-    uint8_t chr, attr, dat;
-    uint32_t charaddr;
-    int bg, fg, x, xx;
-    int drawcursor;
+    uint32_t *cells;
+    int c, x;
     pel_t *p;
 
-    if (svga->firstline_draw == 2000) 
+    if (svga->firstline_draw == 2000)
 	svga->firstline_draw = svga->displine;
     svga->lastline_draw = svga->displine;
-	
+
     if (svga->fullchange) {
 	p = &screen->line[svga->displine + y_add][32 + x_add];
+	cells = text_line(svga, xinc, x_add, y_add);
 
-	for (x = 0; x < svga->hdisp; x += xinc) {
-		drawcursor = ((svga->ma == svga->ca) && svga->con && svga->cursoron);
-		chr  = svga->vram[(svga->ma << 1) & svga->vram_display_mask];
-		attr = svga->vram[((svga->ma << 1) + 1) & svga->vram_display_mask];
-
-		if (attr & 8)
-			charaddr = svga->charsetb + (chr * 128);
-		else
-			charaddr = svga->charseta + (chr * 128);
-
-		if (drawcursor) { 
-			bg = svga->pallook[svga->egapal[attr & 15]]; 
-			fg = svga->pallook[svga->egapal[attr >> 4]]; 
-		} else {
-			fg = svga->pallook[svga->egapal[attr & 15]];
-			bg = svga->pallook[svga->egapal[attr >> 4]];
-
-			if (attr & 0x80 && svga->attrregs[0x10] & 8) {
-				bg = svga->pallook[svga->egapal[(attr >> 4) & 7]];
-				if (svga->blink & 16) 
-					fg = bg;
-			}
-		}
-
-		dat = svga->vram[charaddr + (svga->sc << 2)];
-		if (svga->seqregs[1] & 1) { 
-			for (xx = 0; xx < 8; xx++) 
-				p[xx].val = (dat & (0x80 >> xx)) ? fg : bg;
-		} else {
-			for (xx = 0; xx < 8; xx++) 
-				p[xx].val = (dat & (0x80 >> xx)) ? fg : bg;
-			if ((chr & ~0x1F) != 0xC0 || !(svga->attrregs[0x10] & 4)) 
-				p[8].val = bg;
-			else		  
-				p[8].val = (dat & 1) ? fg : bg;
-		}
+	for (x = 0, c = 0; x < svga->hdisp; x += xinc, c++) {
+		text_cell(svga, p, cells, c, 0);
 
-		svga->ma += 4; 
+		svga->ma += 4;
 		p += xinc;
 	}
 
@@ -0,0 +1,186 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Common text mode renderer.
+ *
+ *		The text renderers draw every character cell of a line
+ *		one pixel at a time, testing a font bit for each. Here we
+ *		expand a font byte through a table of pixel masks, so a
+ *		row of a cell becomes a few branch-free stores that the
+ *		compiler can vectorize.
+ *
+ *		On top of that, a renderer can keep a cache of what it drew
+ *		on each line, and skip all cells that would come out the
+ *		same as last time. This only works for screens that hold
+ *		final colors; the palette-indexed screens are converted in
+ *		place by the blitter, so they must be drawn in full.
+ *
+ * Version:	@(#)vid_text.c	1.0.2	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "../../emu.h"
+#include "video.h"
+#include "vid_text.h"
+
+
+uint32_t	text_mask[256][8];
+
+
+void
+text_init(void)
+{
+    static int inited = 0;
+    int c, x;
+
+    if (inited) return;
+
+    for (c = 0; c < 256; c++)
+	for (x = 0; x < 8; x++)
+		text_mask[c][x] = (c & (0x80 >> x)) ? 0xffffffff : 0x00000000;
+
+    inited = 1;
+}
+
+
+/* Fold a number of words into a (FNV-1a style) line key. */
+uint64_t
+text_hash(uint64_t h, const uint32_t *w, int n)
+{
+    while (n--) {
+	h ^= *w++;
+	h *= 0x00000100000001b3ULL;
+    }
+
+    return(h);
+}
+
+
+text_cache_t *
+text_cache_init(void)
+{
+    text_cache_t *tc;
+
+    text_init();
+
+    tc = (text_cache_t *)mem_alloc(sizeof(text_cache_t));
+    memset(tc, 0x00, sizeof(text_cache_t));
+
+    return(tc);
+}
+
+
+void
+text_cache_close(text_cache_t *tc)
+{
+    int i;
+
+    if (tc == NULL) return;
+
+    for (i = 0; i < TEXT_MAX_LINES; i++) {
+	if (tc->cells[i] != NULL)
+		free(tc->cells[i]);
+    }
+
+    free(tc);
+}
+
+
+/* Forget everything, because something else drew on the screen. */
+void
+text_cache_flush(text_cache_t *tc)
+{
+    if (tc != NULL)
+	tc->gen++;
+}
+
+
+/*
+ * Get the cell keys for a line, or NULL if the line must be drawn
+ * in full. If the line key changed, all cells are marked invalid.
+ */
+uint32_t *
+text_cache_line(text_cache_t *tc, int line, uint64_t key, int cells)
+{
+    uint32_t *cp;
+    int i;
+
+    if (tc == NULL || line < 0 || line >= TEXT_MAX_LINES ||
+	cells > TEXT_MAX_CELLS) return(NULL);
+
+    key = text_hash(key, &tc->gen, 1);
+
+    cp = tc->cells[line];
+    if (cp == NULL) {
+	cp = (uint32_t *)mem_alloc(TEXT_MAX_CELLS * sizeof(uint32_t));
+	tc->cells[line] = cp;
+	tc->key[line] = ~key;
+    }
+
+    if (tc->key[line] != key) {
+	for (i = 0; i < TEXT_MAX_CELLS; i++)
+		cp[i] = TEXT_CELL_INVALID;
+	tc->key[line] = key;
+    }
+
+    return(cp);
+}
+
+
+/* Mark a line as unknown, after drawing it in full. */
+void
+text_cache_drop(text_cache_t *tc, int line)
+{
+    uint32_t *cp;
+    int i;
+
+    if (tc == NULL || line < 0 || line >= TEXT_MAX_LINES) return;
+
+    cp = tc->cells[line];
+    if (cp == NULL) return;
+
+    for (i = 0; i < TEXT_MAX_CELLS; i++)
+	cp[i] = TEXT_CELL_INVALID;
+}
@@ -0,0 +1,152 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Definitions for the common text mode renderer.
+ *
+ * Version:	@(#)vid_text.h	1.0.2	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef VIDEO_TEXT_H
+# define VIDEO_TEXT_H
+
+
+#define TEXT_MAX_LINES	2048			/* lines in the screen buffer */
+#define TEXT_MAX_CELLS	256			/* cells per line we cache */
+
+/* A cell key is chr | (attr << 8) | (dat << 16), plus these. */
+#define TEXT_CELL_CURSOR	0x01000000
+#define TEXT_CELL_BLINK		0x02000000
+#define TEXT_CELL_INVALID	0xffffffff
+
+#define TEXT_HASH_INIT	0xcbf29ce484222325ULL
+
+
+/*
+ * What we last drew on each line of the screen buffer.
+ *
+ * Each line has a key for the state that applies to all of its cells
+ * (start address, scanline, palette and so on), and a key per cell for
+ * the character, attribute and font data that went into it. A cell is
+ * only drawn again if either of them changed.
+ */
+typedef struct {
+    uint32_t	gen;				/* bumped on flush */
+    uint64_t	key[TEXT_MAX_LINES];
+    uint32_t	*cells[TEXT_MAX_LINES];
+} text_cache_t;
+
+
+/* Pixel masks for each bit pattern of a font byte, MSB first. */
+extern uint32_t	text_mask[256][8];
+
+
+/* Draw one row of a character, 8 pixels wide. */
+static __inline void
+text_put8(pel_t *p, uint8_t dat, uint32_t fg, uint32_t bg)
+{
+    const uint32_t *m = text_mask[dat];
+    uint32_t x = fg ^ bg;
+    int i;
+
+    for (i = 0; i < 8; i++)
+	p[i].val = bg ^ (m[i] & x);
+}
+
+
+/* Draw one row of a character, with every pixel doubled. */
+static __inline void
+text_put16(pel_t *p, uint8_t dat, uint32_t fg, uint32_t bg)
+{
+    const uint32_t *m = text_mask[dat];
+    uint32_t x = fg ^ bg;
+    int i;
+
+    for (i = 0; i < 8; i++)
+	p[i << 1].val = p[(i << 1) + 1].val = bg ^ (m[i] & x);
+}
+
+
+/* Same, for screens that hold palette indices. */
+static __inline void
+text_put8_pal(pel_t *p, uint8_t dat, uint8_t fg, uint8_t bg)
+{
+    const uint32_t *m = text_mask[dat];
+    uint8_t x = fg ^ bg;
+    int i;
+
+    for (i = 0; i < 8; i++)
+	p[i].pal = bg ^ (m[i] & x);
+}
+
+
+static __inline void
+text_put16_pal(pel_t *p, uint8_t dat, uint8_t fg, uint8_t bg)
+{
+    const uint32_t *m = text_mask[dat];
+    uint8_t x = fg ^ bg;
+    int i;
+
+    for (i = 0; i < 8; i++)
+	p[i << 1].pal = p[(i << 1) + 1].pal = bg ^ (m[i] & x);
+}
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void		text_init(void);
+
+extern uint64_t		text_hash(uint64_t h, const uint32_t *w, int n);
+
+extern text_cache_t	*text_cache_init(void);
+extern void		text_cache_close(text_cache_t *tc);
+extern void		text_cache_flush(text_cache_t *tc);
+extern uint32_t		*text_cache_line(text_cache_t *tc, int line,
+					 uint64_t key, int cells);
+extern void		text_cache_drop(text_cache_t *tc, int line);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/*VIDEO_TEXT_H*/
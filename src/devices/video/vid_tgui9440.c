@@ -47,7 +47,7 @@
  *		access size or host data has any affect, but the Windows 3.1
  *		driver always reads bytes and write words of 0xffff.
  *
- * Version:	@(#)vid_tgui9440.c	1.0.18	2021/03/12
+ * Version:	@(#)vid_tgui9440.c	1.0.21	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -95,6 +95,8 @@
 #include "vid_ddc.h"
 #include "vid_svga.h"
 #include "vid_svga_render.h"
+#include "vid_blit.h"
+#include "vid_accel_fifo.h"
 #include "vid_tkd8001_ramdac.h"
 
 
@@ -138,13 +140,9 @@
 #define EXT_CTRL_MONO_TRANSPARENT 0x04
 #define EXT_CTRL_LATCH_COPY       0x08
 
-#define FIFO_SIZE 65536
-#define FIFO_MASK (FIFO_SIZE - 1)
-#define FIFO_ENTRY_SIZE (1 << 31)
-
-#define FIFO_ENTRIES (dev->fifo_write_idx - dev->fifo_read_idx)
-#define FIFO_FULL    ((dev->fifo_write_idx - dev->fifo_read_idx) >= FIFO_SIZE)
-#define FIFO_EMPTY   (dev->fifo_read_idx == dev->fifo_write_idx)
+#define FIFO_ENTRIES ACCEL_FIFO_ENTRIES(&dev->fifo)
+#define FIFO_FULL    (FIFO_ENTRIES >= ACCEL_FIFO_SIZE)
+#define FIFO_EMPTY   ACCEL_FIFO_EMPTY(&dev->fifo)
 
 #define FIFO_TYPE 0xff000000
 #define FIFO_ADDR 0x00ffffff
@@ -164,12 +162,6 @@ enum
         FIFO_WRITE_FB_LONG = (0x06 << 24)
 };
 
-typedef struct
-{
-        uint32_t addr_type;
-        uint32_t val;
-} fifo_entry_t;
-
 typedef struct tgui_t
 {
         mem_map_t linear_mapping;
@@ -222,15 +214,8 @@ typedef struct tgui_t
 
         uint32_t vram_size, vram_mask;
 
-        fifo_entry_t fifo[FIFO_SIZE];
-        volatile int fifo_read_idx, fifo_write_idx;
-
-        thread_t *fifo_thread;
-        event_t *wake_fifo_thread;
-        event_t *fifo_not_full_event;
+        accel_fifo_t fifo;
 
-        int blitter_busy;
-        uint64_t blitter_time;
         uint64_t status_time;
 
         volatile int write_blitter;
@@ -244,8 +229,6 @@ static const video_timings_t tgui_timing = {VID_BUS,4,8,16,4,8,16};
 
 void tgui_recalcmapping(tgui_t *tgui);
 
-static void fifo_thread(void *param);
-
 uint8_t tgui_accel_read(uint32_t addr, priv_t);
 uint16_t tgui_accel_read_w(uint32_t addr, priv_t);
 uint32_t tgui_accel_read_l(uint32_t addr, priv_t);
@@ -983,14 +966,7 @@ enum
                         
 #define MIX() do \
 	{								\
-		out = 0;						\
-        	for (c=0;c<16;c++)					\
-	        {							\
-			d=(dst_dat & (1<<c)) ? 1:0;			\
-                       	if (src_dat & (1<<c)) d|=2;			\
-               	        if (pat_dat & (1<<c)) d|=4;			\
-                        if (dev->accel.rop & (1<<d)) out|=(1<<c);	\
-	        }							\
+		out = blit_rop3(dev->accel.rop, dst_dat, src_dat, pat_dat); \
 	} while (0)
 
 #define WRITE(addr, dat)        if (dev->accel.bpp == 0)                                                \
@@ -1004,17 +980,134 @@ enum
                                         svga->changedvram[((addr) & 0xfffff) >> 11] = changeframecount;        \
                                 }
                                 
+/*
+ * Do a whole screen-to-screen blit at once if it is a plain copy or
+ * fill. Returns 0 if it needs the pixel loop.
+ */
+static int
+tgui_accel_fast(tgui_t *dev, int xdir, int ydir)
+{
+        svga_t *svga = &dev->svga;
+        int bytes = dev->accel.bpp ? 2 : 1;
+        int w = dev->accel.size_x + 1;
+        int h = dev->accel.size_y + 1;
+        int pitch = dev->accel.pitch * bytes * ydir;
+        int64_t dst = (int64_t)dev->accel.dst * bytes;
+        int64_t src = (int64_t)dev->accel.src * bytes;
+        int px = dev->accel.pat_x;
+        uint32_t pat[64];
+        blit_surf_t bs;
+        int x, y, ok;
+
+        if (dev->accel.flags & TGUI_TRANSENA)
+                return 0;
+
+        /*Leftmost pixels of the first row*/
+        if (xdir < 0) {
+                dst -= (w - 1) * bytes;
+                src -= (w - 1) * bytes;
+                px -= w - 1;
+        }
+
+        bs.vram = svga->vram;
+        bs.changed = svga->changedvram;
+        bs.mask = 0x1fffff;
+
+        switch (dev->accel.rop) {
+                case ROP_SRCCOPY:
+                        ok = blit_copy(&bs, dst, src, pitch, pitch, w, h, bytes, xdir);
+                        break;
+
+                case ROP_PATCOPY:
+                        for (y = 0; y < 8; y++) {
+                                for (x = 0; x < 8; x++)
+                                        pat[y * 8 + x] = dev->accel.tgui_pattern[y][x];
+                        }
+                        ok = blit_pattern(&bs, dst, pitch, w, h, bytes, pat,
+                                          px, dev->accel.pat_y, ydir);
+                        break;
+
+                case ROP_BLACKNESS:
+                case ROP_WHITENESS:
+                        ok = blit_fill(&bs, dst, pitch, w, h, bytes,
+                                       blit_rop3(dev->accel.rop, 0, 0, 0));
+                        break;
+
+                default:
+                        return 0;
+        }
+        if (! ok)
+                return 0;
+
+        /*Leave the registers as the pixel loop would*/
+        dev->accel.x = 0;
+        dev->accel.y = h;
+        dev->accel.pat_x = dev->accel.dst_x;
+        dev->accel.pat_y += h * ydir;
+        dev->accel.src = dev->accel.src_old = dev->accel.src_old + (h * ydir * dev->accel.pitch);
+        dev->accel.dst = dev->accel.dst_old = dev->accel.dst_old + (h * ydir * dev->accel.pitch);
+
+        return 1;
+}
+
+/*
+ * Expand a run of monochrome CPU data within the current row. The
+ * last pixel of the row, and of the data, is left for the pixel loop,
+ * which takes care of moving to the next row.
+ */
+static void
+tgui_accel_mono(tgui_t *dev, int *count, uint32_t *cpu_dat, uint16_t trans_col)
+{
+        svga_t *svga = &dev->svga;
+        int bytes = dev->accel.bpp ? 2 : 1;
+        uint16_t fg = dev->accel.fg_col, bg = dev->accel.bg_col;
+        blit_surf_t bs;
+        int n, trans = 0;
+
+        n = dev->accel.size_x - dev->accel.x;
+        if (n > *count - 1)
+                n = *count - 1;
+        if (n < 2)
+                return;
+
+        if (dev->accel.bpp == 0) {
+                fg &= 0xff;
+                bg &= 0xff;
+        }
+        if (dev->accel.flags & TGUI_TRANSENA) {
+                if (fg == trans_col)
+                        trans |= BLIT_TRANS_FG;
+                if (bg == trans_col)
+                        trans |= BLIT_TRANS_BG;
+        }
+
+        bs.vram = svga->vram;
+        bs.changed = svga->changedvram;
+        bs.mask = 0x1fffff;
+        if (! blit_mono(&bs, (int64_t)dev->accel.dst * bytes, n, bytes,
+                        *cpu_dat, fg, bg, trans))
+                return;
+
+        *cpu_dat <<= n;
+        *count -= n;
+        dev->accel.src += n;
+        dev->accel.dst += n;
+        dev->accel.pat_x += n;
+        dev->accel.x += n;
+}
+
 void tgui_accel_command(int count, uint32_t cpu_dat, tgui_t *dev)
 {
         svga_t *svga = &dev->svga;
 	int x, y;
-	int c, d;
 	uint16_t src_dat, dst_dat, pat_dat;
-	uint8_t out;
+	uint16_t out;
 	int xdir = (dev->accel.flags & 0x200) ? -1 : 1;
 	int ydir = (dev->accel.flags & 0x100) ? -1 : 1;
 	uint16_t trans_col = (dev->accel.flags & TGUI_TRANSREV) ? dev->accel.fg_col : dev->accel.bg_col;
         uint16_t *vram_w = (uint16_t *)svga->vram;
+
+	ACCEL_FIFO_OP(&dev->fifo, (dev->accel.command == TGUI_BITBLT) ? "bitblt" : "other");
         
 	if (dev->accel.bpp == 0)
                       trans_col &= 0xff;
@@ -1128,6 +1221,9 @@ void tgui_accel_command(int count, uint32_t cpu_dat, tgui_t *dev)
                                                 return;
 			        }
 			        while (count) {
+				        if (dev->accel.rop == ROP_SRCCOPY && xdir > 0)
+				                tgui_accel_mono(dev, &count, &cpu_dat, trans_col);
+
 				        src_dat = ((cpu_dat >> 31) ? dev->accel.fg_col : dev->accel.bg_col);
 				        if (dev->accel.bpp == 0)
 				                src_dat &= 0xff;
@@ -1169,6 +1265,9 @@ void tgui_accel_command(int count, uint32_t cpu_dat, tgui_t *dev)
 			        break;
 
 			default:
+			        if (count == -1 && tgui_accel_fast(dev, xdir, ydir))
+			                return;
+
 			        while (count) {
 				        READ(dev->accel.src, src_dat);
 				        READ(dev->accel.dst, dst_dat);                                                                
@@ -1337,79 +1436,34 @@ static void tgui_accel_write_fifo_fb_l(tgui_t *dev, uint32_t addr, uint32_t val)
 	tgui_accel_command(32, ((val & 0xff000000) >> 24) | ((val & 0x00ff0000) >> 8) | ((val & 0x0000ff00) << 8) | ((val & 0x000000ff) << 24), dev);
 }
 
-static void fifo_thread(void *param)
+static void tgui_fifo_process(priv_t priv, uint32_t addr_type, uint32_t val)
 {
-        tgui_t *dev = (tgui_t *)param;
-        
-        while (1) {
-                thread_set_event(dev->fifo_not_full_event);
-                thread_wait_event(dev->wake_fifo_thread, -1);
-                thread_reset_event(dev->wake_fifo_thread);
-                dev->blitter_busy = 1;
-                while (!FIFO_EMPTY) {
-                        uint64_t start_time = plat_timer_read();
-                        uint64_t end_time;
-                        fifo_entry_t *fifo = &dev->fifo[dev->fifo_read_idx & FIFO_MASK];
-
-                        switch (fifo->addr_type & FIFO_TYPE) {
-                                case FIFO_WRITE_BYTE:
-                                tgui_accel_write_fifo(dev, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                                case FIFO_WRITE_FB_BYTE:
-                                tgui_accel_write_fifo_fb_b(dev, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                                case FIFO_WRITE_FB_WORD:
-                                tgui_accel_write_fifo_fb_w(dev, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                                case FIFO_WRITE_FB_LONG:
-                                tgui_accel_write_fifo_fb_l(dev, fifo->addr_type & FIFO_ADDR, fifo->val);
-                                break;
-                        }
-                                                
-                        dev->fifo_read_idx++;
-                        fifo->addr_type = FIFO_INVALID;
-
-                        if (FIFO_ENTRIES > 0xe000)
-                                thread_set_event(dev->fifo_not_full_event);
+        tgui_t *dev = (tgui_t *)priv;
 
-                        end_time = plat_timer_read();
-                        dev->blitter_time += end_time - start_time;
-                }
-                dev->blitter_busy = 0;
+        switch (addr_type & FIFO_TYPE) {
+                case FIFO_WRITE_BYTE:
+                tgui_accel_write_fifo(dev, addr_type & FIFO_ADDR, val);
+                break;
+                case FIFO_WRITE_FB_BYTE:
+                tgui_accel_write_fifo_fb_b(dev, addr_type & FIFO_ADDR, val);
+                break;
+                case FIFO_WRITE_FB_WORD:
+                tgui_accel_write_fifo_fb_w(dev, addr_type & FIFO_ADDR, val);
+                break;
+                case FIFO_WRITE_FB_LONG:
+                tgui_accel_write_fifo_fb_l(dev, addr_type & FIFO_ADDR, val);
+                break;
         }
 }
 
-static inline void wake_fifo_thread(tgui_t *dev)
-{
-        thread_set_event(dev->wake_fifo_thread); /*Wake up FIFO thread if moving from idle*/
-}
-
 static void tgui_wait_fifo_idle(tgui_t *dev)
 {
-        while (!FIFO_EMPTY)
-        {
-                wake_fifo_thread(dev);
-                thread_wait_event(dev->fifo_not_full_event, 1);
-        }
+        accel_fifo_wait_idle(&dev->fifo);
 }
 
 static void tgui_queue(tgui_t *dev, uint32_t addr, uint32_t val, uint32_t type)
 {
-        fifo_entry_t *fifo = &dev->fifo[dev->fifo_write_idx & FIFO_MASK];
-
-        if (FIFO_FULL) {
-                thread_reset_event(dev->fifo_not_full_event);
-                if (FIFO_FULL)
-                        thread_wait_event(dev->fifo_not_full_event, -1); /*Wait for room in ringbuffer*/
-        }
-
-        fifo->val = val;
-        fifo->addr_type = (addr & FIFO_ADDR) | type;
-
-        dev->fifo_write_idx++;
-        
-        if (FIFO_ENTRIES > 0xe000 || FIFO_ENTRIES < 8)
-                wake_fifo_thread(dev);
+        accel_fifo_queue(&dev->fifo, (addr & FIFO_ADDR) | type, val);
 }
 
 
@@ -1625,9 +1679,7 @@ tgui_init(const device_t *info, UNUSED(void *parent))
                 dev->ddc = ddc_init(i2c_gpio_get_bus(dev->i2c));
         }
 
-        dev->wake_fifo_thread = thread_create_event();
-        dev->fifo_not_full_event = thread_create_event();
-        dev->fifo_thread = thread_create(fifo_thread, dev);
+        accel_fifo_init(&dev->fifo, info->name, tgui_fifo_process, NULL, dev);
 
 	video_inform(DEVICE_VIDEO_GET(info->flags), &tgui_timing);
 
@@ -1640,16 +1692,14 @@ tgui_close(priv_t priv)
 {
         tgui_t *dev = (tgui_t *)priv;
         
+        accel_fifo_close(&dev->fifo);
+
         svga_close(&dev->svga);
 
         if (dev->type >= TGUI_9440) {
                 ddc_close(dev->ddc);
                 i2c_gpio_close(dev->i2c);
         }
-        
-        thread_kill(dev->fifo_thread);
-        thread_destroy_event(dev->wake_fifo_thread);
-        thread_destroy_event(dev->fifo_not_full_event);
 
         free(dev);
 }
@@ -8,7 +8,7 @@
  *
  *		Main video-rendering module.
  *
- * Version:	@(#)video.c	1.0.34	2021/03/16
+ * Version:	@(#)video.c	1.0.39	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -55,9 +55,14 @@
 #include "../../device.h"
 #include "../../timer.h"
 #include "../../plat.h"
+#include "../../ui/ui.h"
 #include "video.h"
 #include "vid_mda.h"
 #include "vid_svga.h"
+#include "vid_text.h"
+
+
+#define CAPTURE_THREADS	2		/* frame capture encoders */
 
 
 #ifdef ENABLE_VIDEO_LOG
@@ -85,6 +90,7 @@ int		cga_palette = 0;
 int		changeframecount = 2;
 int		frames = 0;
 int		fullchange = 0;
+int		video_draw = 1;			/* draw the current frame */
 int		displine = 0;
 int		enable_overscan,
 		update_overscan,
@@ -401,20 +407,33 @@ static struct blitter {
     void	(*func)(bitmap_t *,int x, int y, int y1, int y2, int w, int h);
 }		blitter;
 
+static int	draw_count,			/* frames since last drawn */
+		draw_skipped;			/* a frame was left out */
+static uint64_t	draw_last,			/* when we last drew one */
+		draw_tick;			/* when the last frame ended */
+
 
 static void
 blit_thread(void *param)
 {
     struct blitter *blit = (struct blitter *)param;
+    uint64_t start;
 
     for (;;) {
 	thread_wait_event(blit->wake_ev, -1);
 	thread_reset_event(blit->wake_ev);
 
-	if (blit->func != NULL)
+	if (blit->func != NULL) {
+		start = video_stats_on ? plat_timer_read() : 0;
+
 		blit->func(screen, blit->x, blit->y,
 			   blit->y1, blit->y2, blit->w, blit->h);
 
+		if (video_stats_on)
+			video_stats_add(VSTAT_BLIT, "video", "frame", 1,
+					plat_timer_read() - start);
+	}
+
 	blit->busy = 0;
 	thread_set_event(blit->busy_ev);
     }
@@ -522,6 +541,45 @@ video_blend(int x, int y)
 }
 
 
+/*
+ * Decide whether the next frame should be drawn.
+ *
+ * The cards keep all their timing going for frames that are not
+ * drawn, so the guest sees no difference; only the drawing into
+ * the screen buffer, and the blit, are left out.
+ */
+static int
+video_draw_next(void)
+{
+    uint64_t now, period;
+    int draw = 1;
+
+    if (config.vid_watched && !vidapi_watched())
+	draw = 0;
+
+    if (config.vid_frameskip > 1) {
+	if (++draw_count < config.vid_frameskip)
+		draw = 0;
+	else
+		draw_count = 0;
+    }
+
+    if (config.vid_maxfps > 0) {
+	now = plat_timer_read();
+	period = plat_timer_freq() / config.vid_maxfps;
+
+	/* Allow for half a frame of jitter in the guest's timing. */
+	if (draw && ((now - draw_last) + ((now - draw_tick) >> 1)) < period)
+		draw = 0;
+	if (draw)
+		draw_last = now;
+	draw_tick = now;
+    }
+
+    return(draw);
+}
+
+
 /* Set up the blitter, and then wake it up to process the screen buffer. */
 void
 video_blit_start(int pal, int x, int y, int y1, int y2, int w, int h)
@@ -529,9 +587,30 @@ video_blit_start(int pal, int x, int y, int y1, int y2, int w, int h)
     uint32_t val;
     int yy, xx;
     pel_t *p;
+    int draw;
 
-    if (h <= 0)
+    /* This frame was decided on at the end of the previous one. */
+    draw = video_draw;
+    video_draw = video_draw_next();
+
+    if ((h <= 0) || !draw) {
+	draw_skipped |= !draw;
 	return;
+    }
+
+    /* The renderer missed some changes, so give it all lines. */
+    if (draw_skipped) {
+	y1 = 0;
+	y2 = h;
+	draw_skipped = 0;
+    }
+
+    video_stats_frame();
+
+#ifdef USE_LIBPNG
+    /* Grab a copy if we are capturing frames. */
+    video_capture_frame(pal, x, y, w, h);
+#endif
 
     if (pal) {
 	/* In palette mode, first convert the values. */
@@ -807,6 +886,8 @@ video_init(void)
     for (c = 0; c < 65536; c++)
 	video_16to32[c] = calc_16to32(c);
 
+    text_init();
+
     /* Create the screen buffer. */
     screen = create_bitmap(2048, 2048);
 
@@ -814,12 +895,27 @@ video_init(void)
     blitter.busy_ev = thread_create_event();
     blitter.inuse_ev = thread_create_event();
     blitter.thread = thread_create(blit_thread, &blitter);
+
+#ifdef USE_LIBPNG
+    if (grab_path[0] != L'\0')
+	video_capture_init(grab_path, grab_rate, grab_level, grab_rgb,
+			   CAPTURE_THREADS);
+#endif
+
+    if (vidstats_path[0] != L'\0')
+	video_stats_init(vidstats_path);
 }
 
 
 void
 video_close(void)
 {
+    video_stats_close();
+
+#ifdef USE_LIBPNG
+    video_capture_close();
+#endif
+
     thread_kill(blitter.thread);
     thread_destroy_event(blitter.inuse_ev);
     thread_destroy_event(blitter.busy_ev);
@@ -856,6 +952,10 @@ video_reset(void)
     update_overscan = 0;
     suppress_overscan = 0;
 
+    video_draw = 1;
+    draw_count = 0;
+    draw_skipped = 0;
+
     /* Do not initialize internal cards here. */
     if ((config.video_card == VID_NONE) ||
 	(config.video_card == VID_INTERNAL) || \
@@ -8,7 +8,7 @@
  *
  *		Definitions for the video controller module.
  *
- * Version:	@(#)video.h	1.0.41	2021/03/16
+ * Version:	@(#)video.h	1.0.46	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -75,6 +75,14 @@ enum {
     FULLSCR_SCALE_INT
 };
 
+/* Classes of video statistics. */
+enum {
+    VSTAT_FRAME = 0,
+    VSTAT_RENDER,
+    VSTAT_BLIT,
+    VSTAT_ACCEL
+};
+
 typedef enum {
     FONT_MDA = 0,			// MDA 8x14
     FONT_CGA_THIN,			// CGA 8x8, thin lines
@@ -131,6 +139,7 @@ extern uint32_t		*video_6to8,
 			*video_16to32;
 extern uint32_t		pal_lookup[256];
 extern int		fullchange;
+extern int		video_draw;
 extern int		xsize,ysize;		// TBR
 extern int		enable_overscan,
 			update_overscan,
@@ -367,6 +376,25 @@ extern void		video_blit_start(int pal, int x, int y,
 extern void		video_blend(int x, int y);
 extern void		video_palette_rebuild(void);
 
+#ifdef USE_LIBPNG
+extern void		video_capture_init(const wchar_t *path, int rate,
+					   int level, int rgb, int threads);
+extern void		video_capture_close(void);
+extern void		video_capture_frame(int pal, int x, int y,
+					    int w, int h);
+#endif
+
+extern int		video_stats_on;
+extern void		video_stats_init(const wchar_t *path);
+extern void		video_stats_close(void);
+extern void		video_stats_add(int cls, const char *dev,
+					const char *name,
+					uint64_t count, uint64_t ticks);
+extern void		video_stats_add_local(int cls, const char *dev,
+					      const char *name,
+					      uint64_t count, uint64_t ticks);
+extern void		video_stats_frame(void);
+
 extern void		video_log(int level, const char *fmt, ...);
 extern void		video_init(void);
 extern void		video_close(void);
@@ -0,0 +1,325 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Capture of video frames to PNG files.
+ *
+ *		Every so many frames, the screen is copied into one of a
+ *		small pool of buffers, which a few worker threads then
+ *		encode and write out. The emulator never waits for them;
+ *		if no buffer is free, the frame is skipped and counted.
+ *		Frames from 8-bit palette modes can be written with their
+ *		palette, which is smaller and keeps the original indexes.
+ *
+ * Version:	@(#)video_capture.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "../../emu.h"
+#include "../../config.h"
+#include "../../plat.h"
+#include "video.h"
+#ifdef USE_LIBPNG
+# include "../../misc/png.h"
+
+
+#define CAPT_BUFS	8			/* frames in the pool */
+#define CAPT_MAX_THREADS 8
+
+
+enum {
+    CAPT_FREE = 0,				/* owned by emulator */
+    CAPT_READY,					/* waiting for a worker */
+    CAPT_BUSY					/* being encoded */
+};
+
+typedef struct {
+    volatile int state;
+    uint32_t	seq;
+    int		w, h,
+		pal;				/* pixels are palette indexes */
+    size_t	size;
+    uint8_t	*pix;
+    RGB_PAL	palette;
+} capt_buf_t;
+
+
+static wchar_t		capt_path[1024];
+static int		capt_rate,
+			capt_level,
+			capt_count,
+			capt_rgb,
+			capt_threads;
+static uint32_t		capt_seq,
+			capt_skips;
+static volatile int	capt_stop;
+static capt_buf_t	capt_bufs[CAPT_BUFS];
+static thread_t		*capt_thread[CAPT_MAX_THREADS];
+static event_t		*capt_event = NULL;
+static mutex_t		*capt_lock = NULL;
+
+
+/* Claim the oldest frame that is waiting, if any. */
+static capt_buf_t *
+capt_claim(void)
+{
+    capt_buf_t *b = NULL;
+    int i;
+
+    thread_wait_mutex(capt_lock);
+
+    for (i = 0; i < CAPT_BUFS; i++) {
+	if (capt_bufs[i].state != CAPT_READY) continue;
+	if ((b == NULL) || ((int32_t)(capt_bufs[i].seq - b->seq) < 0))
+		b = &capt_bufs[i];
+    }
+    if (b != NULL)
+	b->state = CAPT_BUSY;
+
+    thread_release_mutex(capt_lock);
+
+    return(b);
+}
+
+
+static void
+capt_write(capt_buf_t *b)
+{
+    wchar_t fn[1024], temp[32];
+
+    swprintf(temp, sizeof_w(temp), L"frame%06u.png", b->seq);
+    plat_append_filename(fn, capt_path, temp);
+
+    if (b->pal)
+	(void)png_write_pal(fn, b->pix, (int16_t)b->w, (int16_t)b->h,
+			    (uint16_t)b->w, b->palette, capt_level);
+    else
+	(void)png_write_rgb(fn, 1, b->pix, (int16_t)b->w, (int16_t)b->h,
+			    capt_level);
+}
+
+
+static void
+capt_worker(void *arg)
+{
+    capt_buf_t *b;
+
+    for (;;) {
+	b = capt_claim();
+	if (b == NULL) {
+		if (capt_stop) break;
+
+		thread_wait_event(capt_event, 50);
+		thread_reset_event(capt_event);
+		continue;
+	}
+
+	capt_write(b);
+
+	/* Hand the buffer back to the emulator. */
+	b->state = CAPT_FREE;
+    }
+}
+
+
+/* Start capturing frames into the given directory. */
+void
+video_capture_init(const wchar_t *path, int rate, int level, int rgb, int threads)
+{
+    int i;
+
+    if (! png_load()) {
+	ERRLOG("VIDEO: PNG support not available, no frame capture\n");
+	return;
+    }
+
+    wcsncpy(capt_path, path, sizeof_w(capt_path) - 1);
+    plat_dir_create(capt_path);
+
+    capt_rate = (rate > 0) ? rate : 1;
+    capt_rgb = rgb;
+    capt_threads = (threads < 1) ? 1 : threads;
+    if (capt_threads > CAPT_MAX_THREADS)
+	capt_threads = CAPT_MAX_THREADS;
+    capt_count = 0;
+    capt_seq = capt_skips = 0;
+    capt_level = (level < 0) ? 0 : (level > 9) ? 9 : level;
+
+    memset(capt_bufs, 0x00, sizeof(capt_bufs));
+    capt_stop = 0;
+    capt_lock = thread_create_mutex(L"VARCem.Capture");
+    capt_event = thread_create_event();
+    for (i = 0; i < capt_threads; i++)
+	capt_thread[i] = thread_create(capt_worker, NULL);
+
+    INFO("VIDEO: capturing every %i frames to '%ls' (%i threads)\n",
+	 capt_rate, capt_path, capt_threads);
+}
+
+
+/* Stop capturing, after writing all frames still pending. */
+void
+video_capture_close(void)
+{
+    int i;
+
+    if (capt_event == NULL) return;
+
+    capt_stop = 1;
+    thread_set_event(capt_event);
+    for (i = 0; i < capt_threads; i++)
+	(void)thread_wait(capt_thread[i], -1);
+
+    thread_destroy_event(capt_event);
+    capt_event = NULL;
+    thread_close_mutex(capt_lock);
+    capt_lock = NULL;
+
+    for (i = 0; i < CAPT_BUFS; i++) {
+	if (capt_bufs[i].pix != NULL)
+		free(capt_bufs[i].pix);
+	capt_bufs[i].pix = NULL;
+    }
+
+    INFO("VIDEO: capture done, %u frames, %u skipped\n",
+	 capt_seq - capt_skips, capt_skips);
+}
+
+
+/*
+ * Grab a frame from the screen buffer, if it is time to.
+ *
+ * Called from video_blit_start() on the emulator thread, before any
+ * palette conversion, so 8-bit modes still have their indexes. The
+ * RGB lines are stored bottom-up, which is what png_write_rgb() wants
+ * for our pixel format.
+ */
+void
+video_capture_frame(int pal, int x, int y, int w, int h)
+{
+    capt_buf_t *b = NULL;
+    size_t size;
+    uint32_t v;
+    int i, yy, xx, xform;
+    uint8_t *p;
+
+    if (capt_event == NULL) return;
+
+    if (++capt_count < capt_rate) return;
+    capt_count = 0;
+
+    if ((w <= 0) || (h <= 0) || (y < 0) || ((y + h) > screen->h)) return;
+
+    capt_seq++;
+
+    for (i = 0; i < CAPT_BUFS; i++) {
+	if (capt_bufs[i].state == CAPT_FREE) {
+		b = &capt_bufs[i];
+		break;
+	}
+    }
+    if (b == NULL) {
+	/* All buffers are in use, we do not wait. */
+	capt_skips++;
+	return;
+    }
+
+    b->seq = capt_seq;
+    b->w = w;
+    b->h = h;
+    b->pal = (pal && !capt_rgb);
+
+    size = (size_t)w * h * (b->pal ? 1 : 4);
+    if (size > b->size) {
+	if (b->pix != NULL)
+		free(b->pix);
+	b->pix = (uint8_t *)mem_alloc(size);
+	b->size = size;
+    }
+
+    /* All paths apply the display's color settings, as a screenshot does. */
+    xform = (config.vid_grayscale || config.invert_display);
+
+    if (b->pal) {
+	for (i = 0; i < 256; i++) {
+		v = pal_lookup[i];
+		if (xform)
+			v = video_color_transform(v);
+		b->palette[i].r = (v >> 16) & 0xff;
+		b->palette[i].g = (v >> 8) & 0xff;
+		b->palette[i].b = v & 0xff;
+	}
+
+	p = b->pix;
+	for (yy = 0; yy < h; yy++) {
+		for (xx = 0; xx < w; xx++)
+			*p++ = screen->line[y + yy][x + xx].pal;
+	}
+    } else if (pal) {
+	for (yy = 0; yy < h; yy++) {
+		p = b->pix + ((size_t)(h - 1 - yy) * w * 4);
+		for (xx = 0; xx < w; xx++) {
+			v = pal_lookup[screen->line[y + yy][x + xx].pal];
+			if (xform)
+				v = video_color_transform(v);
+			memcpy(p, &v, 4);
+			p += 4;
+		}
+	}
+    } else if (xform) {
+	for (yy = 0; yy < h; yy++)
+		video_transform_copy((uint32_t *)(b->pix + ((size_t)(h - 1 - yy) * w * 4)),
+				     &screen->line[y + yy][x], w);
+    } else {
+	for (yy = 0; yy < h; yy++)
+		memcpy(b->pix + ((size_t)(h - 1 - yy) * w * 4),
+		       &screen->line[y + yy][x], w * 4);
+    }
+
+    b->state = CAPT_READY;
+    thread_set_event(capt_event);
+}
+
+
+#endif	/*USE_LIBPNG*/
@@ -0,0 +1,274 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Collection of video performance statistics.
+ *
+ *		When enabled, the video code reports how much host time
+ *		it spends per emulated frame, in each scanline renderer,
+ *		in the blitter and, per card and command, in the
+ *		accelerator command FIFOs. On exit, the totals are written
+ *		to a report file with one line per item, as comma-separated
+ *		values, so runs of two builds can be compared by a script.
+ *		These come from a live guest, so they vary from run to run;
+ *		there is no way to replay a recorded register trace (yet.)
+ *
+ * Version:	@(#)video_stats.c	1.0.4	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include "../../emu.h"
+#include "../../plat.h"
+#include "video.h"
+
+
+#define VSTAT_MAX	64
+
+
+typedef struct {
+    int		cls;
+    const char	*dev,			/* device or part, like "svga" */
+		*name;
+    uint64_t	count,
+		ticks;
+} vstat_t;
+
+
+int		video_stats_on = 0;
+
+static const char *cls_names[] = {
+    "frame", "render", "blit", "accel"
+};
+static wchar_t	stats_path[1024];
+static mutex_t	*stats_lock;
+static vstat_t	stats[VSTAT_MAX];
+static int	stats_num;
+static vstat_t	local[VSTAT_MAX];		/* emulator thread only */
+static int	local_num;
+static uint64_t	frame_last;
+
+
+/* Find (or make) the entry for an item in a table. */
+static vstat_t *
+stats_find(vstat_t *tab, int *num, int cls, const char *dev, const char *name)
+{
+    vstat_t *st;
+    int i;
+
+    for (i = 0; i < *num; i++) {
+	st = &tab[i];
+	if (st->cls == cls &&
+	    (st->dev == dev || !strcmp(st->dev, dev)) &&
+	    (st->name == name || !strcmp(st->name, name)))
+		return(st);
+    }
+
+    if (*num == VSTAT_MAX)
+	return(NULL);
+
+    st = &tab[(*num)++];
+    st->cls = cls;
+    st->dev = dev;
+    st->name = name;
+    st->count = st->ticks = 0;
+
+    return(st);
+}
+
+
+/* Move the local counts into the shared table. Called with the lock. */
+static void
+stats_merge(void)
+{
+    vstat_t *st;
+    int i;
+
+    for (i = 0; i < local_num; i++) {
+	st = stats_find(stats, &stats_num, local[i].cls,
+			local[i].dev, local[i].name);
+	if (st == NULL)
+		break;
+	st->count += local[i].count;
+	st->ticks += local[i].ticks;
+    }
+
+    local_num = 0;
+}
+
+
+/* Start collecting statistics, to be written to the given file. */
+void
+video_stats_init(const wchar_t *path)
+{
+    wcsncpy(stats_path, path, sizeof_w(stats_path) - 1);
+
+    memset(stats, 0x00, sizeof(stats));
+    stats_num = 0;
+    local_num = 0;
+    frame_last = 0;
+    if (stats_lock == NULL)
+	stats_lock = thread_create_mutex(NULL);
+
+    video_stats_on = 1;
+
+    INFO("VIDEO: collecting statistics into '%ls'\n", stats_path);
+}
+
+
+/*
+ * Stop collecting, and write out the report.
+ *
+ * The accelerator threads may still be running at this point, so we
+ * keep the lock around, and just make sure they are out of it.
+ */
+void
+video_stats_close(void)
+{
+    uint64_t freq, ns;
+    FILE *fp;
+    int i;
+
+    if (! video_stats_on) return;
+    video_stats_on = 0;
+
+    thread_wait_mutex(stats_lock);
+
+    stats_merge();
+
+    fp = plat_fopen(stats_path, L"w");
+    if (fp == NULL) {
+	ERRLOG("VIDEO: unable to write statistics to '%ls'\n", stats_path);
+    } else {
+	freq = plat_timer_freq();
+	if (freq == 0)
+		freq = 1;
+
+	fprintf(fp, "# %s video statistics\n", emu_fullversion);
+	fprintf(fp, "class,device,name,count,total_ns,avg_ns\n");
+	for (i = 0; i < stats_num; i++) {
+		ns = (uint64_t)((double)stats[i].ticks * 1000000000.0 / freq);
+		fprintf(fp, "%s,%s,%s,%llu,%llu,%llu\n",
+			cls_names[stats[i].cls], stats[i].dev, stats[i].name,
+			(unsigned long long)stats[i].count,
+			(unsigned long long)ns,
+			(unsigned long long)(stats[i].count ? ns / stats[i].count : 0));
+	}
+
+	(void)fclose(fp);
+    }
+
+    thread_release_mutex(stats_lock);
+}
+
+
+/*
+ * Add count items taking the given number of timer ticks.
+ *
+ * The device and name are used as the key, and must be static
+ * strings. This can be called from any thread.
+ */
+void
+video_stats_add(int cls, const char *dev, const char *name,
+		uint64_t count, uint64_t ticks)
+{
+    vstat_t *st;
+
+    if (! video_stats_on) return;
+
+    thread_wait_mutex(stats_lock);
+    if (! video_stats_on) {
+	thread_release_mutex(stats_lock);
+	return;
+    }
+
+    st = stats_find(stats, &stats_num, cls, dev, name);
+    if (st != NULL) {
+	st->count += count;
+	st->ticks += ticks;
+    }
+
+    thread_release_mutex(stats_lock);
+}
+
+
+/*
+ * Same, but for the emulator thread only.
+ *
+ * These are kept in a local table without locking, and moved into
+ * the shared one once per frame, as they come in for every line.
+ */
+void
+video_stats_add_local(int cls, const char *dev, const char *name,
+		      uint64_t count, uint64_t ticks)
+{
+    vstat_t *st;
+
+    if (! video_stats_on) return;
+
+    st = stats_find(local, &local_num, cls, dev, name);
+    if (st != NULL) {
+	st->count += count;
+	st->ticks += ticks;
+    }
+}
+
+
+/* Account for the host time since the previous frame. */
+void
+video_stats_frame(void)
+{
+    uint64_t now;
+
+    if (! video_stats_on) return;
+
+    now = plat_timer_read();
+    if (frame_last != 0)
+	video_stats_add_local(VSTAT_FRAME, "video", "host",
+				      1, now - frame_last);
+    frame_last = now;
+
+    thread_wait_mutex(stats_lock);
+    stats_merge();
+    thread_release_mutex(stats_lock);
+}
@@ -8,7 +8,7 @@
  *
  *		Main include file for the application.
  *
- * Version:	@(#)emu.h	1.0.38	2021/03/18
+ * Version:	@(#)emu.h	1.0.41	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -177,6 +177,12 @@ extern int	config_keep_space;		// (O) keep spaces in cfg
 extern int	settings_only;			// (O) only the settings dlg
 extern int	log_level;			// (O) global logging level
 extern wchar_t	log_path[1024];			// (O) full path of logfile
+extern wchar_t	audio_path[1024];		// (O) full path of audio capture
+extern wchar_t	grab_path[1024];		// (O) folder for frame capture
+extern int	grab_rate;			// (O) capture every Nth frame
+extern int	grab_level;			// (O) capture PNG compression
+extern int	grab_rgb;			// (O) capture always in RGB
+extern wchar_t	vidstats_path[1024];		// (O) file for video statistics
 
 /* Global variables. */
 extern char	emu_title[64];			// full name of application
@@ -10,7 +10,14 @@
  *
  * **NOTES**	The cpu-specific MMU code should be moved to cpu/mmu.c.
  *
- * Version:	@(#)mem.c	1.0.41	2021/03/16
+ *		Mappings are kept in a list in the order they were added
+ *		(later ones win where they overlap), and in an index that
+ *		is sorted by base address, so a recalc only has to look
+ *		at the mappings that overlap the range. Only granules of
+ *		which the resolution changed, and the lookup entries for
+ *		those, are updated.
+ *
+ * Version:	@(#)mem.c	1.0.44	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -110,6 +117,22 @@ static mem_map_t	*write_mapping[0x40000];
 static uint8_t		*_mem_exec[0x40000];
 static int		_mem_state[0x40000];
 
+/* Physical granule of each lookup entry, or -1 if not known. */
+static uint32_t		readlookup_phys[256];
+static uint32_t		writelookup_phys[256];
+
+typedef struct {
+    mem_map_t	*map;
+    uint32_t	seq;			/* order added, later ones win */
+} map_ent_t;
+
+static map_ent_t	*map_index;		/* mappings, sorted by base */
+static uint64_t		*map_maxend;		/* highest end in 0..i */
+static map_ent_t	*map_cand;
+static int		map_count,
+			map_max;
+static uint32_t		map_seq;
+
 static uint8_t		ff_pccache[4] = { 0xff, 0xff, 0xff, 0xff };
 
 
@@ -376,6 +399,7 @@ addreadlookup(uint32_t virt, uint32_t phys)
     readlookup2[virt>>12] = (uintptr_t)&ram[(uintptr_t)(phys & ~0xFFF) - (uintptr_t)(virt & ~0xfff)];
 
     readlookupp[readlnext] = mmu_perm;
+    readlookup_phys[readlnext] = phys >> MEM_GRANULARITY_BITS;
     readlookup[readlnext++] = virt >> 12;
     readlnext &= (cachesize-1);
 
@@ -405,6 +429,34 @@ addwritelookup(uint32_t virt, uint32_t phys)
 	writelookup2[virt>>12] = (uintptr_t)&ram[(uintptr_t)(phys & ~0xFFF) - (uintptr_t)(virt & ~0xfff)];
 
     writelookupp[writelnext] = mmu_perm;
+    writelookup_phys[writelnext] = phys >> MEM_GRANULARITY_BITS;
+    writelookup[writelnext++] = virt >> 12;
+    writelnext &= (cachesize - 1);
+
+    cycles -= 9;
+}
+
+
+/*
+ * Map a page of device memory for writes through the page's
+ * own handlers, which track the writes in its dirty mask.
+ */
+void
+addwritelookup_page(uint32_t virt, page_t *p)
+{
+    if (virt == 0xffffffff) return;
+
+    if (page_lookup[virt >> 12]) return;
+
+    if (writelookup[writelnext] != -1) {
+	page_lookup[writelookup[writelnext]] = NULL;
+	writelookup2[writelookup[writelnext]] = -1;
+    }
+
+    page_lookup[virt >> 12] = p;
+
+    writelookupp[writelnext] = mmu_perm;
+    writelookup_phys[writelnext] = (uint32_t)-1;
     writelookup[writelnext++] = virt >> 12;
     writelnext &= (cachesize - 1);
 
@@ -1262,47 +1314,180 @@ mem_map_write_allowed(uint32_t fl, int state)
 }
 
 
+/* Drop the lookup entries for physical granules first..last. */
+static void
+mem_flush_granules(uint32_t first, uint32_t last)
+{
+    int c;
+
+    for (c = 0; c < 256; c++) {
+	if (readlookup[c] != (int)0xffffffff &&
+	    (readlookup_phys[c] == (uint32_t)-1 ||
+	     (readlookup_phys[c] >= first && readlookup_phys[c] <= last))) {
+		readlookup2[readlookup[c]] = -1;
+		readlookup[c] = 0xffffffff;
+	}
+	if (writelookup[c] != (int)0xffffffff &&
+	    (writelookup_phys[c] == (uint32_t)-1 ||
+	     (writelookup_phys[c] >= first && writelookup_phys[c] <= last))) {
+		page_lookup[writelookup[c]] = NULL;
+		writelookup2[writelookup[c]] = -1;
+		writelookup[c] = 0xffffffff;
+	}
+    }
+}
+
+
+/* Remove a mapping from the index, returning its sequence number. */
+static uint32_t
+map_index_del(mem_map_t *map)
+{
+    uint32_t seq = (uint32_t)-1;
+    int i;
+
+    for (i = 0; i < map_count; i++) {
+	if (map_index[i].map == map) {
+		seq = map_index[i].seq;
+		map_count--;
+		memmove(&map_index[i], &map_index[i + 1],
+			(map_count - i) * sizeof(map_ent_t));
+		break;
+	}
+    }
+
+    for (; i < map_count; i++)
+	map_maxend[i] = (uint64_t)map_index[i].map->base + map_index[i].map->size;
+    for (i = 1; i < map_count; i++)
+	if (map_maxend[i] < map_maxend[i - 1])
+		map_maxend[i] = map_maxend[i - 1];
+
+    return(seq);
+}
+
+
+/* Add a mapping to the index, keeping it sorted by base address. */
+static void
+map_index_add(mem_map_t *map, uint32_t seq)
+{
+    int i, lo, hi;
+
+    if (map_count == map_max) {
+	map_max = map_max ? (map_max * 2) : 64;
+	map_index = (map_ent_t *)realloc(map_index, map_max * sizeof(map_ent_t));
+	map_maxend = (uint64_t *)realloc(map_maxend, map_max * sizeof(uint64_t));
+	map_cand = (map_ent_t *)realloc(map_cand, map_max * sizeof(map_ent_t));
+	if (map_index == NULL || map_maxend == NULL || map_cand == NULL)
+		fatal("MEM: out of memory for mapping index\n");
+    }
+
+    /* Find the first entry with a higher base. */
+    lo = 0;
+    hi = map_count;
+    while (lo < hi) {
+	i = (lo + hi) / 2;
+	if (map_index[i].map->base <= map->base)
+		lo = i + 1;
+	  else
+		hi = i;
+    }
+
+    memmove(&map_index[lo + 1], &map_index[lo],
+	    (map_count - lo) * sizeof(map_ent_t));
+    map_index[lo].map = map;
+    map_index[lo].seq = seq;
+    map_count++;
+
+    for (i = lo; i < map_count; i++) {
+	map_maxend[i] = (uint64_t)map_index[i].map->base + map_index[i].map->size;
+	if (i > 0 && map_maxend[i] < map_maxend[i - 1])
+		map_maxend[i] = map_maxend[i - 1];
+    }
+}
+
+
 static void
 mem_map_recalc(uint64_t base, uint64_t size)
 {
-    mem_map_t *map = base_mapping.next;
-    uint64_t c;
+    uint64_t start, end, c, mb, me;
+    uint32_t g, first, last, chg_lo, chg_hi;
+    mem_map_t *map, *rmap, *wmap;
+    uint8_t *exec;
+    int i, j, n, lo, hi;
 
     if (! size) return;
 
-    /* Clear out old mappings. */
-    for (c = base; c < base + size; c += 0x4000) {
-	read_mapping[c >> MEM_GRANULARITY_BITS] = NULL;
-	write_mapping[c >> MEM_GRANULARITY_BITS] = NULL;
-    }
-
-    /* Walk mapping list. */
-    while (map != NULL) {
-	/*In range?*/
-	if (map->enable && (uint64_t)map->base < ((uint64_t)base + (uint64_t)size) && ((uint64_t)map->base + (uint64_t)map->size) > (uint64_t)base) {
-		uint64_t start = (map->base < base) ? map->base : base;
-		uint64_t end   = (((uint64_t)map->base + (uint64_t)map->size) < (base + size)) ? ((uint64_t)map->base + (uint64_t)map->size) : (base + size);
-		if (start < map->base)
-			start = map->base;
-
-		for (c = start; c < end; c += 0x4000) {
-			if ((map->read_b || map->read_w || map->read_l) &&
-			     mem_map_read_allowed(map->flags, _mem_state[c >> MEM_GRANULARITY_BITS])) {
-				if (map->exec)
-					_mem_exec[c >> MEM_GRANULARITY_BITS] = map->exec + (c - map->base);
-				else
-					_mem_exec[c >> MEM_GRANULARITY_BITS] = NULL;
-				read_mapping[c >> MEM_GRANULARITY_BITS] = map;
-			}
-			if ((map->write_b || map->write_w || map->write_l) &&
-			     mem_map_write_allowed(map->flags, _mem_state[c >> MEM_GRANULARITY_BITS]))
-				write_mapping[c >> MEM_GRANULARITY_BITS] = map;
+    first = (uint32_t)(base >> MEM_GRANULARITY_BITS);
+    last = (uint32_t)((base + size - 1) >> MEM_GRANULARITY_BITS);
+    if (last >= (sizeof(_mem_state) / sizeof(_mem_state[0])))
+	last = (sizeof(_mem_state) / sizeof(_mem_state[0])) - 1;
+    start = (uint64_t)first << MEM_GRANULARITY_BITS;
+    end = ((uint64_t)last + 1) << MEM_GRANULARITY_BITS;
+
+    /* Find the first entry that starts at or above the end. */
+    lo = 0;
+    hi = map_count;
+    while (lo < hi) {
+	i = (lo + hi) / 2;
+	if ((uint64_t)map_index[i].map->base < end)
+		lo = i + 1;
+	  else
+		hi = i;
+    }
+
+    /* Collect the enabled mappings that overlap, latest first. */
+    n = 0;
+    for (i = lo - 1; i >= 0 && map_maxend[i] > start; i--) {
+	map = map_index[i].map;
+	if (! map->enable ||
+	    ((uint64_t)map->base + map->size) <= start) continue;
+
+	for (j = n++; j > 0 && map_cand[j - 1].seq < map_index[i].seq; j--)
+		map_cand[j] = map_cand[j - 1];
+	map_cand[j] = map_index[i];
+    }
+
+    chg_lo = (uint32_t)-1;
+    chg_hi = 0;
+    for (g = first; g <= last; g++) {
+	c = (uint64_t)g << MEM_GRANULARITY_BITS;
+	rmap = wmap = NULL;
+	exec = _mem_exec[g];
+
+	for (i = 0; i < n && (rmap == NULL || wmap == NULL); i++) {
+		map = map_cand[i].map;
+		mb = map->base;
+		me = mb + map->size;
+		if (mb >= (c + MEM_GRANULARITY_SIZE) || me <= c) continue;
+
+		if (rmap == NULL &&
+		    (map->read_b || map->read_w || map->read_l) &&
+		    mem_map_read_allowed(map->flags, _mem_state[g])) {
+			rmap = map;
+			if (map->exec)
+				exec = map->exec + (((c < mb) ? mb : c) - mb);
+			  else
+				exec = NULL;
 		}
+		if (wmap == NULL &&
+		    (map->write_b || map->write_w || map->write_l) &&
+		    mem_map_write_allowed(map->flags, _mem_state[g]))
+			wmap = map;
 	}
-	map = map->next;
+
+	if (read_mapping[g] == rmap && write_mapping[g] == wmap &&
+	    _mem_exec[g] == exec) continue;
+
+	read_mapping[g] = rmap;
+	write_mapping[g] = wmap;
+	_mem_exec[g] = exec;
+
+	if (g < chg_lo)
+		chg_lo = g;
+	chg_hi = g;
     }
 
-    flushmmucache_cr3();
+    if (chg_lo != (uint32_t)-1)
+	mem_flush_granules(chg_lo, chg_hi);
 }
 
 
@@ -1321,6 +1506,8 @@ mem_map_del(mem_map_t *map)
 		break;
 	}
     }
+
+    (void)map_index_del(map);
 }
 
 
@@ -1361,6 +1548,9 @@ mem_map_add(mem_map_t *map, uint32_t base, uint32_t size,
     map->dev     = NULL;
     map->next    = NULL;
 
+    (void)map_index_del(map);
+    map_index_add(map, map_seq++);
+
     mem_map_recalc(map->base, map->size);
 }
 
@@ -1382,12 +1572,19 @@ mem_map_set_handler(mem_map_t *map,
     map->write_l = write_l;
 
     mem_map_recalc(map->base, map->size);
+
+    /* The granules may resolve to the same mapping as before. */
+    if (map->size)
+	mem_flush_granules(map->base >> MEM_GRANULARITY_BITS,
+			   ((uint64_t)map->base + map->size - 1) >> MEM_GRANULARITY_BITS);
 }
 
 
 void
 mem_map_set_addr(mem_map_t *map, uint32_t base, uint32_t size)
 {
+    uint32_t seq;
+
     /* Remove old mapping. */
     map->enable = 0;
     mem_map_recalc(map->base, map->size);
@@ -1397,6 +1594,11 @@ mem_map_set_addr(mem_map_t *map, uint32_t base, uint32_t size)
     map->base = base;
     map->size = size;
 
+    /* Move it to its new place in the index. */
+    seq = map_index_del(map);
+    if (seq != (uint32_t)-1)
+	map_index_add(map, seq);
+
     mem_map_recalc(map->base, map->size);
 }
 
@@ -1410,6 +1612,17 @@ mem_map_set_exec(mem_map_t *map, uint8_t *exec)
 }
 
 
+/* Return the mapping that currently handles a physical address. */
+mem_map_t *
+mem_map_get(uint32_t addr, int write)
+{
+    if (write)
+	return(write_mapping[addr >> MEM_GRANULARITY_BITS]);
+
+    return(read_mapping[addr >> MEM_GRANULARITY_BITS]);
+}
+
+
 void
 mem_map_set_p(mem_map_t *map, void *p)
 {
@@ -1551,8 +1764,11 @@ mem_reset(void)
     resetreadlookup();
 
     memset(_mem_exec,    0x00, sizeof(_mem_exec));
+    memset(read_mapping, 0x00, sizeof(read_mapping));
+    memset(write_mapping, 0x00, sizeof(write_mapping));
 
     memset(&base_mapping, 0x00, sizeof(base_mapping));
+    map_count = 0;
 
     memset(_mem_state, 0x00, sizeof(_mem_state));
 
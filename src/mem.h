@@ -8,7 +8,7 @@
  *
  *		Definitions for the memory interface.
  *
- * Version:	@(#)mem.h	1.0.21	2021/03/16
+ * Version:	@(#)mem.h	1.0.23	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Sarah Walker, <tommowalker@tommowalker.co.uk>
@@ -197,6 +197,7 @@ extern uint8_t	*getpccache(uint32_t a);
 extern uint32_t	mmutranslatereal(uint32_t addr, int rw);
 extern void	addreadlookup(uint32_t virt, uint32_t phys);
 extern void	addwritelookup(uint32_t virt, uint32_t phys);
+extern void	addwritelookup_page(uint32_t virt, page_t *p);
 
 
 extern void	mem_map_del(mem_map_t *);
@@ -222,6 +223,7 @@ extern void	mem_map_set_handler(mem_map_t *,
                     void (*write_w)(uint32_t addr, uint16_t val, void *p),
                     void (*write_l)(uint32_t addr, uint32_t val, void *p));
 
+extern mem_map_t *mem_map_get(uint32_t addr, int write);
 extern void	mem_map_set_p(mem_map_t *, void *p);
 extern void	mem_map_set_p2(mem_map_t *, void *p);
 
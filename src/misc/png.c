@@ -8,7 +8,7 @@
  *
  *		Provide centralized access to the PNG image handler.
  *
- * Version:	@(#)png.c	1.0.9	2021/03/18
+ * Version:	@(#)png.c	1.0.11	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -314,7 +314,7 @@ error:
 # else
     PNGFUNC(init_io)(png, fp);
 # endif
-    PNGFUNC(set_compression_level)(png, 9);
+    PNGFUNC(set_compression_level)(png, PNG_LEVEL_DEFAULT);
 
     /* Set other "zlib" parameters. */
     PNGFUNC(set_compression_mem_level)(png, 8);
@@ -362,7 +362,8 @@ error:
 
 /* Write the given BITMAP-format image as an 8-bit RGBA file. */
 int
-png_write_rgb(const wchar_t *fn, int flip, uint8_t *pix, int16_t w, int16_t h)
+png_write_rgb(const wchar_t *fn, int flip, uint8_t *pix, int16_t w, int16_t h,
+	      int level)
 {
     png_structp png = NULL;
     png_infop info = NULL;
@@ -414,7 +415,7 @@ error:
 # else
     PNGFUNC(init_io)(png, fp);
 # endif
-    PNGFUNC(set_compression_level)(png, 9);
+    PNGFUNC(set_compression_level)(png, level);
 
     /* Set other "zlib" parameters. */
     PNGFUNC(set_compression_mem_level)(png, 8);
@@ -489,7 +490,8 @@ error:
 
 /* Write the given BITMAP-format image as an 8-bit color palette file. */
 int
-png_write_pal(const wchar_t *fn, uint8_t *pix, int16_t w, int16_t h, uint16_t pitch, RGB_PAL pal)
+png_write_pal(const wchar_t *fn, uint8_t *pix, int16_t w, int16_t h, uint16_t pitch, RGB_PAL pal,
+	      int level)
 {
     png_color palette[256];
     png_structp png = NULL;
@@ -540,7 +542,7 @@ error:
 # else
     PNGFUNC(init_io)(png, fp);
 # endif
-    PNGFUNC(set_compression_level)(png, 9);
+    PNGFUNC(set_compression_level)(png, level);
 
     /* Set other "zlib" parameters. */
     PNGFUNC(set_compression_mem_level)(png, 8);
@@ -8,7 +8,7 @@
  *
  *		Definitions for the centralized PNG image handler.
  *
- * Version:	@(#)png.h	1.0.4	2021/03/18
+ * Version:	@(#)png.h	1.0.6	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -48,6 +48,9 @@
 # define EMU_PNG_H
 
 
+#define PNG_LEVEL_DEFAULT	9		/* zlib compression level */
+
+
 typedef struct {
     uint8_t     r, g, b;
 } rgb_pal_t;
@@ -66,11 +69,11 @@ extern int	png_write_gray(const wchar_t *path, int invert,
 			       uint8_t *pix, int16_t w, int16_t h);
 
 extern int	png_write_rgb(const wchar_t *fn, int flip, uint8_t *pix,
-			      int16_t w, int16_t h);
+			      int16_t w, int16_t h, int level);
 
 extern int	png_write_pal(const wchar_t *fn, uint8_t *pix,
 			      int16_t w, int16_t h,
-			      uint16_t pitch, RGB_PAL pal);
+			      uint16_t pitch, RGB_PAL pal, int level);
 
 #ifdef __cplusplus
 }
@@ -8,7 +8,7 @@
  *
  *		Main emulator module where most things are controlled.
  *
- * Version:	@(#)pc.c	1.0.85	2021/03/23
+ * Version:	@(#)pc.c	1.0.88	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -110,6 +110,12 @@ int		config_ro = 0;			/* (O) dont modify cfg file */
 int		config_keep_space = 0;		/* (O) keep spaces in cfg */
 int		log_level = LOG_INFO;		/* (O) global logging level */
 wchar_t 	log_path[1024] = { L'\0'};	/* (O) full path of logfile */
+wchar_t		audio_path[1024] = { L'\0'};	/* (O) full path of audio capture */
+wchar_t		grab_path[1024] = { L'\0'};	/* (O) folder for frame capture */
+int		grab_rate = 50;			/* (O) capture every Nth frame */
+int		grab_level = 1;			/* (O) capture PNG compression */
+int		grab_rgb = 0;			/* (O) capture always in RGB */
+wchar_t		vidstats_path[1024] = { L'\0'};	/* (O) file for video statistics */
 
 /* Configuration values. */
 config_t	config;				/* (C) active configuration */
@@ -514,9 +520,14 @@ usage:
 		printf("\nUsage: %ls [options] [cfg-file]\n\n", p);
 		printf("Valid options are:\n\n");
 		printf("  -? or --help         - show this information\n");
+		printf("  -A or --audio path   - capture sound output to WAV file\n");
 		printf("  -C or --dumpcfg      - dump config file after loading\n");
 		printf("  -D or --debug        - force debug logging\n");
 		printf("  -F or --fullscreen   - start in fullscreen mode\n");
+		printf("  -G or --grab path    - save every Nth frame as PNG in folder\n");
+		printf("  --grab_rate N        - set N for --grab (default 50)\n");
+		printf("  --grab_level N       - set PNG compression 0-9 for --grab\n");
+		printf("  --grab_rgb           - do not keep palette for 8-bit modes\n");
 		printf("  -L or --logfile path - set 'path' to be the logfile\n");
 		printf("  -P or --vmpath path  - set 'path' to be root for vm\n");
 		printf("  -q or --quiet        - set logging level to QUIET\n");
@@ -524,10 +535,18 @@ usage:
 		printf("  -R or --fps num      - set render speed to 'num' fps\n");
 #endif
 		printf("  -S or --settings     - show only the settings dialog\n");
+		printf("  -V or --vidstats fn  - write video statistics to file fn\n");
 		printf("  -W or --read_only    - do not modify the config file\n");
 		printf("  -K or --keep_space   - keep whitespace in config file\n");
 		printf("\nA config file can be specified. If none is, the default file will be used.\n");
 		return(ret);
+	} else if (!wcscasecmp(argv[c], L"--audio") ||
+		   !wcscasecmp(argv[c], L"-A")) {
+		if ((c+1) == argc) {
+			ret = -1;
+			goto usage;
+		}
+		wcscpy(audio_path, argv[++c]);
 	} else if (!wcscasecmp(argv[c], L"--dumpcfg") ||
 		   !wcscasecmp(argv[c], L"-C")) {
 		do_dump_config = 1;
@@ -540,6 +559,27 @@ usage:
 	} else if (!wcscasecmp(argv[c], L"--fullscreen") ||
 		   !wcscasecmp(argv[c], L"-F")) {
 		start_in_fullscreen = 1;
+	} else if (!wcscasecmp(argv[c], L"--grab") ||
+		   !wcscasecmp(argv[c], L"-G")) {
+		if ((c+1) == argc) {
+			ret = -1;
+			goto usage;
+		}
+		wcscpy(grab_path, argv[++c]);
+	} else if (!wcscasecmp(argv[c], L"--grab_rate")) {
+		if ((c+1) == argc) {
+			ret = -1;
+			goto usage;
+		}
+		grab_rate = wcstol(argv[++c], NULL, 10);
+	} else if (!wcscasecmp(argv[c], L"--grab_level")) {
+		if ((c+1) == argc) {
+			ret = -1;
+			goto usage;
+		}
+		grab_level = wcstol(argv[++c], NULL, 10);
+	} else if (!wcscasecmp(argv[c], L"--grab_rgb")) {
+		grab_rgb = 1;
 	} else if (!wcscasecmp(argv[c], L"--logfile") ||
 		   !wcscasecmp(argv[c], L"-L")) {
 		if ((c+1) == argc) {
@@ -569,6 +609,13 @@ usage:
 	} else if (!wcscasecmp(argv[c], L"--settings") ||
 		   !wcscasecmp(argv[c], L"-S")) {
 		settings_only = 1;
+	} else if (!wcscasecmp(argv[c], L"--vidstats") ||
+		   !wcscasecmp(argv[c], L"-V")) {
+		if ((c+1) == argc) {
+			ret = -1;
+			goto usage;
+		}
+		wcscpy(vidstats_path, argv[++c]);
 	} else if (!wcscasecmp(argv[c], L"--read_only") ||
 		   !wcscasecmp(argv[c], L"-W")) {
 		config_ro = 1;
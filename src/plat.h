@@ -8,7 +8,7 @@
  *
  *		Define the various platform support functions.
  *
- * Version:	@(#)plat.h	1.0.27	2021/02/13
+ * Version:	@(#)plat.h	1.0.30	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -128,6 +128,7 @@ typedef struct {
     void	(*enable)(int yes);
     void	(*screenshot)(const wchar_t *fn);
     int		(*is_available)(void);
+    int		(*is_watched)(void);
 } vidapi_t;
 
 
@@ -143,6 +144,8 @@ extern void	plat_console(int on);
 extern wchar_t	*fix_emu_path(const wchar_t *str);
 extern FILE	*plat_fopen(const wchar_t *path, const wchar_t *mode);
 extern FILE	*plat_fopen64(const wchar_t *path, const wchar_t *mode);
+extern int	plat_fsparse(FILE *fp);
+extern int	plat_fpunch(FILE *fp, uint64_t offset, uint64_t len);
 extern void	plat_remove(const wchar_t *path);
 extern int	plat_getcwd(wchar_t *bufp, int max);
 extern int	plat_chdir(const wchar_t *path);
@@ -158,6 +161,7 @@ extern int	plat_path_abs(const wchar_t *path);
 extern int	plat_dir_check(const wchar_t *path);
 extern int	plat_dir_create(const wchar_t *path);
 extern uint64_t	plat_timer_read(void);
+extern uint64_t	plat_timer_freq(void);
 extern uint32_t	plat_timer_ms(void);
 extern void	plat_delay_ms(uint32_t count);
 extern void	plat_blitter(int own);
@@ -8,7 +8,7 @@
  *
  *		Define the various UI functions.
  *
- * Version:	@(#)ui.h	1.0.19	2021/02/18
+ * Version:	@(#)ui.h	1.0.20	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -206,6 +206,7 @@ extern const char *vidapi_getname(int api);
 extern int	vidapi_set(int api);
 extern void	vidapi_resize(int x, int y);
 extern int	vidapi_pause(void);
+extern int	vidapi_watched(void);
 extern void	vidapi_enable(int yes);
 extern void	vidapi_reset(void);
 extern void	vidapi_screenshot(void);
@@ -11,7 +11,7 @@
  *		This code is called by the UI frontend modules, and, also,
  *		depends on those same modules for lower-level functions.
  *
- * Version:	@(#)ui_main.c	1.0.27	2021/05/15
+ * Version:	@(#)ui_main.c	1.0.28	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -58,6 +58,7 @@
 #include "../plat.h"
 #include "../devices/input/keyboard.h"
 #include "../devices/input/mouse.h"
+#include "../devices/sound/sound.h"
 #include "../devices/video/video.h"
 #include "ui.h"
 
@@ -551,6 +552,7 @@ ui_menu_command(int idm)
 #ifdef _LOGGING
 	case IDM_LOG_BREAKPOINT:		// TOOLS menu
 		pclog(LOG_ALWAYS, "---- LOG BREAKPOINT ----\n");
+		sound_stats_dump();
 		break;
 
 	case IDM_LOG_BEGIN:			// TOOLS menu
@@ -0,0 +1,343 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Implement a renderer that publishes the screen in shared
+ *		memory, for use by external recorders and test tools.
+ *
+ *		Every frame is copied once, into the oldest of the frame
+ *		buffers, after which it is marked as the latest one. See
+ *		ui_shm.h for the layout and for how to read it safely.
+ *
+ * Version:	@(#)ui_shm.c	1.0.3	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "../emu.h"
+#include "../config.h"
+#include "../plat.h"
+#include "../ui/ui.h"
+#if USE_LIBPNG
+# include "../misc/png.h"
+#endif
+#include "../devices/video/video.h"
+#include "ui_shm.h"
+
+
+#define SHM_PAGE	4096
+
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+# define SHM_FENCE()	_mm_mfence()
+#else
+# define SHM_FENCE()	__sync_synchronize()
+#endif
+
+
+#ifdef _WIN32
+static HANDLE		shm_handle = NULL;
+#else
+static char		shm_name[64];
+static size_t		shm_len;
+#endif
+static shm_header_t	*shm_hdr = NULL;
+static uint8_t		*shm_data;		// first frame buffer
+static uint32_t		shm_seq;		// last frame number used
+
+
+static uint32_t *
+shm_line(int buf, int y)
+{
+    return((uint32_t *)(shm_data + ((size_t)buf * shm_hdr->size) +
+			((size_t)y * shm_hdr->stride)));
+}
+
+
+/*
+ * Publish a frame.
+ *
+ * The whole frame goes into the oldest buffer, as that one may be
+ * several frames behind. While doing that, we compare each line with
+ * the latest frame, so readers can tell which lines changed.
+ */
+static void
+shm_blit(bitmap_t *scr, int x, int y, UNUSED(int y1), UNUSED(int y2),
+	 int w, int h)
+{
+    shm_frame_t *f, *prev;
+    uint32_t *p, *q;
+    int b, yy, top, bot;
+
+    if (shm_hdr == NULL) {
+	video_blit_done();
+	return;
+    }
+
+    if (w > SHM_MAX_X) w = SHM_MAX_X;
+    if (h > SHM_MAX_Y) h = SHM_MAX_Y;
+    if (w < 0) w = 0;
+    if (h < 0) h = 0;
+
+    prev = &shm_hdr->frame[shm_hdr->latest];
+    b = (shm_hdr->latest + 1) % SHM_BUFS;
+    f = &shm_hdr->frame[b];
+
+    /* Tell readers this buffer is being changed. */
+    f->seq = 0;
+    SHM_FENCE();
+
+    top = h;
+    bot = 0;
+    for (yy = 0; yy < h; yy++) {
+	p = shm_line(b, yy);
+	q = shm_line(shm_hdr->latest, yy);
+
+	if (config.vid_grayscale || config.invert_display)
+		video_transform_copy(p, &scr->line[y+yy][x], w);
+	else
+		memcpy(p, &scr->line[y+yy][x], w * 4);
+
+	if (memcmp(p, q, w * 4)) {
+		if (yy < top)
+			top = yy;
+		bot = yy + 1;
+	}
+    }
+
+    video_blit_done();
+
+    /* A new size means everything changed. */
+    if (prev->w != (uint32_t)w || prev->h != (uint32_t)h) {
+	top = 0;
+	bot = h;
+    }
+
+    f->w = w;
+    f->h = h;
+    f->dirty_y1 = (top < bot) ? top : 0;
+    f->dirty_y2 = (top < bot) ? bot : 0;
+
+    if (++shm_seq == 0)
+	shm_seq++;
+
+    /* Make sure all of the frame is out before we publish it. */
+    SHM_FENCE();
+    f->seq = shm_seq;
+    shm_hdr->latest = b;
+    shm_hdr->seq = shm_seq;
+}
+
+
+static void
+shm_close(void)
+{
+    video_blit_set(NULL);
+
+    if (shm_hdr == NULL) return;
+
+    shm_hdr->magic = 0;
+
+#ifdef _WIN32
+    UnmapViewOfFile(shm_hdr);
+    CloseHandle(shm_handle);
+    shm_handle = NULL;
+#else
+    munmap(shm_hdr, shm_len);
+    shm_unlink(shm_name);
+#endif
+
+    shm_hdr = NULL;
+    shm_data = NULL;
+}
+
+
+static int
+shm_init(UNUSED(int fs))
+{
+    uint32_t stride, size, offset;
+    size_t total;
+#ifdef _WIN32
+    wchar_t name[64];
+#else
+    int fd;
+#endif
+
+    stride = SHM_MAX_X * 4;
+    size = stride * SHM_MAX_Y;
+    offset = (sizeof(shm_header_t) + SHM_PAGE - 1) & ~(SHM_PAGE - 1);
+    total = offset + ((size_t)size * SHM_BUFS);
+
+#ifdef _WIN32
+    swprintf(name, sizeof_w(name), L"VARCem.Screen.%lu",
+	     (unsigned long)GetCurrentProcessId());
+
+    shm_handle = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL,
+				    PAGE_READWRITE, 0, (DWORD)total, name);
+    if (shm_handle == NULL) {
+	ERRLOG("SHM: unable to create '%ls' (%lu)\n",
+	       name, (unsigned long)GetLastError());
+	return(0);
+    }
+
+    shm_hdr = (shm_header_t *)MapViewOfFile(shm_handle, FILE_MAP_ALL_ACCESS,
+					    0, 0, total);
+    if (shm_hdr == NULL) {
+	ERRLOG("SHM: unable to map '%ls' (%lu)\n",
+	       name, (unsigned long)GetLastError());
+	CloseHandle(shm_handle);
+	shm_handle = NULL;
+	return(0);
+    }
+
+    INFO("SHM: screen is in '%ls', %lu bytes\n", name, (unsigned long)total);
+#else
+    sprintf(shm_name, "/varcem-screen-%lu", (unsigned long)getpid());
+
+    fd = shm_open(shm_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+	ERRLOG("SHM: unable to create '%s'\n", shm_name);
+	return(0);
+    }
+    if (ftruncate(fd, total) < 0) {
+	ERRLOG("SHM: unable to size '%s'\n", shm_name);
+	close(fd);
+	shm_unlink(shm_name);
+	return(0);
+    }
+
+    shm_hdr = (shm_header_t *)mmap(NULL, total, PROT_READ | PROT_WRITE,
+				   MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm_hdr == MAP_FAILED) {
+	ERRLOG("SHM: unable to map '%s'\n", shm_name);
+	shm_hdr = NULL;
+	shm_unlink(shm_name);
+	return(0);
+    }
+    shm_len = total;
+
+    INFO("SHM: screen is in '%s', %lu bytes\n", shm_name, (unsigned long)total);
+#endif
+
+    memset(shm_hdr, 0x00, sizeof(shm_header_t));
+    shm_hdr->version = SHM_VERSION;
+    shm_hdr->bufs = SHM_BUFS;
+    shm_hdr->max_w = SHM_MAX_X;
+    shm_hdr->max_h = SHM_MAX_Y;
+    shm_hdr->stride = stride;
+    shm_hdr->offset = offset;
+    shm_hdr->size = size;
+    shm_data = (uint8_t *)shm_hdr + offset;
+    shm_seq = 0;
+
+    /* Only now is it ready for readers. */
+    SHM_FENCE();
+    shm_hdr->magic = SHM_MAGIC;
+
+    video_blit_set(shm_blit);
+
+    return(1);
+}
+
+
+/* Save the latest frame. */
+static void
+shm_screenshot(const wchar_t *fn)
+{
+#if USE_LIBPNG
+    shm_frame_t *f;
+    uint8_t *pix;
+    int b, w, h, yy;
+
+    if (shm_hdr == NULL || shm_seq == 0) return;
+
+    b = shm_hdr->latest;
+    f = &shm_hdr->frame[b];
+    w = f->w;
+    h = f->h;
+    if (w == 0 || h == 0) return;
+
+    /* The PNG writer wants the lines bottom-up. */
+    pix = (uint8_t *)mem_alloc((size_t)w * h * 4);
+    for (yy = 0; yy < h; yy++)
+	memcpy(pix + ((size_t)(h - 1 - yy) * w * 4), shm_line(b, yy), w * 4);
+
+    (void)png_write_rgb(fn, 1, pix, (int16_t)w, (int16_t)h,
+			PNG_LEVEL_DEFAULT);
+
+    free(pix);
+#else
+    DEBUG("SHM: no screenshots without PNG support\n");
+#endif
+}
+
+
+static int
+shm_available(void)
+{
+    return(1);
+}
+
+
+const vidapi_t shm_vidapi = {
+    "shm",
+    "Shared Memory",
+    0,
+    shm_init, shm_close, NULL,
+    NULL,
+    NULL,
+    NULL,
+    shm_screenshot,
+    shm_available
+};
@@ -0,0 +1,107 @@
+/*
+ * VARCem	Virtual ARchaeological Computer EMulator.
+ *		An emulator of (mostly) x86-based PC systems and devices,
+ *		using the ISA,EISA,VLB,MCA  and PCI system buses, roughly
+ *		spanning the era between 1981 and 1995.
+ *
+ *		This file is part of the VARCem Project.
+ *
+ *		Definitions for the shared memory renderer.
+ *
+ *		The shared memory starts with a shm_header_t, followed by
+ *		SHM_BUFS frame buffers of max_h lines of stride bytes,
+ *		the first one at 'offset'. Pixels are 32 bits, 0x00RRGGBB.
+ *
+ *		To read the newest frame, a consumer takes 'latest', and
+ *		the 'seq' of that buffer; if it is zero, the buffer is
+ *		being written and it should try again. After using the
+ *		pixels, it checks that 'seq' did not change; if it did,
+ *		the frame was overwritten while reading it. Frames are
+ *		written round-robin, so a reader normally has two frame
+ *		times to finish.
+ *
+ * Version:	@(#)ui_shm.h	1.0.2	2026/10/19
+ *
+ * Author:	agent, <agent@local>
+ *
+ *		Copyright 2026 agent.
+ *
+ *		Redistribution and  use  in source  and binary forms, with
+ *		or  without modification, are permitted  provided that the
+ *		following conditions are met:
+ *
+ *		1. Redistributions of  source  code must retain the entire
+ *		   above notice, this list of conditions and the following
+ *		   disclaimer.
+ *
+ *		2. Redistributions in binary form must reproduce the above
+ *		   copyright  notice,  this list  of  conditions  and  the
+ *		   following disclaimer in  the documentation and/or other
+ *		   materials provided with the distribution.
+ *
+ *		3. Neither the  name of the copyright holder nor the names
+ *		   of  its  contributors may be used to endorse or promote
+ *		   products  derived from  this  software without specific
+ *		   prior written permission.
+ *
+ * THIS SOFTWARE  IS  PROVIDED BY THE  COPYRIGHT  HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND  ANY EXPRESS  OR  IMPLIED  WARRANTIES,  INCLUDING, BUT  NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE  ARE  DISCLAIMED. IN  NO  EVENT  SHALL THE COPYRIGHT
+ * HOLDER OR  CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL,  EXEMPLARY,  OR  CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE  GOODS OR SERVICES;  LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON  ANY
+ * THEORY OF  LIABILITY, WHETHER IN  CONTRACT, STRICT  LIABILITY, OR  TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING  IN ANY  WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef EMU_UI_SHM_H
+# define EMU_UI_SHM_H
+
+
+#define SHM_MAGIC	0x4d485356		/* "VSHM" */
+#define SHM_VERSION	1
+#define SHM_BUFS	3
+#define SHM_MAX_X	2048
+#define SHM_MAX_Y	2048
+
+
+/* Information about the frame in one buffer. */
+typedef struct {
+    volatile uint32_t seq;			/* frame number, 0 if busy */
+    uint32_t	w, h;				/* size of the frame */
+    uint32_t	dirty_y1,			/* lines changed since the */
+		dirty_y2;			/*  previous frame */
+    uint32_t	pad[3];
+} shm_frame_t;
+
+/* What is at the start of the shared memory. */
+typedef struct {
+    uint32_t	magic,
+		version;
+    uint32_t	bufs;				/* number of buffers */
+    uint32_t	max_w, max_h;
+    uint32_t	stride;				/* bytes per line */
+    uint32_t	offset;				/* offset of first buffer */
+    uint32_t	size;				/* bytes per buffer */
+    volatile uint32_t seq;			/* newest frame number */
+    volatile uint32_t latest;			/* buffer that holds it */
+    uint32_t	pad[6];
+
+    shm_frame_t	frame[SHM_BUFS];
+} shm_header_t;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const vidapi_t	shm_vidapi;
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif	/*EMU_UI_SHM_H*/
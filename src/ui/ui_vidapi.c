@@ -8,7 +8,7 @@
  *
  *		Handle the various video renderer modules.
  *
- * Version:	@(#)ui_vidapi.c	1.0.10	2021/02/18
+ * Version:	@(#)ui_vidapi.c	1.0.11	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *
@@ -176,6 +176,17 @@ vidapi_pause(void)
 }
 
 
+/* Is anyone looking at the screen? */
+int
+vidapi_watched(void)
+{
+    /* If not defined, assume someone is. */
+    if (plat_vidapis[config.vid_api]->is_watched == NULL) return(1);
+
+    return(plat_vidapis[config.vid_api]->is_watched());
+}
+
+
 void
 vidapi_enable(int yes)
 {
@@ -10,7 +10,7 @@
  *
  * TODO:	Implement screenshots, and Audio Redirection.
  *
- * Version:	@(#)ui_vnc.c	1.0.15	2021/03/24
+ * Version:	@(#)ui_vnc.c	1.0.17	2026/10/19
  *
  * Author:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Based on raw code by RichardG, <richardg867@gmail.com>
@@ -77,6 +77,12 @@
 #define VNC_MIN_Y	200
 #define VNC_MAX_Y	2048
 
+#define VNC_TILE	32			// change tracking granularity
+#define VNC_TILES_X	(VNC_MAX_X / VNC_TILE)
+#define VNC_SCROLL_MIN	64			// smallest blit we check
+#define VNC_SCROLL_MAX	512			// largest scroll we look for
+#define VNC_PROBES	8			// lines tried per blit
+
 
 #if USE_VNC == 1
 # define FUNC(x)	rfb##x
@@ -102,6 +108,8 @@ static rfbClientIteratorPtr (*rfb_GetClientIterator)(rfbScreenInfoPtr);
 static rfbClientPtr	(*rfb_ClientIteratorNext)(rfbClientIteratorPtr);
 static void		(*rfb_MarkRectAsModified)(rfbScreenInfoPtr,
 						  int,int,int,int);
+static void		(*rfb_DoCopyRect)(rfbScreenInfoPtr,
+					  int,int,int,int,int,int);
 static void		(*rfb_DefaultPtrAddEvent)(int,int,int,rfbClientPtr);
 #if 0
 static void		(*rfb_ClientLock)(rfbClientPtr);
@@ -121,6 +129,7 @@ static const dllimp_t imports[] = {
   { "rfbGetClientIterator",		&rfb_GetClientIterator		},
   { "rfbClientIteratorNext",		&rfb_ClientIteratorNext		},
   { "rfbMarkRectAsModified",		&rfb_MarkRectAsModified		},
+  { "rfbDoCopyRect",			&rfb_DoCopyRect			},
   { "rfbDefaultPtrAddEvent",		&rfb_DefaultPtrAddEvent		},
 #if 0
   { "rfbClientLock",			&rfb_ClientLock			},
@@ -140,6 +149,11 @@ static int		updatingSize;
 static int		allowedX,
 			allowedY;
 static int		ptr_x, ptr_y, ptr_but;
+static int		need_full;
+static uint32_t		*line_hash = NULL,	// hash of each line we have
+			*new_hash = NULL;	// hash of each line blitted
+static uint32_t		line_tmp[VNC_MAX_X];
+static uint8_t		tile_dirty[VNC_TILES_X];
 
 
 /* Local handlers for VNCserver event logging. */
@@ -266,29 +280,148 @@ vnc_display(rfbClientPtr cl)
 }
 
 
+static uint32_t
+vnc_hash(const uint32_t *p, int w)
+{
+    uint32_t hash = 2166136261UL;
+
+    while (w--)
+	hash = (hash ^ *p++) * 16777619UL;
+
+    return(hash);
+}
+
+
+/*
+ * See if (part of) the screen was scrolled vertically.
+ *
+ * We take a few changed lines from the new frame, and look for them in
+ * the frame we already have. If one is found, we grow the band of lines
+ * that moved by that same distance, and if it is large enough, have the
+ * server move it with a CopyRect. Whatever is not quite right after the
+ * move will be picked up by the normal tile compare later on.
+ */
+static void
+vnc_scroll(int y1, int y2, int w)
+{
+    int probe, yy, i, lo, hi, dy, top, bot;
+
+    for (probe = 0; probe < VNC_PROBES; probe++) {
+	yy = y1 + (((y2 - y1) * ((2 * probe) + 1)) / (2 * VNC_PROBES));
+
+	/* We need a line that changed, and is unlike its neighbor. */
+	if (new_hash[yy] == line_hash[yy]) continue;
+	if (new_hash[yy] == new_hash[yy - 1]) continue;
+
+	lo = (yy - VNC_SCROLL_MAX < y1) ? y1 : yy - VNC_SCROLL_MAX;
+	hi = (yy + VNC_SCROLL_MAX > y2) ? y2 : yy + VNC_SCROLL_MAX;
+	for (i = lo; i < hi; i++) {
+		if (line_hash[i] == new_hash[yy]) break;
+	}
+	if (i == hi) continue;
+
+	/* New line 'n' now is the old line 'n - dy'. */
+	dy = yy - i;
+
+	top = yy;
+	while ((top > y1) && ((top - 1 - dy) >= y1) && ((top - 1 - dy) < y2) &&
+	       (new_hash[top - 1] == line_hash[top - 1 - dy])) top--;
+	bot = yy + 1;
+	while ((bot < y2) && ((bot - dy) >= y1) && ((bot - dy) < y2) &&
+	       (new_hash[bot] == line_hash[bot - dy])) bot++;
+
+	if ((bot - top) < ((y2 - y1) / 4)) continue;
+
+	FUNC(DoCopyRect)(rfb, 0, top, w, bot, 0, dy);
+	memmove(&line_hash[top], &line_hash[top - dy],
+		(bot - top) * sizeof(uint32_t));
+	return;
+    }
+}
+
+
+/* Mark the runs of changed tiles in one row of tiles. */
+static void
+vnc_mark(int top, int bot, int w)
+{
+    int tx, start;
+
+    for (tx = 0; tx < VNC_TILES_X; tx++) {
+	if (! tile_dirty[tx]) continue;
+
+	start = tx;
+	while ((tx < VNC_TILES_X) && tile_dirty[tx])
+		tile_dirty[tx++] = 0;
+
+	FUNC(MarkRectAsModified)(rfb, start * VNC_TILE, top,
+				 (tx * VNC_TILE < w) ? tx * VNC_TILE : w, bot);
+    }
+}
+
+
+/*
+ * Update our framebuffer, and tell the server what changed.
+ *
+ * The framebuffer still holds the previous frame, so we compare each
+ * line against it in tiles, and only copy and mark tiles that differ.
+ */
 static void
 vnc_blit(bitmap_t *scr, int x, int y, int y1, int y2, int w, int h)
 {
-    uint32_t *p;
-    int yy;
+    uint32_t *p, *src;
+    int yy, tx, x0, n, top;
 
 //INFO("VNC: blit(%i,%i, %i,%i, %i,%i)\n", x,y, y1,y2, w,h);
 
+    /* Clip to the lines we actually have. */
+    if (y1 < -y) y1 = -y;
+    if (y2 > (VNC_MAX_Y - y)) y2 = VNC_MAX_Y - y;
+
+    for (yy = y1; yy < y2; yy++)
+	new_hash[yy] = vnc_hash((uint32_t *)&scr->line[y+yy][x], w);
+
+    if (! updatingSize && ((y2 - y1) >= VNC_SCROLL_MIN))
+	vnc_scroll(y1, y2, w);
+
+    top = y1;
     for (yy = y1; yy < y2; yy++) {
 	p = (uint32_t *)&(((uint32_t *)rfb->frameBuffer)[yy*VNC_MAX_X]);
 
-	if ((y+yy) >= 0 && (y+yy) < VNC_MAX_Y) {
-		if (config.vid_grayscale || config.invert_display)
-			video_transform_copy(p, &scr->line[y+yy][x], w);
-		  else
-			memcpy(p, &scr->line[y+yy][x], w*4);
+	if (config.vid_grayscale || config.invert_display) {
+		video_transform_copy(line_tmp, &scr->line[y+yy][x], w);
+		src = line_tmp;
+	} else
+		src = (uint32_t *)&scr->line[y+yy][x];
+
+	for (tx = 0, x0 = 0; x0 < w; tx++, x0 += VNC_TILE) {
+		n = (w - x0 < VNC_TILE) ? w - x0 : VNC_TILE;
+		if (memcmp(&p[x0], &src[x0], n * 4)) {
+			memcpy(&p[x0], &src[x0], n * 4);
+			tile_dirty[tx] = 1;
+		}
+	}
+
+	line_hash[yy] = new_hash[yy];
+
+	/* End of a tile row, or of the blit? */
+	if (((yy + 1) % VNC_TILE) == 0 || (yy + 1) == y2) {
+		if (! updatingSize)
+			vnc_mark(top, yy + 1, w);
+		else
+			memset(tile_dirty, 0x00, sizeof(tile_dirty));
+		top = yy + 1;
 	}
     }
  
     video_blit_done();
 
-    if (! updatingSize)
+    /* Changes made during a resize were not marked, so send it all. */
+    if (updatingSize)
+	need_full = 1;
+    else if (need_full) {
 	FUNC(MarkRectAsModified)(rfb, 0,0, allowedX,allowedY);
+	need_full = 0;
+    }
 }
 
 
@@ -299,6 +432,10 @@ vnc_close(void)
 
     if (rfb != NULL) {
 	free(rfb->frameBuffer);
+	free(line_hash);
+	line_hash = NULL;
+	free(new_hash);
+	new_hash = NULL;
 
 	FUNC(ScreenCleanup)(rfb);
 
@@ -382,6 +519,11 @@ vnc_init(int fs)
 	rfb = FUNC(GetScreen)(0, NULL, VNC_MAX_X, VNC_MAX_Y, 8, 3, 4);
 	rfb->desktopName = title;
 	rfb->frameBuffer = (char *)mem_alloc(VNC_MAX_X*VNC_MAX_Y*4);
+	memset(rfb->frameBuffer, 0x00, VNC_MAX_X*VNC_MAX_Y*4);
+	line_hash = (uint32_t *)mem_alloc(VNC_MAX_Y*sizeof(uint32_t));
+	memset(line_hash, 0x00, VNC_MAX_Y*sizeof(uint32_t));
+	new_hash = (uint32_t *)mem_alloc(VNC_MAX_Y*sizeof(uint32_t));
+	need_full = 1;
 
 	rfb->serverFormat = rpf;
 	rfb->alwaysShared = TRUE;
@@ -482,6 +624,13 @@ vnc_available(void)
 }
 
 
+static int
+vnc_watched(void)
+{
+    return(clients > 0);
+}
+
+
 const vidapi_t vnc_vidapi = {
     "vnc",
     "VNC",
@@ -491,7 +640,8 @@ const vidapi_t vnc_vidapi = {
     vnc_pause,
     NULL,
     vnc_screenshot,
-    vnc_available
+    vnc_available,
+    vnc_watched
 };
 
 
@@ -8,7 +8,7 @@
  *
  *		Platform main support module for Windows.
  *
- * Version:	@(#)win.c	1.0.35	2021/02/18
+ * Version:	@(#)win.c	1.0.38	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -39,9 +39,8 @@
 #define UNICODE
 #define _WIN32_WINNT 0x0501
 #include <windows.h>
-#ifdef _MSC_VER
-# include <io.h>			/* for _open_osfhandle() */
-#endif
+#include <winioctl.h>
+#include <io.h>				/* for _open_osfhandle() */
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -61,6 +60,7 @@
 #ifdef USE_VNC
 # include "../ui/ui_vnc.h"
 #endif
+#include "../ui/ui_shm.h"
 #ifdef USE_RDP
 # include <rdp.h>
 #endif
@@ -104,6 +104,8 @@ const vidapi_t *plat_vidapis[] = {
     &rdp_vidapi,
 #endif
 
+    &shm_vidapi,
+
     NULL
 };
 
@@ -406,6 +408,54 @@ plat_fopen64(const wchar_t *path, const wchar_t *mode)
 }
 
 
+/* Mark an open file as sparse, so unwritten areas take no space. */
+int
+plat_fsparse(FILE *fp)
+{
+    HANDLE h;
+    DWORD n;
+
+    fflush(fp);
+
+    h = (HANDLE)_get_osfhandle(_fileno(fp));
+    if (h == INVALID_HANDLE_VALUE)
+	return(0);
+
+    if (! DeviceIoControl(h, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &n, NULL))
+	return(0);
+
+    return(1);
+}
+
+
+/*
+ * Release the disk space used by a range of an open (sparse)
+ * file. The range will read back as all zeroes.
+ */
+int
+plat_fpunch(FILE *fp, uint64_t offset, uint64_t len)
+{
+    FILE_ZERO_DATA_INFORMATION zd;
+    HANDLE h;
+    DWORD n;
+
+    /* Make sure nothing is left in the stdio buffers. */
+    fflush(fp);
+
+    h = (HANDLE)_get_osfhandle(_fileno(fp));
+    if (h == INVALID_HANDLE_VALUE)
+	return(0);
+
+    zd.FileOffset.QuadPart = (LONGLONG)offset;
+    zd.BeyondFinalZero.QuadPart = (LONGLONG)(offset + len);
+    if (! DeviceIoControl(h, FSCTL_SET_ZERO_DATA,
+			  &zd, sizeof(zd), NULL, 0, &n, NULL))
+	return(0);
+
+    return(1);
+}
+
+
 void
 plat_remove(const wchar_t *path)
 {
@@ -547,6 +597,18 @@ plat_timer_read(void)
 }
 
 
+/* Return the number of plat_timer_read() ticks per second. */
+uint64_t
+plat_timer_freq(void)
+{
+    LARGE_INTEGER li;
+
+    QueryPerformanceFrequency(&li);
+
+    return(li.QuadPart);
+}
+
+
 uint32_t
 plat_timer_ms(void)
 {
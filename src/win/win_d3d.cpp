@@ -8,7 +8,7 @@
  *
  *		Rendering module for Microsoft Direct3D 9.
  *
- * Version:	@(#)win_d3d.cpp	1.0.21	2021/03/18
+ * Version:	@(#)win_d3d.cpp	1.0.22	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -696,7 +696,8 @@ d3d_screenshot(const wchar_t *fn)
 
 #if USE_LIBPNG
     i = png_write_rgb(fn, 0, pixels,
-		      (int16_t)desc.Width, (int16_t)desc.Height);
+		      (int16_t)desc.Width, (int16_t)desc.Height,
+		      PNG_LEVEL_DEFAULT);
 
     /* Show error message if needed. */
     if (i == 0) {
@@ -8,7 +8,7 @@
  *
  *		Rendering module for Microsoft DirectDraw 9.
  *
- * Version:	@(#)win_ddraw.cpp	1.0.24	2021/03/18
+ * Version:	@(#)win_ddraw.cpp	1.0.25	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -730,7 +730,8 @@ ddraw_screenshot(const wchar_t *fn)
     /* Save the screenshot, using PNG if available. */
     i = png_write_rgb(path, 1, pixels,
 		      (int16_t)bmi.bmiHeader.biWidth,
-		      (int16_t)abs(bmi.bmiHeader.biHeight));
+		      (int16_t)abs(bmi.bmiHeader.biHeight),
+		      PNG_LEVEL_DEFAULT);
     if (i == 0) {
 #endif
 	/* Use BMP, so fix the file name. */
@@ -12,7 +12,7 @@
  *		we will not use that, but, instead, use a new window which
  *		coverrs the entire desktop.
  *
- * Version:	@(#)win_sdl.c  	1.0.13	2021/03/18
+ * Version:	@(#)win_sdl.c  	1.0.14	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Michael Dring, <michael@drueing.de>
@@ -499,7 +499,8 @@ sdl_screenshot(const wchar_t *fn)
 
 #ifdef USE_LIBPNG
     /* Save the screenshot, using PNG. */
-    i = png_write_rgb(fn, 0, pixels, (int16_t)width, (int16_t)height);
+    i = png_write_rgb(fn, 0, pixels, (int16_t)width, (int16_t)height,
+		      PNG_LEVEL_DEFAULT);
 #endif
 
     if (pixels)
@@ -8,7 +8,7 @@
  *
  *		Implementation of the Settings dialog.
  *
- * Version:	@(#)win_settings_disk.h	1.0.23	2021/03/22
+ * Version:	@(#)win_settings_disk.h	1.0.24	2026/10/19
  *
  * Authors:	Fred N. van Kempen, <decwiz@yahoo.com>
  *		Miran Grca, <mgrca8@gmail.com>
@@ -1383,6 +1383,13 @@ disk_add_proc(HWND hdlg, UINT message, WPARAM wParam, LPARAM lParam)
 					r >>= 11;
 					INFO(" = %i blocks (+%i sectors)\n", size, r);
 
+					/* On a sparse file, setting the size is all it takes. */
+					if ((size || r) && plat_fsparse(f)) {
+						fseeko64(f, ((int64_t)size << 9) + ((int64_t)r << 20) - 1, SEEK_CUR);
+						fputc(0x00, f);
+						size = r = 0;
+					}
+
 					if (size || r) {
 						/* Hide filename controls. */
 						h = GetDlgItem(hdlg, IDT_1731);